@@ -116,7 +116,39 @@ typedef enum {
 	FUNCTION_GET_CUSTOM_PROGRAM_OPTION_VALUE,
 	FUNCTION_REMOVE_CUSTOM_PROGRAM_OPTION,
 	CALLBACK_PROGRAM_SCHEDULER_STATE_CHANGED,
-	CALLBACK_PROGRAM_PROCESS_SPAWNED
+	CALLBACK_PROGRAM_PROCESS_SPAWNED,
+
+	FUNCTION_EXPIRE_SESSION_OBJECTS,
+	FUNCTION_RELEASE_OBJECTS,
+	FUNCTION_READ_STRING_FROM_FILE,
+	FUNCTION_WRITE_STRING_TO_FILE,
+	FUNCTION_READ_STRING_ASYNC,
+	CALLBACK_ASYNC_STRING_READ,
+	FUNCTION_SPLIT_STRING,
+	FUNCTION_GET_LIST_ITEMS,
+	FUNCTION_APPEND_MULTIPLE_TO_LIST,
+	FUNCTION_READ_FILE_ASYNC_WITH_CREDIT,
+	FUNCTION_GRANT_ASYNC_FILE_READ_CREDIT,
+	FUNCTION_GET_FILE_CHECKSUM,
+	CALLBACK_ASYNC_FILE_CHECKSUM,
+	FUNCTION_COPY_FILE,
+	CALLBACK_ASYNC_FILE_COPIED,
+	FUNCTION_GET_FILE_SIGNATURES,
+	CALLBACK_ASYNC_FILE_SIGNATURE,
+	FUNCTION_APPLY_FILE_DELTA,
+	CALLBACK_ASYNC_FILE_DELTA_APPLIED,
+	FUNCTION_FOLLOW_FILE_ASYNC,
+	FUNCTION_READ_FILE_AT,
+	FUNCTION_WRITE_FILE_AT,
+	FUNCTION_WRITE_FILE_AT_UNCHECKED,
+	FUNCTION_EXTRACT_ARCHIVE,
+	FUNCTION_CREATE_ARCHIVE,
+	FUNCTION_GET_DIRECTORY_ENTRIES,
+	FUNCTION_WALK_DIRECTORY,
+	FUNCTION_REMOVE_PATH,
+	CALLBACK_ASYNC_PATH_REMOVAL,
+	FUNCTION_GET_DISK_USAGE,
+	CALLBACK_ASYNC_DISK_USAGE
 } APIFunctionID;
 
 static uint32_t _uid = 0; // always little endian
@@ -126,6 +158,13 @@ static FileEventsOccurredCallback _file_events_occurred_callback;
 static ProcessStateChangedCallback _process_state_changed_callback;
 static ProgramSchedulerStateChangedCallback _program_scheduler_state_changed_callback;
 static ProgramProcessSpawnedCallback _program_process_spawned_callback;
+static AsyncStringReadCallback _async_string_read_callback;
+static AsyncFileChecksumCallback _async_file_checksum_callback;
+static AsyncFileCopiedCallback _async_file_copied_callback;
+static AsyncFileSignatureCallback _async_file_signature_callback;
+static AsyncFileDeltaAppliedCallback _async_file_delta_applied_callback;
+static AsyncPathRemovalCallback _async_path_removal_callback;
+static AsyncDiskUsageCallback _async_disk_usage_callback;
 
 static void api_prepare_response(Packet *request, Packet *response, uint8_t length) {
 	// memset'ing the whole response to zero first ensures that all members
@@ -301,6 +340,10 @@ CALL_SESSION_FUNCTION(KeepSessionAlive, keep_session_alive, {
 	response.error_code = session_keep_alive(session, request->lifetime);
 })
 
+CALL_SESSION_FUNCTION(ExpireSessionObjects, expire_session_objects, {
+	response.error_code = session_expire_objects(session, request->type, &response.object_count);
+})
+
 //
 // object
 //
@@ -356,6 +399,11 @@ CALL_OBJECT_PROCEDURE_WITH_SESSION(ReleaseObjectUnchecked, release_object_unchec
 	error_code = object_release_unchecked(object, session);
 })
 
+CALL_SESSION_FUNCTION(ReleaseObjects, release_objects, {
+	response.error_code = object_release_multiple(request->object_ids, request->object_count,
+	                                              session, &response.released_count);
+})
+
 #undef CALL_OBJECT_PROCEDURE_WITH_SESSION
 #undef CALL_OBJECT_FUNCTION_WITH_SESSION
 
@@ -367,6 +415,29 @@ CALL_OBJECT_PROCEDURE_WITH_SESSION(ReleaseObjectUnchecked, release_object_unchec
 	CALL_TYPE_FUNCTION(packet_prefix, function_suffix, body, \
 	                   OBJECT_TYPE_STRING, String, string)
 
+#define CALL_STRING_FUNCTION_WITH_SESSION(packet_prefix, function_suffix, body) \
+	CALL_TYPE_FUNCTION_WITH_SESSION(packet_prefix, function_suffix, body, \
+	                                OBJECT_TYPE_STRING, String, string)
+
+#define CALL_STRING_PROCEDURE(packet_prefix, function_suffix, error_handler, body) \
+	static void api_##function_suffix(packet_prefix##Request *request) { \
+		String *string; \
+		APIE api_error_code = inventory_get_object(OBJECT_TYPE_STRING, request->string_id, \
+		                                           "api_"#function_suffix, (Object **)&string); \
+		PacketE packet_error_code; \
+		if (api_error_code != API_E_SUCCESS) { \
+			APIE error_code = api_error_code; \
+			(void)error_code; \
+			error_handler \
+			packet_error_code = api_get_packet_error_code(api_error_code); \
+		} else { \
+			PacketE error_code; \
+			body \
+			packet_error_code = error_code; \
+		} \
+		api_send_response_if_expected((Packet *)request, packet_error_code); \
+	}
+
 CALL_FUNCTION_WITH_SESSION(AllocateString, allocate_string, {
 	response.error_code = string_allocate(request->length_to_reserve,
 	                                      request->buffer, session,
@@ -389,6 +460,20 @@ CALL_STRING_FUNCTION(GetStringChunk, get_string_chunk, {
 	response.error_code = string_get_chunk(string, request->offset, response.buffer);
 })
 
+CALL_STRING_PROCEDURE(ReadStringAsync, read_string_async, {
+	// FIXME: this callback should be delivered after the response of this function
+	api_send_async_string_read_callback(request->string_id, error_code, NULL, 0);
+}, {
+	error_code = string_read_async(string, request->offset);
+})
+
+CALL_STRING_FUNCTION_WITH_SESSION(SplitString, split_string, {
+	response.error_code = string_split(string, request->separator, session,
+	                                   &response.list_id);
+})
+
+#undef CALL_STRING_PROCEDURE
+#undef CALL_STRING_FUNCTION_WITH_SESSION
 #undef CALL_STRING_FUNCTION
 
 //
@@ -419,10 +504,22 @@ CALL_LIST_FUNCTION_WITH_SESSION(GetListItem, get_list_item, {
 	                                    &response.type);
 })
 
+CALL_LIST_FUNCTION_WITH_SESSION(GetListItems, get_list_items, {
+	response.error_code = list_get_items(list, request->index, request->item_count,
+	                                     session, response.item_object_ids,
+	                                     response.types, &response.item_count);
+})
+
 CALL_LIST_FUNCTION(AppendToList, append_to_list, {
 	response.error_code = list_append_to(list, request->item_object_id);
 })
 
+CALL_LIST_FUNCTION(AppendMultipleToList, append_multiple_to_list, {
+	response.error_code = list_append_multiple_to(list, request->item_object_ids,
+	                                              request->item_count,
+	                                              &response.appended_count);
+})
+
 CALL_LIST_FUNCTION(RemoveFromList, remove_from_list, {
 	response.error_code = list_remove_from(list, request->index);
 })
@@ -469,6 +566,26 @@ CALL_FUNCTION_WITH_SESSION(OpenFile, open_file, {
 	                                &response.file_id, NULL);
 })
 
+CALL_FUNCTION_WITH_SESSION(CopyFile, copy_file, {
+	response.error_code = file_copy(request->source_name_string_id,
+	                                request->target_name_string_id,
+	                                request->flags, request->permissions,
+	                                request->uid, request->gid, session,
+	                                &response.file_id);
+})
+
+CALL_FUNCTION_WITH_SESSION(ExtractArchive, extract_archive, {
+	response.error_code = file_extract_archive(request->root_directory_string_id,
+	                                           request->uid, request->gid, session,
+	                                           &response.file_id);
+})
+
+CALL_FUNCTION_WITH_SESSION(CreateArchive, create_archive, {
+	response.error_code = file_create_archive(request->root_directory_string_id,
+	                                          request->flags, session,
+	                                          &response.file_id);
+})
+
 CALL_FUNCTION_WITH_SESSION(CreatePipe, create_pipe, {
 	response.error_code = pipe_create_(request->flags, request->length, session,
 	                                   OBJECT_CREATE_FLAG_EXTERNAL,
@@ -501,6 +618,24 @@ CALL_FILE_FUNCTION(AbortAsyncFileRead, abort_async_file_read, {
 	response.error_code = file_abort_async_read(file);
 })
 
+CALL_FILE_PROCEDURE(ReadFileAsyncWithCredit, read_file_async_with_credit, {
+	// FIXME: this callback should be delivered after the response of this function
+	api_send_async_file_read_callback(request->file_id, error_code, NULL, 0);
+}, {
+	error_code = file_read_async_with_credit(file, request->length_to_read, request->credit);
+})
+
+CALL_FILE_PROCEDURE(FollowFileAsync, follow_file_async, {
+	// FIXME: this callback should be delivered after the response of this function
+	api_send_async_file_read_callback(request->file_id, error_code, NULL, 0);
+}, {
+	error_code = file_follow_async(file, request->credit, request->idle_timeout);
+})
+
+CALL_FILE_FUNCTION(GrantAsyncFileReadCredit, grant_async_file_read_credit, {
+	response.error_code = file_grant_async_read_credit(file, request->credit);
+})
+
 CALL_FILE_FUNCTION(WriteFile, write_file, {
 	response.error_code = file_write_(file, request->buffer,
 	                                  request->length_to_write,
@@ -518,6 +653,47 @@ CALL_FILE_PROCEDURE(WriteFileAsync, write_file_async, {
 	error_code = file_write_async(file, request->buffer, request->length_to_write);
 })
 
+CALL_FILE_FUNCTION(ReadFileAt, read_file_at, {
+	response.error_code = file_read_at(file, request->offset, response.buffer,
+	                                   request->length_to_read, &response.length_read);
+})
+
+CALL_FILE_FUNCTION(WriteFileAt, write_file_at, {
+	response.error_code = file_write_at(file, request->offset, request->buffer,
+	                                    request->length_to_write,
+	                                    &response.length_written);
+})
+
+CALL_FILE_PROCEDURE(WriteFileAtUnchecked, write_file_at_unchecked, {}, {
+	error_code = file_write_at_unchecked(file, request->offset, request->buffer,
+	                                     request->length_to_write);
+})
+
+CALL_FILE_FUNCTION_WITH_SESSION(ReadStringFromFile, read_string_from_file, {
+	response.error_code = file_read_string(file, request->length_to_read, session,
+	                                       &response.string_id);
+})
+
+CALL_FILE_FUNCTION(WriteStringToFile, write_string_to_file, {
+	response.error_code = file_write_string(file, request->string_id,
+	                                        &response.length_written);
+})
+
+CALL_FILE_FUNCTION(GetFileChecksum, get_file_checksum, {
+	response.error_code = file_get_checksum(file, request->algorithm, request->offset,
+	                                        request->length);
+})
+
+CALL_FILE_FUNCTION(GetFileSignatures, get_file_signatures, {
+	response.error_code = file_get_signatures(file, request->block_length);
+})
+
+CALL_FILE_FUNCTION(ApplyFileDelta, apply_file_delta, {
+	response.error_code = file_apply_delta(file, request->basis_file_id,
+	                                       request->delta_file_id,
+	                                       request->block_length);
+})
+
 CALL_FILE_FUNCTION(SetFilePosition, set_file_position, {
 	response.error_code = file_set_position(file, request->offset, request->origin,
 	                                        &response.position);
@@ -556,6 +732,14 @@ CALL_FUNCTION_WITH_SESSION(OpenDirectory, open_directory, {
 	                                     &response.directory_id);
 })
 
+CALL_FUNCTION_WITH_SESSION(WalkDirectory, walk_directory, {
+	response.error_code = directory_walk(request->name_string_id,
+	                                     request->include_patterns_string_id,
+	                                     request->exclude_patterns_string_id,
+	                                     request->max_depth, session,
+	                                     &response.directory_id);
+})
+
 CALL_DIRECTORY_FUNCTION_WITH_SESSION(GetDirectoryName, get_directory_name, {
 	response.error_code = directory_get_name(directory, session,
 	                                         &response.name_string_id);
@@ -567,6 +751,12 @@ CALL_DIRECTORY_FUNCTION_WITH_SESSION(GetNextDirectoryEntry, get_next_directory_e
 	                                               &response.type);
 })
 
+CALL_DIRECTORY_FUNCTION_WITH_SESSION(GetDirectoryEntries, get_directory_entries, {
+	response.error_code = directory_get_entries(directory, request->flags,
+	                                            request->max_length, session,
+	                                            &response.entries_string_id);
+})
+
 CALL_DIRECTORY_FUNCTION(RewindDirectory, rewind_directory, {
 	response.error_code = directory_rewind(directory);
 })
@@ -577,6 +767,14 @@ CALL_FUNCTION_WITH_STRING(CreateDirectory, create_directory, name, {
 	                                       request->uid, request->gid);
 })
 
+CALL_FUNCTION(RemovePath, remove_path, {
+	response.error_code = directory_remove_path(request->name_string_id, request->flags);
+})
+
+CALL_FUNCTION(GetDiskUsage, get_disk_usage, {
+	response.error_code = directory_get_disk_usage(request->name_string_id);
+})
+
 #undef CALL_DIRECTORY_FUNCTION_WITH_SESSION
 #undef CALL_DIRECTORY_FUNCTION
 
@@ -851,6 +1049,34 @@ int api_init(void) {
 	                     sizeof(_program_process_spawned_callback),
 	                     CALLBACK_PROGRAM_PROCESS_SPAWNED);
 
+	api_prepare_callback((Packet *)&_async_string_read_callback,
+	                     sizeof(_async_string_read_callback),
+	                     CALLBACK_ASYNC_STRING_READ);
+
+	api_prepare_callback((Packet *)&_async_file_checksum_callback,
+	                     sizeof(_async_file_checksum_callback),
+	                     CALLBACK_ASYNC_FILE_CHECKSUM);
+
+	api_prepare_callback((Packet *)&_async_file_copied_callback,
+	                     sizeof(_async_file_copied_callback),
+	                     CALLBACK_ASYNC_FILE_COPIED);
+
+	api_prepare_callback((Packet *)&_async_file_signature_callback,
+	                     sizeof(_async_file_signature_callback),
+	                     CALLBACK_ASYNC_FILE_SIGNATURE);
+
+	api_prepare_callback((Packet *)&_async_file_delta_applied_callback,
+	                     sizeof(_async_file_delta_applied_callback),
+	                     CALLBACK_ASYNC_FILE_DELTA_APPLIED);
+
+	api_prepare_callback((Packet *)&_async_path_removal_callback,
+	                     sizeof(_async_path_removal_callback),
+	                     CALLBACK_ASYNC_PATH_REMOVAL);
+
+	api_prepare_callback((Packet *)&_async_disk_usage_callback,
+	                     sizeof(_async_disk_usage_callback),
+	                     CALLBACK_ASYNC_DISK_USAGE);
+
 	return 0;
 }
 
@@ -881,10 +1107,12 @@ void api_handle_request(Packet *request) {
 	DISPATCH_FUNCTION(EXPIRE_SESSION,                   ExpireSession,                expire_session)
 	DISPATCH_FUNCTION(EXPIRE_SESSION_UNCHECKED,         ExpireSessionUnchecked,       expire_session_unchecked)
 	DISPATCH_FUNCTION(KEEP_SESSION_ALIVE,               KeepSessionAlive,             keep_session_alive)
+	DISPATCH_FUNCTION(EXPIRE_SESSION_OBJECTS,           ExpireSessionObjects,         expire_session_objects)
 
 	// object
 	DISPATCH_FUNCTION(RELEASE_OBJECT,                   ReleaseObject,                release_object)
 	DISPATCH_FUNCTION(RELEASE_OBJECT_UNCHECKED,         ReleaseObjectUnchecked,       release_object_unchecked)
+	DISPATCH_FUNCTION(RELEASE_OBJECTS,                  ReleaseObjects,               release_objects)
 
 	// string
 	DISPATCH_FUNCTION(ALLOCATE_STRING,                  AllocateString,               allocate_string)
@@ -892,24 +1120,42 @@ void api_handle_request(Packet *request) {
 	DISPATCH_FUNCTION(GET_STRING_LENGTH,                GetStringLength,              get_string_length)
 	DISPATCH_FUNCTION(SET_STRING_CHUNK,                 SetStringChunk,               set_string_chunk)
 	DISPATCH_FUNCTION(GET_STRING_CHUNK,                 GetStringChunk,               get_string_chunk)
+	DISPATCH_FUNCTION(READ_STRING_ASYNC,                ReadStringAsync,              read_string_async)
+	DISPATCH_FUNCTION(SPLIT_STRING,                     SplitString,                  split_string)
 
 	// list
 	DISPATCH_FUNCTION(ALLOCATE_LIST,                    AllocateList,                 allocate_list)
 	DISPATCH_FUNCTION(GET_LIST_LENGTH,                  GetListLength,                get_list_length)
 	DISPATCH_FUNCTION(GET_LIST_ITEM,                    GetListItem,                  get_list_item)
 	DISPATCH_FUNCTION(APPEND_TO_LIST,                   AppendToList,                 append_to_list)
+	DISPATCH_FUNCTION(GET_LIST_ITEMS,                   GetListItems,                 get_list_items)
+	DISPATCH_FUNCTION(APPEND_MULTIPLE_TO_LIST,          AppendMultipleToList,         append_multiple_to_list)
 	DISPATCH_FUNCTION(REMOVE_FROM_LIST,                 RemoveFromList,               remove_from_list)
 
 	// file
 	DISPATCH_FUNCTION(OPEN_FILE,                        OpenFile,                     open_file)
 	DISPATCH_FUNCTION(CREATE_PIPE,                      CreatePipe,                   create_pipe)
+	DISPATCH_FUNCTION(COPY_FILE,                        CopyFile,                     copy_file)
+	DISPATCH_FUNCTION(EXTRACT_ARCHIVE,                  ExtractArchive,               extract_archive)
+	DISPATCH_FUNCTION(CREATE_ARCHIVE,                   CreateArchive,                create_archive)
 	DISPATCH_FUNCTION(GET_FILE_INFO,                    GetFileInfo,                  get_file_info)
 	DISPATCH_FUNCTION(READ_FILE,                        ReadFile,                     read_file)
 	DISPATCH_FUNCTION(READ_FILE_ASYNC,                  ReadFileAsync,                read_file_async)
 	DISPATCH_FUNCTION(ABORT_ASYNC_FILE_READ,            AbortAsyncFileRead,           abort_async_file_read)
+	DISPATCH_FUNCTION(READ_FILE_ASYNC_WITH_CREDIT,      ReadFileAsyncWithCredit,      read_file_async_with_credit)
+	DISPATCH_FUNCTION(GRANT_ASYNC_FILE_READ_CREDIT,     GrantAsyncFileReadCredit,     grant_async_file_read_credit)
+	DISPATCH_FUNCTION(FOLLOW_FILE_ASYNC,                FollowFileAsync,              follow_file_async)
 	DISPATCH_FUNCTION(WRITE_FILE,                       WriteFile,                    write_file)
 	DISPATCH_FUNCTION(WRITE_FILE_UNCHECKED,             WriteFileUnchecked,           write_file_unchecked)
 	DISPATCH_FUNCTION(WRITE_FILE_ASYNC,                 WriteFileAsync,               write_file_async)
+	DISPATCH_FUNCTION(READ_FILE_AT,                     ReadFileAt,                   read_file_at)
+	DISPATCH_FUNCTION(WRITE_FILE_AT,                    WriteFileAt,                  write_file_at)
+	DISPATCH_FUNCTION(WRITE_FILE_AT_UNCHECKED,          WriteFileAtUnchecked,         write_file_at_unchecked)
+	DISPATCH_FUNCTION(READ_STRING_FROM_FILE,            ReadStringFromFile,           read_string_from_file)
+	DISPATCH_FUNCTION(WRITE_STRING_TO_FILE,             WriteStringToFile,            write_string_to_file)
+	DISPATCH_FUNCTION(GET_FILE_CHECKSUM,                GetFileChecksum,              get_file_checksum)
+	DISPATCH_FUNCTION(GET_FILE_SIGNATURES,              GetFileSignatures,            get_file_signatures)
+	DISPATCH_FUNCTION(APPLY_FILE_DELTA,                 ApplyFileDelta,               apply_file_delta)
 	DISPATCH_FUNCTION(SET_FILE_POSITION,                SetFilePosition,              set_file_position)
 	DISPATCH_FUNCTION(GET_FILE_POSITION,                GetFilePosition,              get_file_position)
 	DISPATCH_FUNCTION(SET_FILE_EVENTS,                  SetFileEvents,                set_file_events)
@@ -917,10 +1163,14 @@ void api_handle_request(Packet *request) {
 
 	// directory
 	DISPATCH_FUNCTION(OPEN_DIRECTORY,                   OpenDirectory,                open_directory)
+	DISPATCH_FUNCTION(WALK_DIRECTORY,                   WalkDirectory,                walk_directory)
 	DISPATCH_FUNCTION(GET_DIRECTORY_NAME,               GetDirectoryName,             get_directory_name)
 	DISPATCH_FUNCTION(GET_NEXT_DIRECTORY_ENTRY,         GetNextDirectoryEntry,        get_next_directory_entry)
+	DISPATCH_FUNCTION(GET_DIRECTORY_ENTRIES,            GetDirectoryEntries,          get_directory_entries)
 	DISPATCH_FUNCTION(REWIND_DIRECTORY,                 RewindDirectory,              rewind_directory)
 	DISPATCH_FUNCTION(CREATE_DIRECTORY,                 CreateDirectory,              create_directory)
+	DISPATCH_FUNCTION(REMOVE_PATH,                      RemovePath,                   remove_path)
+	DISPATCH_FUNCTION(GET_DISK_USAGE,                   GetDiskUsage,                 get_disk_usage)
 
 	// process
 	DISPATCH_FUNCTION(GET_PROCESSES,                    GetProcesses,                 get_processes)
@@ -973,10 +1223,12 @@ const char *api_get_function_name(int function_id) {
 	case FUNCTION_EXPIRE_SESSION:                   return "expire-session";
 	case FUNCTION_EXPIRE_SESSION_UNCHECKED:         return "expire-session-unchecked";
 	case FUNCTION_KEEP_SESSION_ALIVE:               return "keep-session-alive";
+	case FUNCTION_EXPIRE_SESSION_OBJECTS:           return "expire-session-objects";
 
 	// object
 	case FUNCTION_RELEASE_OBJECT:                   return "release-object";
 	case FUNCTION_RELEASE_OBJECT_UNCHECKED:         return "release-object-unchecked";
+	case FUNCTION_RELEASE_OBJECTS:                  return "release-objects";
 
 	// string
 	case FUNCTION_ALLOCATE_STRING:                  return "allocate-string";
@@ -984,24 +1236,43 @@ const char *api_get_function_name(int function_id) {
 	case FUNCTION_GET_STRING_LENGTH:                return "get-string-length";
 	case FUNCTION_SET_STRING_CHUNK:                 return "set-string-chunk";
 	case FUNCTION_GET_STRING_CHUNK:                 return "get-string-chunk";
+	case FUNCTION_READ_STRING_ASYNC:                return "read-string-async";
+	case CALLBACK_ASYNC_STRING_READ:                return "async-string-read";
+	case FUNCTION_SPLIT_STRING:                     return "split-string";
 
 	// list
 	case FUNCTION_ALLOCATE_LIST:                    return "allocate-list";
 	case FUNCTION_GET_LIST_LENGTH:                  return "get-list-length";
 	case FUNCTION_GET_LIST_ITEM:                    return "get-list-item";
 	case FUNCTION_APPEND_TO_LIST:                   return "append-to-list";
+	case FUNCTION_GET_LIST_ITEMS:                   return "get-list-items";
+	case FUNCTION_APPEND_MULTIPLE_TO_LIST:          return "append-multiple-to-list";
 	case FUNCTION_REMOVE_FROM_LIST:                 return "remove-from-list";
 
 	// file
 	case FUNCTION_OPEN_FILE:                        return "open-file";
 	case FUNCTION_CREATE_PIPE:                      return "create-pipe";
+	case FUNCTION_COPY_FILE:                        return "copy-file";
+	case FUNCTION_EXTRACT_ARCHIVE:                  return "extract-archive";
+	case FUNCTION_CREATE_ARCHIVE:                   return "create-archive";
 	case FUNCTION_GET_FILE_INFO:                    return "get-file-info";
 	case FUNCTION_READ_FILE:                        return "read-file";
 	case FUNCTION_READ_FILE_ASYNC:                  return "read-file-async";
 	case FUNCTION_ABORT_ASYNC_FILE_READ:            return "abort-async-file-read";
+	case FUNCTION_READ_FILE_ASYNC_WITH_CREDIT:      return "read-file-async-with-credit";
+	case FUNCTION_GRANT_ASYNC_FILE_READ_CREDIT:     return "grant-async-file-read-credit";
+	case FUNCTION_FOLLOW_FILE_ASYNC:                return "follow-file-async";
 	case FUNCTION_WRITE_FILE:                       return "write-file";
 	case FUNCTION_WRITE_FILE_UNCHECKED:             return "write-file-unchecked";
 	case FUNCTION_WRITE_FILE_ASYNC:                 return "write-file-async";
+	case FUNCTION_READ_FILE_AT:                     return "read-file-at";
+	case FUNCTION_WRITE_FILE_AT:                    return "write-file-at";
+	case FUNCTION_WRITE_FILE_AT_UNCHECKED:          return "write-file-at-unchecked";
+	case FUNCTION_READ_STRING_FROM_FILE:            return "read-string-from-file";
+	case FUNCTION_WRITE_STRING_TO_FILE:             return "write-string-to-file";
+	case FUNCTION_GET_FILE_CHECKSUM:                return "get-file-checksum";
+	case FUNCTION_GET_FILE_SIGNATURES:              return "get-file-signatures";
+	case FUNCTION_APPLY_FILE_DELTA:                 return "apply-file-delta";
 	case FUNCTION_SET_FILE_POSITION:                return "set-file-position";
 	case FUNCTION_GET_FILE_POSITION:                return "get-file-position";
 	case FUNCTION_SET_FILE_EVENTS:                  return "set-file-events";
@@ -1009,13 +1280,23 @@ const char *api_get_function_name(int function_id) {
 	case CALLBACK_ASYNC_FILE_READ:                  return "async-file-read";
 	case CALLBACK_ASYNC_FILE_WRITE:                 return "async-file-write";
 	case CALLBACK_FILE_EVENTS_OCCURRED:             return "file-events-occurred";
+	case CALLBACK_ASYNC_FILE_CHECKSUM:              return "async-file-checksum";
+	case CALLBACK_ASYNC_FILE_COPIED:                return "async-file-copied";
+	case CALLBACK_ASYNC_FILE_SIGNATURE:             return "async-file-signature";
+	case CALLBACK_ASYNC_FILE_DELTA_APPLIED:         return "async-file-delta-applied";
 
 	// directory
 	case FUNCTION_OPEN_DIRECTORY:                   return "open-directory";
+	case FUNCTION_WALK_DIRECTORY:                   return "walk-directory";
 	case FUNCTION_GET_DIRECTORY_NAME:               return "get-directory-name";
 	case FUNCTION_GET_NEXT_DIRECTORY_ENTRY:         return "get-next-directory-entry";
+	case FUNCTION_GET_DIRECTORY_ENTRIES:            return "get-directory-entries";
 	case FUNCTION_REWIND_DIRECTORY:                 return "rewind-directory";
 	case FUNCTION_CREATE_DIRECTORY:                 return "create-directory";
+	case FUNCTION_REMOVE_PATH:                      return "remove-path";
+	case CALLBACK_ASYNC_PATH_REMOVAL:               return "async-path-removal";
+	case FUNCTION_GET_DISK_USAGE:                   return "get-disk-usage";
+	case CALLBACK_ASYNC_DISK_USAGE:                 return "async-disk-usage";
 
 	// process
 	case FUNCTION_GET_PROCESSES:                    return "get-processes";
@@ -1076,6 +1357,25 @@ void api_send_async_file_read_callback(ObjectID file_id, APIE error_code,
 	network_dispatch_response((Packet *)&_async_file_read_callback);
 }
 
+void api_send_async_string_read_callback(ObjectID string_id, APIE error_code,
+                                         char *buffer, uint8_t length_read) {
+	_async_string_read_callback.string_id = string_id;
+	_async_string_read_callback.error_code = error_code;
+	_async_string_read_callback.length_read = length_read;
+
+	// buffer can be NULL if length_read is zero
+	if (length_read > 0) {
+		memcpy(_async_string_read_callback.buffer, buffer, length_read);
+	}
+
+	// memset'ing the rest of the buffer to zero ensures that no random
+	// heap/stack data can leak to the client
+	memset(_async_string_read_callback.buffer + length_read, 0,
+	       sizeof(_async_string_read_callback.buffer) - length_read);
+
+	network_dispatch_response((Packet *)&_async_string_read_callback);
+}
+
 void api_send_async_file_write_callback(ObjectID file_id, APIE error_code,
                                         uint8_t length_written) {
 	_async_file_write_callback.file_id = file_id;
@@ -1092,6 +1392,90 @@ void api_send_file_events_occurred_callback(ObjectID file_id, uint16_t events) {
 	network_dispatch_response((Packet *)&_file_events_occurred_callback);
 }
 
+void api_send_async_file_checksum_callback(ObjectID file_id, APIE error_code,
+                                           uint8_t algorithm, uint8_t *checksum,
+                                           uint8_t checksum_length) {
+	_async_file_checksum_callback.file_id = file_id;
+	_async_file_checksum_callback.error_code = error_code;
+	_async_file_checksum_callback.algorithm = algorithm;
+	_async_file_checksum_callback.checksum_length = checksum_length;
+
+	// checksum can be NULL if checksum_length is zero
+	if (checksum_length > 0) {
+		memcpy(_async_file_checksum_callback.checksum, checksum, checksum_length);
+	}
+
+	// memset'ing the rest of the checksum to zero ensures that no random
+	// heap/stack data can leak to the client
+	memset(_async_file_checksum_callback.checksum + checksum_length, 0,
+	       sizeof(_async_file_checksum_callback.checksum) - checksum_length);
+
+	network_dispatch_response((Packet *)&_async_file_checksum_callback);
+}
+
+void api_send_async_file_copied_callback(ObjectID file_id, APIE error_code,
+                                         uint64_t length_copied) {
+	_async_file_copied_callback.file_id = file_id;
+	_async_file_copied_callback.error_code = error_code;
+	_async_file_copied_callback.length_copied = length_copied;
+
+	network_dispatch_response((Packet *)&_async_file_copied_callback);
+}
+
+void api_send_async_file_signature_callback(ObjectID file_id, APIE error_code,
+                                            uint32_t block_index, uint32_t block_length,
+                                            uint32_t rolling_checksum,
+                                            uint8_t *strong_checksum) {
+	_async_file_signature_callback.file_id = file_id;
+	_async_file_signature_callback.error_code = error_code;
+	_async_file_signature_callback.block_index = block_index;
+	_async_file_signature_callback.block_length = block_length;
+	_async_file_signature_callback.rolling_checksum = rolling_checksum;
+
+	// strong_checksum can be NULL if block_length is zero
+	if (strong_checksum != NULL) {
+		memcpy(_async_file_signature_callback.strong_checksum, strong_checksum,
+		       sizeof(_async_file_signature_callback.strong_checksum));
+	} else {
+		memset(_async_file_signature_callback.strong_checksum, 0,
+		       sizeof(_async_file_signature_callback.strong_checksum));
+	}
+
+	network_dispatch_response((Packet *)&_async_file_signature_callback);
+}
+
+void api_send_async_file_delta_applied_callback(ObjectID file_id, APIE error_code,
+                                                uint64_t length_written) {
+	_async_file_delta_applied_callback.file_id = file_id;
+	_async_file_delta_applied_callback.error_code = error_code;
+	_async_file_delta_applied_callback.length_written = length_written;
+
+	network_dispatch_response((Packet *)&_async_file_delta_applied_callback);
+}
+
+void api_send_async_path_removal_callback(ObjectID name_string_id, APIE error_code,
+                                          uint64_t entries_removed, bool finished) {
+	_async_path_removal_callback.name_string_id = name_string_id;
+	_async_path_removal_callback.error_code = error_code;
+	_async_path_removal_callback.entries_removed = entries_removed;
+	_async_path_removal_callback.finished = finished ? 1 : 0;
+
+	network_dispatch_response((Packet *)&_async_path_removal_callback);
+}
+
+void api_send_async_disk_usage_callback(ObjectID name_string_id, APIE error_code,
+                                        uint64_t length, uint64_t allocated_length,
+                                        uint64_t entry_count, bool finished) {
+	_async_disk_usage_callback.name_string_id = name_string_id;
+	_async_disk_usage_callback.error_code = error_code;
+	_async_disk_usage_callback.length = length;
+	_async_disk_usage_callback.allocated_length = allocated_length;
+	_async_disk_usage_callback.entry_count = entry_count;
+	_async_disk_usage_callback.finished = finished ? 1 : 0;
+
+	network_dispatch_response((Packet *)&_async_disk_usage_callback);
+}
+
 void api_send_process_state_changed_callback(ObjectID process_id, uint8_t state,
                                              uint64_t timestamp, uint8_t exit_code) {
 	_process_state_changed_callback.process_id = process_id;
@@ -40,11 +40,31 @@ void api_handle_request(Packet *request);
 
 const char *api_get_function_name(int function_id);
 
+void api_send_async_string_read_callback(ObjectID string_id, APIE error_code,
+                                         char *buffer, uint8_t length_read);
+
 void api_send_async_file_read_callback(ObjectID file_id, APIE error_code,
                                        uint8_t *buffer, uint8_t length_read);
 void api_send_async_file_write_callback(ObjectID file_id, APIE error_code,
                                         uint8_t length_written);
 void api_send_file_events_occurred_callback(ObjectID file_id, uint16_t events);
+void api_send_async_file_checksum_callback(ObjectID file_id, APIE error_code,
+                                           uint8_t algorithm, uint8_t *checksum,
+                                           uint8_t checksum_length);
+void api_send_async_file_copied_callback(ObjectID file_id, APIE error_code,
+                                         uint64_t length_copied);
+void api_send_async_file_signature_callback(ObjectID file_id, APIE error_code,
+                                            uint32_t block_index, uint32_t block_length,
+                                            uint32_t rolling_checksum,
+                                            uint8_t *strong_checksum);
+void api_send_async_file_delta_applied_callback(ObjectID file_id, APIE error_code,
+                                                uint64_t length_written);
+
+void api_send_async_path_removal_callback(ObjectID name_string_id, APIE error_code,
+                                          uint64_t entries_removed, bool finished);
+void api_send_async_disk_usage_callback(ObjectID name_string_id, APIE error_code,
+                                        uint64_t length, uint64_t allocated_length,
+                                        uint64_t entry_count, bool finished);
 
 void api_send_process_state_changed_callback(ObjectID process_id, uint8_t state,
                                              uint64_t timestamp, uint8_t exit_code);
@@ -47,6 +47,31 @@ APIE api_get_error_code_from_errno(void) {
 	}
 }
 
+// used where an error code has to be passed through an errno based interface
+int api_get_errno_from_error_code(APIE error_code) {
+	switch (error_code) {
+	case API_E_INVALID_PARAMETER:    return EINVAL;
+	case API_E_NO_FREE_MEMORY:       return ENOMEM;
+	case API_E_NO_FREE_SPACE:        return ENOSPC;
+	case API_E_ACCESS_DENIED:        return EACCES;
+	case API_E_ALREADY_EXISTS:       return EEXIST;
+	case API_E_DOES_NOT_EXIST:       return ENOENT;
+	case API_E_INTERRUPTED:          return EINTR;
+	case API_E_IS_DIRECTORY:         return EISDIR;
+	case API_E_NOT_A_DIRECTORY:      return ENOTDIR;
+	case API_E_WOULD_BLOCK:          return EWOULDBLOCK;
+	case API_E_OVERFLOW:             return EOVERFLOW;
+	case API_E_BAD_FILE_DESCRIPTOR:  return EBADF;
+	case API_E_OUT_OF_RANGE:         return ERANGE;
+	case API_E_NAME_TOO_LONG:        return ENAMETOOLONG;
+	case API_E_INVALID_SEEK:         return ESPIPE;
+	case API_E_NOT_SUPPORTED:        return ENOTSUP;
+	case API_E_TOO_MANY_OPEN_FILES:  return EMFILE;
+
+	default:                         return EIO;
+	}
+}
+
 const char *api_get_error_code_name(APIE error_code) {
 	#define ERROR_CODE_NAME(code) case code: return #code
 
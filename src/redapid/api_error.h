@@ -70,6 +70,7 @@ typedef enum {
 } APIE;
 
 APIE api_get_error_code_from_errno(void);
+int api_get_errno_from_error_code(APIE error_code);
 
 const char *api_get_error_code_name(APIE error_code);
 
@@ -27,7 +27,9 @@
 #include <daemonlib/packed_begin.h>
 
 #include "api.h"
+#include "checksum.h"
 #include "file.h"
+#include "list.h"
 #include "string.h"
 
 //
@@ -71,6 +73,18 @@ typedef struct {
 	uint8_t error_code;
 } ATTRIBUTE_PACKED KeepSessionAliveResponse;
 
+typedef struct {
+	PacketHeader header;
+	uint16_t session_id;
+	uint8_t type;
+} ATTRIBUTE_PACKED ExpireSessionObjectsRequest;
+
+typedef struct {
+	PacketHeader header;
+	uint8_t error_code;
+	uint16_t object_count;
+} ATTRIBUTE_PACKED ExpireSessionObjectsResponse;
+
 //
 // object
 //
@@ -92,6 +106,19 @@ typedef struct {
 	uint16_t session_id;
 } ATTRIBUTE_PACKED ReleaseObjectUncheckedRequest;
 
+typedef struct {
+	PacketHeader header;
+	uint16_t object_ids[OBJECT_MAX_RELEASE_MULTIPLE_IDS];
+	uint8_t object_count;
+	uint16_t session_id;
+} ATTRIBUTE_PACKED ReleaseObjectsRequest;
+
+typedef struct {
+	PacketHeader header;
+	uint8_t error_code;
+	uint8_t released_count;
+} ATTRIBUTE_PACKED ReleaseObjectsResponse;
+
 //
 // string
 //
@@ -155,6 +182,33 @@ typedef struct {
 	char buffer[STRING_MAX_GET_CHUNK_BUFFER_LENGTH];
 } ATTRIBUTE_PACKED GetStringChunkResponse;
 
+typedef struct {
+	PacketHeader header;
+	uint16_t string_id;
+	uint32_t offset;
+} ATTRIBUTE_PACKED ReadStringAsyncRequest;
+
+typedef struct {
+	PacketHeader header;
+	uint16_t string_id;
+	uint8_t error_code;
+	char buffer[STRING_MAX_READ_ASYNC_BUFFER_LENGTH];
+	uint8_t length_read;
+} ATTRIBUTE_PACKED AsyncStringReadCallback;
+
+typedef struct {
+	PacketHeader header;
+	uint16_t string_id;
+	char separator;
+	uint16_t session_id;
+} ATTRIBUTE_PACKED SplitStringRequest;
+
+typedef struct {
+	PacketHeader header;
+	uint8_t error_code;
+	uint16_t list_id;
+} ATTRIBUTE_PACKED SplitStringResponse;
+
 //
 // list
 //
@@ -196,6 +250,22 @@ typedef struct {
 	uint8_t type;
 } ATTRIBUTE_PACKED GetListItemResponse;
 
+typedef struct {
+	PacketHeader header;
+	uint16_t list_id;
+	uint16_t index;
+	uint8_t item_count;
+	uint16_t session_id;
+} ATTRIBUTE_PACKED GetListItemsRequest;
+
+typedef struct {
+	PacketHeader header;
+	uint8_t error_code;
+	uint16_t item_object_ids[LIST_MAX_GET_ITEMS];
+	uint8_t types[LIST_MAX_GET_ITEMS];
+	uint8_t item_count;
+} ATTRIBUTE_PACKED GetListItemsResponse;
+
 typedef struct {
 	PacketHeader header;
 	uint16_t list_id;
@@ -207,6 +277,19 @@ typedef struct {
 	uint8_t error_code;
 } ATTRIBUTE_PACKED AppendToListResponse;
 
+typedef struct {
+	PacketHeader header;
+	uint16_t list_id;
+	uint16_t item_object_ids[LIST_MAX_APPEND_ITEMS];
+	uint8_t item_count;
+} ATTRIBUTE_PACKED AppendMultipleToListRequest;
+
+typedef struct {
+	PacketHeader header;
+	uint8_t error_code;
+	uint8_t appended_count;
+} ATTRIBUTE_PACKED AppendMultipleToListResponse;
+
 typedef struct {
 	PacketHeader header;
 	uint16_t list_id;
@@ -238,6 +321,50 @@ typedef struct {
 	uint16_t file_id;
 } ATTRIBUTE_PACKED OpenFileResponse;
 
+typedef struct {
+	PacketHeader header;
+	uint16_t source_name_string_id;
+	uint16_t target_name_string_id;
+	uint32_t flags;
+	uint16_t permissions;
+	uint32_t uid;
+	uint32_t gid;
+	uint16_t session_id;
+} ATTRIBUTE_PACKED CopyFileRequest;
+
+typedef struct {
+	PacketHeader header;
+	uint8_t error_code;
+	uint16_t file_id;
+} ATTRIBUTE_PACKED CopyFileResponse;
+
+typedef struct {
+	PacketHeader header;
+	uint16_t root_directory_string_id;
+	uint32_t uid;
+	uint32_t gid;
+	uint16_t session_id;
+} ATTRIBUTE_PACKED ExtractArchiveRequest;
+
+typedef struct {
+	PacketHeader header;
+	uint8_t error_code;
+	uint16_t file_id;
+} ATTRIBUTE_PACKED ExtractArchiveResponse;
+
+typedef struct {
+	PacketHeader header;
+	uint16_t root_directory_string_id;
+	uint32_t flags;
+	uint16_t session_id;
+} ATTRIBUTE_PACKED CreateArchiveRequest;
+
+typedef struct {
+	PacketHeader header;
+	uint8_t error_code;
+	uint16_t file_id;
+} ATTRIBUTE_PACKED CreateArchiveResponse;
+
 typedef struct {
 	PacketHeader header;
 	uint32_t flags;
@@ -301,6 +428,31 @@ typedef struct {
 	uint8_t error_code;
 } ATTRIBUTE_PACKED AbortAsyncFileReadResponse;
 
+typedef struct {
+	PacketHeader header;
+	uint16_t file_id;
+	uint64_t length_to_read;
+	uint16_t credit;
+} ATTRIBUTE_PACKED ReadFileAsyncWithCreditRequest;
+
+typedef struct {
+	PacketHeader header;
+	uint16_t file_id;
+	uint16_t credit;
+} ATTRIBUTE_PACKED GrantAsyncFileReadCreditRequest;
+
+typedef struct {
+	PacketHeader header;
+	uint8_t error_code;
+} ATTRIBUTE_PACKED GrantAsyncFileReadCreditResponse;
+
+typedef struct {
+	PacketHeader header;
+	uint16_t file_id;
+	uint16_t credit;
+	uint32_t idle_timeout;
+} ATTRIBUTE_PACKED FollowFileAsyncRequest;
+
 typedef struct {
 	PacketHeader header;
 	uint16_t file_id;
@@ -328,6 +480,104 @@ typedef struct {
 	uint8_t length_to_write;
 } ATTRIBUTE_PACKED WriteFileAsyncRequest;
 
+typedef struct {
+	PacketHeader header;
+	uint16_t file_id;
+	uint64_t offset;
+	uint8_t length_to_read;
+} ATTRIBUTE_PACKED ReadFileAtRequest;
+
+typedef struct {
+	PacketHeader header;
+	uint8_t error_code;
+	uint8_t buffer[FILE_MAX_READ_AT_BUFFER_LENGTH];
+	uint8_t length_read;
+} ATTRIBUTE_PACKED ReadFileAtResponse;
+
+typedef struct {
+	PacketHeader header;
+	uint16_t file_id;
+	uint64_t offset;
+	uint8_t buffer[FILE_MAX_WRITE_AT_BUFFER_LENGTH];
+	uint8_t length_to_write;
+} ATTRIBUTE_PACKED WriteFileAtRequest;
+
+typedef struct {
+	PacketHeader header;
+	uint8_t error_code;
+	uint8_t length_written;
+} ATTRIBUTE_PACKED WriteFileAtResponse;
+
+typedef struct {
+	PacketHeader header;
+	uint16_t file_id;
+	uint64_t offset;
+	uint8_t buffer[FILE_MAX_WRITE_AT_UNCHECKED_BUFFER_LENGTH];
+	uint8_t length_to_write;
+} ATTRIBUTE_PACKED WriteFileAtUncheckedRequest;
+
+typedef struct {
+	PacketHeader header;
+	uint16_t file_id;
+	uint32_t length_to_read;
+	uint16_t session_id;
+} ATTRIBUTE_PACKED ReadStringFromFileRequest;
+
+typedef struct {
+	PacketHeader header;
+	uint8_t error_code;
+	uint16_t string_id;
+} ATTRIBUTE_PACKED ReadStringFromFileResponse;
+
+typedef struct {
+	PacketHeader header;
+	uint16_t file_id;
+	uint16_t string_id;
+} ATTRIBUTE_PACKED WriteStringToFileRequest;
+
+typedef struct {
+	PacketHeader header;
+	uint8_t error_code;
+	uint32_t length_written;
+} ATTRIBUTE_PACKED WriteStringToFileResponse;
+
+typedef struct {
+	PacketHeader header;
+	uint16_t file_id;
+	uint8_t algorithm;
+	uint64_t offset;
+	uint64_t length;
+} ATTRIBUTE_PACKED GetFileChecksumRequest;
+
+typedef struct {
+	PacketHeader header;
+	uint8_t error_code;
+} ATTRIBUTE_PACKED GetFileChecksumResponse;
+
+typedef struct {
+	PacketHeader header;
+	uint16_t file_id;
+	uint32_t block_length;
+} ATTRIBUTE_PACKED GetFileSignaturesRequest;
+
+typedef struct {
+	PacketHeader header;
+	uint8_t error_code;
+} ATTRIBUTE_PACKED GetFileSignaturesResponse;
+
+typedef struct {
+	PacketHeader header;
+	uint16_t file_id;
+	uint16_t basis_file_id;
+	uint16_t delta_file_id;
+	uint32_t block_length;
+} ATTRIBUTE_PACKED ApplyFileDeltaRequest;
+
+typedef struct {
+	PacketHeader header;
+	uint8_t error_code;
+} ATTRIBUTE_PACKED ApplyFileDeltaResponse;
+
 typedef struct {
 	PacketHeader header;
 	uint16_t file_id;
@@ -395,6 +645,39 @@ typedef struct {
 	uint16_t events;
 } ATTRIBUTE_PACKED FileEventsOccurredCallback;
 
+typedef struct {
+	PacketHeader header;
+	uint16_t file_id;
+	uint8_t error_code;
+	uint8_t algorithm;
+	uint8_t checksum[CHECKSUM_MAX_LENGTH];
+	uint8_t checksum_length;
+} ATTRIBUTE_PACKED AsyncFileChecksumCallback;
+
+typedef struct {
+	PacketHeader header;
+	uint16_t file_id;
+	uint8_t error_code;
+	uint64_t length_copied;
+} ATTRIBUTE_PACKED AsyncFileCopiedCallback;
+
+typedef struct {
+	PacketHeader header;
+	uint16_t file_id;
+	uint8_t error_code;
+	uint32_t block_index;
+	uint32_t block_length;
+	uint32_t rolling_checksum;
+	uint8_t strong_checksum[CHECKSUM_MAX_LENGTH];
+} ATTRIBUTE_PACKED AsyncFileSignatureCallback;
+
+typedef struct {
+	PacketHeader header;
+	uint16_t file_id;
+	uint8_t error_code;
+	uint64_t length_written;
+} ATTRIBUTE_PACKED AsyncFileDeltaAppliedCallback;
+
 //
 // directory
 //
@@ -411,6 +694,21 @@ typedef struct {
 	uint16_t directory_id;
 } ATTRIBUTE_PACKED OpenDirectoryResponse;
 
+typedef struct {
+	PacketHeader header;
+	uint16_t name_string_id;
+	uint16_t include_patterns_string_id;
+	uint16_t exclude_patterns_string_id;
+	uint16_t max_depth;
+	uint16_t session_id;
+} ATTRIBUTE_PACKED WalkDirectoryRequest;
+
+typedef struct {
+	PacketHeader header;
+	uint8_t error_code;
+	uint16_t directory_id;
+} ATTRIBUTE_PACKED WalkDirectoryResponse;
+
 typedef struct {
 	PacketHeader header;
 	uint16_t directory_id;
@@ -436,6 +734,20 @@ typedef struct {
 	uint8_t type;
 } ATTRIBUTE_PACKED GetNextDirectoryEntryResponse;
 
+typedef struct {
+	PacketHeader header;
+	uint16_t directory_id;
+	uint32_t flags;
+	uint32_t max_length;
+	uint16_t session_id;
+} ATTRIBUTE_PACKED GetDirectoryEntriesRequest;
+
+typedef struct {
+	PacketHeader header;
+	uint8_t error_code;
+	uint16_t entries_string_id;
+} ATTRIBUTE_PACKED GetDirectoryEntriesResponse;
+
 typedef struct {
 	PacketHeader header;
 	uint16_t directory_id;
@@ -460,6 +772,45 @@ typedef struct {
 	uint8_t error_code;
 } ATTRIBUTE_PACKED CreateDirectoryResponse;
 
+typedef struct {
+	PacketHeader header;
+	uint16_t name_string_id;
+	uint32_t flags;
+} ATTRIBUTE_PACKED RemovePathRequest;
+
+typedef struct {
+	PacketHeader header;
+	uint8_t error_code;
+} ATTRIBUTE_PACKED RemovePathResponse;
+
+typedef struct {
+	PacketHeader header;
+	uint16_t name_string_id;
+	uint8_t error_code;
+	uint64_t entries_removed;
+	tfpbool finished;
+} ATTRIBUTE_PACKED AsyncPathRemovalCallback;
+
+typedef struct {
+	PacketHeader header;
+	uint16_t name_string_id;
+} ATTRIBUTE_PACKED GetDiskUsageRequest;
+
+typedef struct {
+	PacketHeader header;
+	uint8_t error_code;
+} ATTRIBUTE_PACKED GetDiskUsageResponse;
+
+typedef struct {
+	PacketHeader header;
+	uint16_t name_string_id;
+	uint8_t error_code;
+	uint64_t length;
+	uint64_t allocated_length;
+	uint64_t entry_count;
+	tfpbool finished;
+} ATTRIBUTE_PACKED AsyncDiskUsageCallback;
+
 //
 // process
 //
@@ -0,0 +1,1274 @@
+/*
+ * redapid
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * archive.c: Streaming tar archive extraction and creation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * the extractor consumes an uncompressed tar archive in arbitrary sized
+ * pieces as they arrive, without buffering more than one header block. it
+ * understands ustar headers, GNU long names and the path record of pax
+ * extended headers. regular files and directories are created below the root
+ * directory using file_open and directory_create, so the same identity and
+ * permission handling applies as for files and directories created by the
+ * client. regular files are replaced instead of truncated, so executables of
+ * running programs can be updated. all other entry types are skipped.
+ *
+ * the creator produces a tar archive of a directory tree on demand, one read
+ * at a time. it keeps one open directory per level of the tree and at most one
+ * open file, so memory use only depends on the depth of the tree. regular
+ * files, directories and symlinks are stored, names longer than 100 bytes use
+ * GNU long name headers. the archive can be gzip compressed on the fly.
+ */
+
+#define _GNU_SOURCE // for asprintf from stdio.h
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+#include <sys/stat.h>
+
+#include <daemonlib/array.h>
+#include <daemonlib/log.h>
+#include <daemonlib/utils.h>
+
+#include "archive.h"
+
+#include "directory.h"
+#include "file.h"
+#include "string.h"
+
+static LogSource _log_source = LOG_SOURCE_INITIALIZER;
+
+#define ARCHIVE_BLOCK_LENGTH 512
+#define ARCHIVE_MAX_EXTENDED_HEADER_LENGTH 8192 // GNU long name or pax header
+#define ARCHIVE_MAX_LINK_NAME_LENGTH 100
+#define ARCHIVE_COMPRESSION_BUFFER_LENGTH 16384
+
+typedef enum {
+	ARCHIVE_STATE_HEADER = 0,
+	ARCHIVE_STATE_FILE_DATA,
+	ARCHIVE_STATE_EXTENDED_HEADER,
+	ARCHIVE_STATE_SKIP,
+	ARCHIVE_STATE_END
+} ArchiveState;
+
+struct _ArchiveExtractor {
+	char *root_directory;
+	uint32_t uid;
+	uint32_t gid;
+	APIE error_code; // an archive cannot be continued after an error
+	ArchiveState state;
+	uint8_t header[ARCHIVE_BLOCK_LENGTH];
+	uint32_t header_length;
+	int zero_block_count; // two consecutive zero blocks end the archive
+	uint64_t length_left; // of the data of the current state
+	uint32_t padding_length; // to skip after the data of the current entry
+	char extended_header_type; // 'L' for a GNU long name, 'x' for a pax header
+	char *extended_header; // only allocated in ARCHIVE_STATE_EXTENDED_HEADER
+	uint32_t extended_header_length;
+	char *next_name; // overrides the name in the header of the next entry
+	File *file; // only opened in ARCHIVE_STATE_FILE_DATA
+	uint32_t entry_count;
+};
+
+typedef enum {
+	ARCHIVE_CREATOR_STATE_ENTRY = 0, // the next entry has to be found
+	ARCHIVE_CREATOR_STATE_FILE_DATA,
+	ARCHIVE_CREATOR_STATE_END, // the end-of-archive blocks have to be produced
+	ARCHIVE_CREATOR_STATE_FINISHED
+} ArchiveCreatorState;
+
+typedef struct {
+	DIR *dp;
+	int name_length; // length of the directory name in the path buffer
+} ArchiveCreatorDirectory;
+
+struct _ArchiveCreator {
+	uint32_t flags;
+	APIE error_code; // an archive cannot be continued after an error
+	ArchiveCreatorState state;
+	Array directories; // open directories from the root down to the current one
+	int root_directory_length;
+	char path[PATH_MAX]; // of the current entry
+	uint8_t output[ARCHIVE_BLOCK_LENGTH * 2 + ARCHIVE_MAX_EXTENDED_HEADER_LENGTH]; // headers or padding
+	uint32_t output_offset;
+	uint32_t output_length;
+	int fd; // only opened in ARCHIVE_CREATOR_STATE_FILE_DATA
+	uint64_t length_left; // of the data of the current file
+	uint32_t padding_length; // to produce after the data of the current file
+	z_stream stream; // only initialized if ARCHIVE_FLAG_COMPRESSED is used
+	bool input_ended; // the whole tar stream was passed to deflate
+	bool stream_ended;
+	uint8_t buffer[ARCHIVE_COMPRESSION_BUFFER_LENGTH]; // tar stream input to deflate
+	uint32_t entry_count;
+};
+
+// parses an octal number or a base-256 number as used by GNU tar for
+// large values
+static bool archive_parse_number(const uint8_t *field, int length, uint64_t *value) {
+	int i = 0;
+
+	*value = 0;
+
+	if ((field[0] & 0x80) != 0) {
+		*value = field[0] & 0x7F;
+
+		for (i = 1; i < length; ++i) {
+			if (*value > (UINT64_MAX >> 8)) {
+				return false;
+			}
+
+			*value = (*value << 8) | field[i];
+		}
+
+		return true;
+	}
+
+	while (i < length && field[i] == ' ') {
+		++i;
+	}
+
+	for (; i < length && field[i] != ' ' && field[i] != '\0'; ++i) {
+		if (field[i] < '0' || field[i] > '7' || *value > (UINT64_MAX >> 3)) {
+			return false;
+		}
+
+		*value = (*value << 3) | (field[i] - '0');
+	}
+
+	return true;
+}
+
+static bool archive_is_zero_block(const uint8_t *block) {
+	int i;
+
+	for (i = 0; i < ARCHIVE_BLOCK_LENGTH; ++i) {
+		if (block[i] != 0) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// the checksum is the sum of all header bytes with the checksum field itself
+// counted as spaces
+static bool archive_verify_header_checksum(const uint8_t *header) {
+	uint64_t expected;
+	uint64_t actual = 0;
+	int i;
+
+	if (!archive_parse_number(header + 148, 8, &expected)) {
+		return false;
+	}
+
+	for (i = 0; i < ARCHIVE_BLOCK_LENGTH; ++i) {
+		actual += i >= 148 && i < 156 ? ' ' : header[i];
+	}
+
+	return actual == expected;
+}
+
+// makes the entry name relative to the root directory. returns NULL as path
+// if the entry refers to the root directory itself
+static APIE archive_extractor_get_path(ArchiveExtractor *extractor, char **path) {
+	char name[ARCHIVE_MAX_EXTENDED_HEADER_LENGTH + 1];
+	char *relative;
+	char *component;
+	char *end;
+	size_t length;
+
+	if (extractor->next_name != NULL) {
+		snprintf(name, sizeof(name), "%s", extractor->next_name);
+	} else if (memcmp(extractor->header + 257, "ustar\0", 6) == 0 && extractor->header[345] != '\0') {
+		// only POSIX ustar headers have a prefix field. GNU headers use the
+		// magic "ustar  \0" and store atime and ctime at this offset
+		snprintf(name, sizeof(name), "%.155s/%.100s",
+		         (const char *)extractor->header + 345, (const char *)extractor->header);
+	} else {
+		snprintf(name, sizeof(name), "%.100s", (const char *)extractor->header);
+	}
+
+	// strip leading slashes and ./ components, and trailing slashes
+	relative = name;
+
+	for (;;) {
+		if (*relative == '/') {
+			++relative;
+		} else if (relative[0] == '.' && (relative[1] == '/' || relative[1] == '\0')) {
+			relative += relative[1] == '/' ? 2 : 1;
+		} else {
+			break;
+		}
+	}
+
+	length = strlen(relative);
+
+	while (length > 0 && relative[length - 1] == '/') {
+		relative[--length] = '\0';
+	}
+
+	if (length == 0) {
+		*path = NULL;
+
+		return API_E_SUCCESS;
+	}
+
+	// refuse to leave the root directory
+	for (component = relative; component != NULL; component = end != NULL ? end + 1 : NULL) {
+		end = strchr(component, '/');
+
+		if ((end != NULL ? end - component : (ptrdiff_t)strlen(component)) == 2 &&
+		    component[0] == '.' && component[1] == '.') {
+			log_warn("Archive entry '%s' refers to a parent directory", relative);
+
+			return API_E_INVALID_PARAMETER;
+		}
+	}
+
+	if (asprintf(path, "%s/%s", extractor->root_directory, relative) < 0) {
+		log_error("Could not format archive entry path: %s (%d)",
+		          get_errno_name(ENOMEM), ENOMEM);
+
+		return API_E_NO_FREE_MEMORY;
+	}
+
+	return API_E_SUCCESS;
+}
+
+static APIE archive_extractor_open_file(ArchiveExtractor *extractor, char *path,
+                                        uint16_t permissions) {
+	uint32_t flags = FILE_FLAG_WRITE_ONLY | FILE_FLAG_CREATE | FILE_FLAG_REPLACE |
+	                 FILE_FLAG_NON_BLOCKING;
+	String *name;
+	APIE error_code;
+	char *p;
+
+	error_code = string_wrap(path, NULL,
+	                         OBJECT_CREATE_FLAG_INTERNAL | OBJECT_CREATE_FLAG_LOCKED,
+	                         NULL, &name);
+
+	if (error_code != API_E_SUCCESS) {
+		return error_code;
+	}
+
+	error_code = file_open(name->base.id, flags, permissions, extractor->uid,
+	                       extractor->gid, NULL, OBJECT_CREATE_FLAG_INTERNAL,
+	                       NULL, &extractor->file);
+
+	// the archive might not contain entries for all parent directories
+	if (error_code == API_E_DOES_NOT_EXIST) {
+		p = strrchr(path, '/');
+
+		*p = '\0';
+
+		error_code = directory_create(path, DIRECTORY_FLAG_RECURSIVE, 0755,
+		                              extractor->uid, extractor->gid);
+
+		*p = '/';
+
+		if (error_code == API_E_SUCCESS) {
+			error_code = file_open(name->base.id, flags, permissions, extractor->uid,
+			                       extractor->gid, NULL, OBJECT_CREATE_FLAG_INTERNAL,
+			                       NULL, &extractor->file);
+		}
+	}
+
+	string_unlock_and_release(name);
+
+	return error_code;
+}
+
+static APIE archive_extractor_handle_header(ArchiveExtractor *extractor) {
+	uint64_t length;
+	uint64_t mode;
+	char type = extractor->header[156];
+	char *path = NULL;
+	APIE error_code = API_E_SUCCESS;
+
+	if (archive_is_zero_block(extractor->header)) {
+		if (++extractor->zero_block_count == 2) {
+			log_debug("Reached end of archive after %u entries", extractor->entry_count);
+
+			extractor->state = ARCHIVE_STATE_END;
+		}
+
+		return API_E_SUCCESS;
+	}
+
+	extractor->zero_block_count = 0;
+
+	if (!archive_verify_header_checksum(extractor->header) ||
+	    !archive_parse_number(extractor->header + 124, 12, &length) ||
+	    !archive_parse_number(extractor->header + 100, 8, &mode)) {
+		log_warn("Invalid archive header after %u entries", extractor->entry_count);
+
+		return API_E_INVALID_PARAMETER;
+	}
+
+	if (length > INT64_MAX) {
+		log_warn("Archive entry length of %"PRIu64" byte(s) is out of range", length);
+
+		return API_E_OUT_OF_RANGE;
+	}
+
+	extractor->length_left = length;
+	extractor->padding_length = (ARCHIVE_BLOCK_LENGTH - length % ARCHIVE_BLOCK_LENGTH) % ARCHIVE_BLOCK_LENGTH;
+
+	// extended headers describe the next entry
+	if (type == 'L' || type == 'x') {
+		if (length > ARCHIVE_MAX_EXTENDED_HEADER_LENGTH) {
+			log_warn("Archive extended header length of %"PRIu64" byte(s) exceeds maximum of %d byte(s)",
+			         length, ARCHIVE_MAX_EXTENDED_HEADER_LENGTH);
+
+			return API_E_OUT_OF_RANGE;
+		}
+
+		extractor->extended_header = calloc(1, length + 1);
+
+		if (extractor->extended_header == NULL) {
+			log_error("Could not allocate archive extended header: %s (%d)",
+			          get_errno_name(ENOMEM), ENOMEM);
+
+			return API_E_NO_FREE_MEMORY;
+		}
+
+		extractor->extended_header_type = type;
+		extractor->extended_header_length = 0;
+		extractor->state = ARCHIVE_STATE_EXTENDED_HEADER;
+
+		return API_E_SUCCESS;
+	}
+
+	extractor->state = ARCHIVE_STATE_SKIP;
+	extractor->length_left += extractor->padding_length;
+	extractor->padding_length = 0;
+
+	switch (type) {
+	case '0':
+	case '\0':
+	case '7': // contiguous file
+		error_code = archive_extractor_get_path(extractor, &path);
+
+		if (error_code != API_E_SUCCESS) {
+			break;
+		}
+
+		if (path == NULL) {
+			log_warn("Archive contains a regular file entry without name");
+
+			error_code = API_E_INVALID_PARAMETER;
+
+			break;
+		}
+
+		error_code = archive_extractor_open_file(extractor, path, mode & FILE_PERMISSION_ALL);
+
+		if (error_code != API_E_SUCCESS) {
+			break;
+		}
+
+		log_debug("Extracting %"PRIu64" byte(s) to '%s'", length, path);
+
+		extractor->state = ARCHIVE_STATE_FILE_DATA;
+		extractor->length_left = length;
+		extractor->padding_length = (ARCHIVE_BLOCK_LENGTH - length % ARCHIVE_BLOCK_LENGTH) % ARCHIVE_BLOCK_LENGTH;
+		++extractor->entry_count;
+
+		break;
+
+	case '5':
+		error_code = archive_extractor_get_path(extractor, &path);
+
+		if (error_code != API_E_SUCCESS || path == NULL) {
+			break; // the root directory already exists
+		}
+
+		error_code = directory_create(path, DIRECTORY_FLAG_RECURSIVE,
+		                              mode & FILE_PERMISSION_ALL,
+		                              extractor->uid, extractor->gid);
+
+		if (error_code != API_E_SUCCESS) {
+			break;
+		}
+
+		log_debug("Extracted directory '%s'", path);
+
+		++extractor->entry_count;
+
+		break;
+
+	case 'g': // global pax header, nothing of interest
+		break;
+
+	default:
+		log_warn("Skipping archive entry '%.100s' of unsupported type '%c'",
+		         (const char *)extractor->header, type);
+
+		break;
+	}
+
+	free(path);
+	free(extractor->next_name);
+
+	extractor->next_name = NULL;
+
+	return error_code;
+}
+
+// a pax header consists of records in the form "<length> <key>=<value>\n"
+static APIE archive_extractor_handle_pax_header(ArchiveExtractor *extractor) {
+	char *record = extractor->extended_header;
+	char *end = record + extractor->extended_header_length;
+	char *key;
+	char *value;
+	char *record_end;
+	unsigned long length;
+
+	while (record < end) {
+		length = strtoul(record, &key, 10);
+		record_end = record + length;
+
+		if (key == record || *key != ' ' || length == 0 || record_end > end ||
+		    record_end[-1] != '\n') {
+			log_warn("Invalid archive pax header record");
+
+			return API_E_INVALID_PARAMETER;
+		}
+
+		++key;
+		value = memchr(key, '=', record_end - key);
+
+		if (value == NULL) {
+			log_warn("Invalid archive pax header record");
+
+			return API_E_INVALID_PARAMETER;
+		}
+
+		*value++ = '\0';
+		record_end[-1] = '\0';
+
+		if (strcmp(key, "path") == 0) {
+			free(extractor->next_name);
+
+			extractor->next_name = strdup(value);
+
+			if (extractor->next_name == NULL) {
+				log_error("Could not duplicate archive entry name: %s (%d)",
+				          get_errno_name(ENOMEM), ENOMEM);
+
+				return API_E_NO_FREE_MEMORY;
+			}
+		}
+
+		record = record_end;
+	}
+
+	return API_E_SUCCESS;
+}
+
+static APIE archive_extractor_handle_extended_header(ArchiveExtractor *extractor) {
+	APIE error_code = API_E_SUCCESS;
+
+	if (extractor->extended_header_type == 'L') {
+		free(extractor->next_name);
+
+		extractor->next_name = extractor->extended_header; // zero terminated by calloc
+	} else {
+		error_code = archive_extractor_handle_pax_header(extractor);
+
+		free(extractor->extended_header);
+	}
+
+	extractor->extended_header = NULL;
+
+	return error_code;
+}
+
+// moves on to the next state once the data of the current state is consumed
+static APIE archive_extractor_advance(ArchiveExtractor *extractor) {
+	APIE error_code;
+
+	while (extractor->length_left == 0) {
+		switch (extractor->state) {
+		case ARCHIVE_STATE_FILE_DATA:
+			file_release(extractor->file);
+
+			extractor->file = NULL;
+
+			break;
+
+		case ARCHIVE_STATE_EXTENDED_HEADER:
+			error_code = archive_extractor_handle_extended_header(extractor);
+
+			if (error_code != API_E_SUCCESS) {
+				return error_code;
+			}
+
+			break;
+
+		case ARCHIVE_STATE_SKIP:
+			extractor->state = ARCHIVE_STATE_HEADER;
+
+			return API_E_SUCCESS;
+
+		default:
+			return API_E_SUCCESS;
+		}
+
+		extractor->state = ARCHIVE_STATE_SKIP;
+		extractor->length_left = extractor->padding_length;
+		extractor->padding_length = 0;
+	}
+
+	return API_E_SUCCESS;
+}
+
+static APIE archive_extractor_write_file(ArchiveExtractor *extractor,
+                                         const uint8_t *buffer, uint32_t length) {
+	File *file = extractor->file;
+	APIE error_code;
+	int rc;
+
+	while (length > 0) {
+		rc = file->write(file, (void *)buffer, length);
+
+		if (rc < 0) {
+			if (errno_interrupted()) {
+				continue;
+			}
+
+			error_code = api_get_error_code_from_errno();
+
+			log_error("Could not write %u byte(s) to file object (id: %u, name: %s) while extracting archive: %s (%d)",
+			          length, file->base.id, file->name->buffer,
+			          get_errno_name(errno), errno);
+
+			return error_code;
+		}
+
+		buffer += rc;
+		length -= rc;
+	}
+
+	return API_E_SUCCESS;
+}
+
+APIE archive_extractor_create(const char *root_directory, uint32_t uid,
+                              uint32_t gid, ArchiveExtractor **extractor_) {
+	ArchiveExtractor *extractor;
+	APIE error_code;
+
+	error_code = directory_create(root_directory, DIRECTORY_FLAG_RECURSIVE,
+	                              0755, uid, gid);
+
+	if (error_code != API_E_SUCCESS) {
+		return error_code;
+	}
+
+	extractor = calloc(1, sizeof(ArchiveExtractor));
+
+	if (extractor == NULL) {
+		log_error("Could not allocate archive extractor: %s (%d)",
+		          get_errno_name(ENOMEM), ENOMEM);
+
+		return API_E_NO_FREE_MEMORY;
+	}
+
+	extractor->root_directory = strdup(root_directory);
+
+	if (extractor->root_directory == NULL) {
+		log_error("Could not duplicate archive root directory name: %s (%d)",
+		          get_errno_name(ENOMEM), ENOMEM);
+
+		free(extractor);
+
+		return API_E_NO_FREE_MEMORY;
+	}
+
+	extractor->uid = uid;
+	extractor->gid = gid;
+	extractor->error_code = API_E_SUCCESS;
+	extractor->state = ARCHIVE_STATE_HEADER;
+
+	*extractor_ = extractor;
+
+	return API_E_SUCCESS;
+}
+
+void archive_extractor_destroy(ArchiveExtractor *extractor) {
+	if (extractor->file != NULL) {
+		file_release(extractor->file);
+	}
+
+	free(extractor->extended_header);
+	free(extractor->next_name);
+	free(extractor->root_directory);
+	free(extractor);
+}
+
+APIE archive_extractor_write(ArchiveExtractor *extractor, const uint8_t *buffer,
+                             uint32_t length) {
+	uint32_t chunk;
+	APIE error_code = API_E_SUCCESS;
+
+	if (extractor->error_code != API_E_SUCCESS) {
+		return extractor->error_code;
+	}
+
+	while (length > 0 && error_code == API_E_SUCCESS) {
+		chunk = length;
+
+		switch (extractor->state) {
+		case ARCHIVE_STATE_HEADER:
+			if (chunk > ARCHIVE_BLOCK_LENGTH - extractor->header_length) {
+				chunk = ARCHIVE_BLOCK_LENGTH - extractor->header_length;
+			}
+
+			memcpy(extractor->header + extractor->header_length, buffer, chunk);
+
+			extractor->header_length += chunk;
+
+			if (extractor->header_length == ARCHIVE_BLOCK_LENGTH) {
+				extractor->header_length = 0;
+
+				error_code = archive_extractor_handle_header(extractor);
+			}
+
+			break;
+
+		case ARCHIVE_STATE_FILE_DATA:
+		case ARCHIVE_STATE_EXTENDED_HEADER:
+		case ARCHIVE_STATE_SKIP:
+			if (chunk > extractor->length_left) {
+				chunk = extractor->length_left;
+			}
+
+			if (extractor->state == ARCHIVE_STATE_FILE_DATA) {
+				error_code = archive_extractor_write_file(extractor, buffer, chunk);
+			} else if (extractor->state == ARCHIVE_STATE_EXTENDED_HEADER) {
+				memcpy(extractor->extended_header + extractor->extended_header_length,
+				       buffer, chunk);
+
+				extractor->extended_header_length += chunk;
+			}
+
+			extractor->length_left -= chunk;
+
+			break;
+
+		default: // ignore the zero padding after the end of the archive
+			break;
+		}
+
+		buffer += chunk;
+		length -= chunk;
+
+		if (error_code == API_E_SUCCESS && extractor->state != ARCHIVE_STATE_HEADER) {
+			error_code = archive_extractor_advance(extractor);
+		}
+	}
+
+	// the position in the archive is unknown after an error
+	if (error_code != API_E_SUCCESS) {
+		extractor->error_code = error_code;
+	}
+
+	return error_code;
+}
+
+bool archive_extractor_is_finished(ArchiveExtractor *extractor) {
+	return extractor->state == ARCHIVE_STATE_END;
+}
+
+uint32_t archive_extractor_get_entry_count(ArchiveExtractor *extractor) {
+	return extractor->entry_count;
+}
+
+// stores an octal number with a terminating NUL if it fits, otherwise a
+// base-256 number as used by GNU tar for large values
+static void archive_put_number(uint8_t *field, int length, uint64_t value) {
+	char buffer[24]; // 22 octal digits for 64 bit plus NUL
+	int i;
+
+	if (value < (uint64_t)1 << (3 * (length - 1))) {
+		snprintf(buffer, sizeof(buffer), "%0*"PRIo64, length - 1, value);
+		memcpy(field, buffer, length); // length - 1 digits plus NUL
+
+		return;
+	}
+
+	for (i = length - 1; i > 0; --i) {
+		field[i] = value & 0xFF;
+		value >>= 8;
+	}
+
+	field[0] = 0x80;
+}
+
+static void archive_creator_put_header_block(ArchiveCreator *creator, const char *name,
+                                             char type, const struct stat *st,
+                                             uint64_t size, const char *link_name) {
+	uint8_t *header = creator->output + creator->output_length;
+	uint32_t checksum = 0;
+	int i;
+
+	memset(header, 0, ARCHIVE_BLOCK_LENGTH);
+
+	memcpy(header, name, MIN(strlen(name), 100));
+	archive_put_number(header + 100, 8, st->st_mode & 07777);
+	archive_put_number(header + 108, 8, st->st_uid);
+	archive_put_number(header + 116, 8, st->st_gid);
+	archive_put_number(header + 124, 12, size);
+	archive_put_number(header + 136, 12, st->st_mtime > 0 ? (uint64_t)st->st_mtime : 0);
+
+	header[156] = type;
+
+	if (link_name != NULL) {
+		memcpy(header + 157, link_name, MIN(strlen(link_name), 100));
+	}
+
+	memcpy(header + 257, "ustar  ", 8); // GNU magic and version
+
+	for (i = 0; i < ARCHIVE_BLOCK_LENGTH; ++i) {
+		checksum += i >= 148 && i < 156 ? ' ' : header[i];
+	}
+
+	snprintf((char *)header + 148, 8, "%06o", checksum);
+
+	header[155] = ' ';
+
+	creator->output_length += ARCHIVE_BLOCK_LENGTH;
+}
+
+// puts a GNU long name header followed by the name before the actual header,
+// if the name doesn't fit into the header
+static void archive_creator_put_header(ArchiveCreator *creator, const char *name,
+                                       char type, const struct stat *st,
+                                       uint64_t size, const char *link_name) {
+	uint32_t length = strlen(name) + 1;
+	uint32_t padded_length = (length + ARCHIVE_BLOCK_LENGTH - 1) / ARCHIVE_BLOCK_LENGTH * ARCHIVE_BLOCK_LENGTH;
+
+	if (length > 100) {
+		archive_creator_put_header_block(creator, "././@LongLink", 'L', st, length, NULL);
+
+		memset(creator->output + creator->output_length, 0, padded_length);
+		memcpy(creator->output + creator->output_length, name, length);
+
+		creator->output_length += padded_length;
+	}
+
+	archive_creator_put_header_block(creator, name, type, st, size, link_name);
+}
+
+static void archive_creator_close_directory(void *item) {
+	ArchiveCreatorDirectory *directory = item;
+
+	closedir(directory->dp);
+}
+
+// finds the next entry of the directory tree and puts its header into the
+// output buffer. entries that vanish while the archive is created, e.g. by
+// log rotation, are skipped
+static APIE archive_creator_next_entry(ArchiveCreator *creator) {
+	ArchiveCreatorDirectory *directory;
+	struct dirent *dirent;
+	int name_length;
+	const char *relative;
+	struct stat st;
+	char name[PATH_MAX + 1]; // for trailing /
+	char link_name[ARCHIVE_MAX_LINK_NAME_LENGTH + 1];
+	ssize_t link_name_length;
+	DIR *dp;
+	int fd;
+	APIE error_code;
+
+	creator->output_offset = 0;
+	creator->output_length = 0;
+
+	for (;;) {
+		if (creator->directories.count == 0) {
+			creator->state = ARCHIVE_CREATOR_STATE_END;
+
+			return API_E_SUCCESS;
+		}
+
+		directory = array_get(&creator->directories, creator->directories.count - 1);
+
+		errno = 0;
+		dirent = readdir(directory->dp);
+
+		if (dirent == NULL) {
+			if (errno != 0) {
+				error_code = api_get_error_code_from_errno();
+
+				log_error("Could not get next entry of directory '%.*s' while creating archive: %s (%d)",
+				          directory->name_length, creator->path,
+				          get_errno_name(errno), errno);
+
+				return error_code;
+			}
+
+			array_remove(&creator->directories, creator->directories.count - 1,
+			             archive_creator_close_directory);
+
+			continue;
+		}
+
+		if (strcmp(dirent->d_name, ".") == 0 || strcmp(dirent->d_name, "..") == 0) {
+			continue;
+		}
+
+		name_length = directory->name_length + 1 + strlen(dirent->d_name);
+
+		if (name_length >= (int)sizeof(creator->path)) {
+			log_warn("Skipping entry '%s' of directory '%.*s' while creating archive, its name is too long",
+			         dirent->d_name, directory->name_length, creator->path);
+
+			continue;
+		}
+
+		creator->path[directory->name_length] = '/';
+
+		strcpy(creator->path + directory->name_length + 1, dirent->d_name);
+
+		relative = creator->path + creator->root_directory_length + 1;
+
+		if (lstat(creator->path, &st) < 0) {
+			if (errno == ENOENT) {
+				continue;
+			}
+
+			error_code = api_get_error_code_from_errno();
+
+			log_error("Could not get status of '%s' while creating archive: %s (%d)",
+			          creator->path, get_errno_name(errno), errno);
+
+			return error_code;
+		}
+
+		if (S_ISDIR(st.st_mode)) {
+			dp = opendir(creator->path);
+
+			if (dp == NULL) {
+				if (errno == ENOENT) {
+					continue;
+				}
+
+				error_code = api_get_error_code_from_errno();
+
+				log_error("Could not open directory '%s' while creating archive: %s (%d)",
+				          creator->path, get_errno_name(errno), errno);
+
+				return error_code;
+			}
+
+			directory = array_append(&creator->directories);
+
+			if (directory == NULL) {
+				error_code = api_get_error_code_from_errno();
+
+				log_error("Could not append to directory array while creating archive: %s (%d)",
+				          get_errno_name(errno), errno);
+
+				closedir(dp);
+
+				return error_code;
+			}
+
+			directory->dp = dp;
+			directory->name_length = name_length;
+
+			snprintf(name, sizeof(name), "%s/", relative);
+
+			archive_creator_put_header(creator, name, '5', &st, 0, NULL);
+		} else if (S_ISREG(st.st_mode)) {
+			fd = open(creator->path, O_RDONLY | O_CLOEXEC);
+
+			if (fd < 0) {
+				if (errno == ENOENT) {
+					continue;
+				}
+
+				error_code = api_get_error_code_from_errno();
+
+				log_error("Could not open file '%s' while creating archive: %s (%d)",
+				          creator->path, get_errno_name(errno), errno);
+
+				return error_code;
+			}
+
+			archive_creator_put_header(creator, relative, '0', &st, st.st_size, NULL);
+
+			creator->state = ARCHIVE_CREATOR_STATE_FILE_DATA;
+			creator->fd = fd;
+			creator->length_left = st.st_size;
+			creator->padding_length = (ARCHIVE_BLOCK_LENGTH - st.st_size % ARCHIVE_BLOCK_LENGTH) % ARCHIVE_BLOCK_LENGTH;
+		} else if (S_ISLNK(st.st_mode)) {
+			link_name_length = readlink(creator->path, link_name, sizeof(link_name));
+
+			if (link_name_length < 0) {
+				if (errno == ENOENT) {
+					continue;
+				}
+
+				error_code = api_get_error_code_from_errno();
+
+				log_error("Could not read symlink '%s' while creating archive: %s (%d)",
+				          creator->path, get_errno_name(errno), errno);
+
+				return error_code;
+			}
+
+			if (link_name_length > ARCHIVE_MAX_LINK_NAME_LENGTH) {
+				log_warn("Skipping symlink '%s' while creating archive, its target name is too long",
+				         creator->path);
+
+				continue;
+			}
+
+			link_name[link_name_length] = '\0';
+
+			archive_creator_put_header(creator, relative, '2', &st, 0, link_name);
+		} else {
+			log_debug("Skipping special file '%s' while creating archive", creator->path);
+
+			continue;
+		}
+
+		++creator->entry_count;
+
+		return API_E_SUCCESS;
+	}
+}
+
+// produces the next part of the uncompressed tar stream. produces less than
+// length bytes only at the end of the archive
+static APIE archive_creator_produce(ArchiveCreator *creator, uint8_t *buffer,
+                                   uint32_t length, uint32_t *length_produced) {
+	uint32_t chunk;
+	int rc;
+	APIE error_code;
+
+	*length_produced = 0;
+
+	while (length > 0) {
+		if (creator->output_offset < creator->output_length) {
+			chunk = MIN(length, creator->output_length - creator->output_offset);
+
+			memcpy(buffer, creator->output + creator->output_offset, chunk);
+
+			creator->output_offset += chunk;
+		} else if (creator->state == ARCHIVE_CREATOR_STATE_FILE_DATA) {
+			if (creator->length_left == 0) {
+				close(creator->fd);
+
+				creator->fd = -1;
+				creator->state = ARCHIVE_CREATOR_STATE_ENTRY;
+				creator->output_offset = 0;
+				creator->output_length = creator->padding_length;
+
+				memset(creator->output, 0, creator->padding_length);
+
+				continue;
+			}
+
+			chunk = MIN(length, creator->length_left);
+			rc = robust_read(creator->fd, buffer, chunk);
+
+			if (rc < 0) {
+				error_code = api_get_error_code_from_errno();
+
+				log_error("Could not read from file '%s' while creating archive: %s (%d)",
+				          creator->path, get_errno_name(errno), errno);
+
+				return error_code;
+			}
+
+			if (rc == 0) {
+				// the file was truncated after its header was produced. the
+				// header cannot be changed anymore, fill up with zeros instead
+				log_warn("File '%s' was truncated while creating archive, filling up %"PRIu64" byte(s) with zeros",
+				         creator->path, creator->length_left);
+
+				memset(buffer, 0, chunk);
+			} else {
+				chunk = rc;
+			}
+
+			creator->length_left -= chunk;
+		} else if (creator->state == ARCHIVE_CREATOR_STATE_ENTRY) {
+			error_code = archive_creator_next_entry(creator);
+
+			if (error_code != API_E_SUCCESS) {
+				return error_code;
+			}
+
+			continue;
+		} else if (creator->state == ARCHIVE_CREATOR_STATE_END) {
+			creator->state = ARCHIVE_CREATOR_STATE_FINISHED;
+			creator->output_offset = 0;
+			creator->output_length = ARCHIVE_BLOCK_LENGTH * 2;
+
+			memset(creator->output, 0, creator->output_length);
+
+			continue;
+		} else {
+			break;
+		}
+
+		buffer += chunk;
+		length -= chunk;
+		*length_produced += chunk;
+	}
+
+	return API_E_SUCCESS;
+}
+
+static APIE archive_creator_compress(ArchiveCreator *creator, uint8_t *buffer,
+                                     uint32_t length, uint32_t *length_read) {
+	z_stream *stream = &creator->stream;
+	uint32_t length_produced;
+	APIE error_code;
+	int rc;
+
+	stream->next_out = buffer;
+	stream->avail_out = length;
+
+	while (stream->avail_out > 0 && !creator->stream_ended) {
+		if (stream->avail_in == 0 && !creator->input_ended) {
+			error_code = archive_creator_produce(creator, creator->buffer,
+			                                     sizeof(creator->buffer),
+			                                     &length_produced);
+
+			if (error_code != API_E_SUCCESS) {
+				return error_code;
+			}
+
+			creator->input_ended = length_produced < sizeof(creator->buffer);
+
+			stream->next_in = creator->buffer;
+			stream->avail_in = length_produced;
+		}
+
+		rc = deflate(stream, creator->input_ended ? Z_FINISH : Z_NO_FLUSH);
+
+		if (rc == Z_STREAM_END) {
+			creator->stream_ended = true;
+		} else if (rc != Z_OK && rc != Z_BUF_ERROR) {
+			log_error("Could not compress archive: %s (%d)",
+			          stream->msg != NULL ? stream->msg : "<unknown>", rc);
+
+			return API_E_INTERNAL_ERROR;
+		}
+	}
+
+	*length_read = length - stream->avail_out;
+
+	return API_E_SUCCESS;
+}
+
+APIE archive_creator_create(const char *root_directory, uint32_t flags,
+                            ArchiveCreator **creator_) {
+	int phase = 0;
+	APIE error_code;
+	int length = strlen(root_directory);
+	ArchiveCreator *creator;
+	DIR *dp;
+	ArchiveCreatorDirectory *directory;
+
+	if ((flags & ~ARCHIVE_FLAG_ALL) != 0) {
+		log_warn("Invalid archive flags 0x%04X", flags);
+
+		return API_E_INVALID_PARAMETER;
+	}
+
+	// strip trailing slashes, the entry names are appended with a slash
+	while (length > 0 && root_directory[length - 1] == '/') {
+		--length;
+	}
+
+	if (length >= PATH_MAX) {
+		log_warn("Archive root directory name '%s' is too long", root_directory);
+
+		return API_E_NAME_TOO_LONG;
+	}
+
+	creator = calloc(1, sizeof(ArchiveCreator));
+
+	if (creator == NULL) {
+		error_code = API_E_NO_FREE_MEMORY;
+
+		log_error("Could not allocate archive creator: %s (%d)",
+		          get_errno_name(ENOMEM), ENOMEM);
+
+		goto cleanup;
+	}
+
+	phase = 1;
+
+	if ((flags & ARCHIVE_FLAG_COMPRESSED) != 0) {
+		// 15 + 16 selects the maximum window size with a gzip wrapper
+		if (deflateInit2(&creator->stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+		                 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+			error_code = API_E_NO_FREE_MEMORY;
+
+			log_error("Could not initialize archive compression");
+
+			goto cleanup;
+		}
+	}
+
+	phase = 2;
+
+	dp = opendir(root_directory);
+
+	if (dp == NULL) {
+		error_code = api_get_error_code_from_errno();
+
+		log_warn("Could not open archive root directory '%s': %s (%d)",
+		         root_directory, get_errno_name(errno), errno);
+
+		goto cleanup;
+	}
+
+	phase = 3;
+
+	if (array_create(&creator->directories, 16, sizeof(ArchiveCreatorDirectory), true) < 0) {
+		error_code = api_get_error_code_from_errno();
+
+		log_error("Could not create directory array: %s (%d)",
+		          get_errno_name(errno), errno);
+
+		goto cleanup;
+	}
+
+	phase = 4;
+
+	directory = array_append(&creator->directories);
+
+	if (directory == NULL) {
+		error_code = api_get_error_code_from_errno();
+
+		log_error("Could not append to directory array: %s (%d)",
+		          get_errno_name(errno), errno);
+
+		goto cleanup;
+	}
+
+	directory->dp = dp;
+	directory->name_length = length;
+
+	memcpy(creator->path, root_directory, length);
+
+	creator->path[length] = '\0';
+	creator->flags = flags;
+	creator->error_code = API_E_SUCCESS;
+	creator->state = ARCHIVE_CREATOR_STATE_ENTRY;
+	creator->root_directory_length = length;
+	creator->fd = -1;
+
+	*creator_ = creator;
+
+	phase = 5;
+
+cleanup:
+	switch (phase) { // no breaks, all cases fall through intentionally
+	case 4:
+		array_destroy(&creator->directories, NULL);
+		// fall through
+
+	case 3:
+		closedir(dp);
+		// fall through
+
+	case 2:
+		if ((flags & ARCHIVE_FLAG_COMPRESSED) != 0) {
+			deflateEnd(&creator->stream);
+		}
+
+		// fall through
+
+	case 1:
+		free(creator);
+		// fall through
+
+	default:
+		break;
+	}
+
+	return phase == 5 ? API_E_SUCCESS : error_code;
+}
+
+void archive_creator_destroy(ArchiveCreator *creator) {
+	if (creator->fd >= 0) {
+		close(creator->fd);
+	}
+
+	if ((creator->flags & ARCHIVE_FLAG_COMPRESSED) != 0) {
+		deflateEnd(&creator->stream);
+	}
+
+	array_destroy(&creator->directories, archive_creator_close_directory);
+	free(creator);
+}
+
+// a length_read of zero means the end of the archive was reached
+APIE archive_creator_read(ArchiveCreator *creator, uint8_t *buffer,
+                          uint32_t length, uint32_t *length_read) {
+	APIE error_code;
+
+	if (creator->error_code != API_E_SUCCESS) {
+		return creator->error_code;
+	}
+
+	if ((creator->flags & ARCHIVE_FLAG_COMPRESSED) != 0) {
+		error_code = archive_creator_compress(creator, buffer, length, length_read);
+	} else {
+		error_code = archive_creator_produce(creator, buffer, length, length_read);
+	}
+
+	// the position in the archive is unknown after an error
+	if (error_code != API_E_SUCCESS) {
+		creator->error_code = error_code;
+	}
+
+	return error_code;
+}
+
+bool archive_creator_is_finished(ArchiveCreator *creator) {
+	if ((creator->flags & ARCHIVE_FLAG_COMPRESSED) != 0) {
+		return creator->stream_ended;
+	}
+
+	return creator->state == ARCHIVE_CREATOR_STATE_FINISHED &&
+	       creator->output_offset == creator->output_length;
+}
+
+uint32_t archive_creator_get_entry_count(ArchiveCreator *creator) {
+	return creator->entry_count;
+}
@@ -0,0 +1,59 @@
+/*
+ * redapid
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * archive.h: Streaming tar archive extraction and creation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef REDAPID_ARCHIVE_H
+#define REDAPID_ARCHIVE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "api_error.h"
+
+typedef enum { // bitmask
+	ARCHIVE_FLAG_COMPRESSED = 0x0001 // gzip compressed
+} ArchiveFlag;
+
+#define ARCHIVE_FLAG_ALL ARCHIVE_FLAG_COMPRESSED
+
+typedef struct _ArchiveExtractor ArchiveExtractor;
+typedef struct _ArchiveCreator ArchiveCreator;
+
+APIE archive_extractor_create(const char *root_directory, uint32_t uid,
+                              uint32_t gid, ArchiveExtractor **extractor);
+void archive_extractor_destroy(ArchiveExtractor *extractor);
+
+APIE archive_extractor_write(ArchiveExtractor *extractor, const uint8_t *buffer,
+                             uint32_t length);
+
+bool archive_extractor_is_finished(ArchiveExtractor *extractor);
+uint32_t archive_extractor_get_entry_count(ArchiveExtractor *extractor);
+
+APIE archive_creator_create(const char *root_directory, uint32_t flags,
+                            ArchiveCreator **creator);
+void archive_creator_destroy(ArchiveCreator *creator);
+
+APIE archive_creator_read(ArchiveCreator *creator, uint8_t *buffer,
+                          uint32_t length, uint32_t *length_read);
+
+bool archive_creator_is_finished(ArchiveCreator *creator);
+uint32_t archive_creator_get_entry_count(ArchiveCreator *creator);
+
+#endif // REDAPID_ARCHIVE_H
@@ -0,0 +1,139 @@
+/*
+ * redapid
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * background_job.c: Incremental work done in the event loop
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * work that could block the event loop too long if done in one go, such as
+ * checksumming or copying a large file, is split into bounded steps. all
+ * running background jobs share one eventfd that is always readable. each
+ * time it is polled one step of each running job is done, so concurrent jobs
+ * progress evenly and other event sources are handled in between. the eventfd
+ * is only created and added to the event loop while at least one job runs.
+ *
+ * a step function may stop its own job or any other job, the iteration over
+ * the running jobs continues with the job following the stopped one.
+ */
+
+#include <errno.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <daemonlib/event.h>
+#include <daemonlib/log.h>
+#include <daemonlib/utils.h>
+
+#include "background_job.h"
+
+static LogSource _log_source = LOG_SOURCE_INITIALIZER;
+
+static Node _sentinel = { &_sentinel, &_sentinel };
+static Node *_next = NULL; // next job to step, only valid while stepping
+static IOHandle _eventfd = IO_HANDLE_INVALID;
+
+static void background_job_handle_event(void *opaque) {
+	Node *node = _sentinel.next;
+	BackgroundJob *job;
+
+	(void)opaque;
+
+	while (node != &_sentinel) {
+		job = containerof(node, BackgroundJob, node);
+		_next = node->next;
+
+		job->function(job->opaque);
+
+		node = _next;
+	}
+
+	_next = NULL;
+}
+
+void background_job_create(BackgroundJob *job, BackgroundJobFunction function, void *opaque) {
+	node_reset(&job->node);
+
+	job->running = false;
+	job->function = function;
+	job->opaque = opaque;
+}
+
+// sets errno on error
+int background_job_start(BackgroundJob *job) {
+	int saved_errno;
+
+	if (job->running) {
+		return 0;
+	}
+
+	if (_eventfd == IO_HANDLE_INVALID) {
+		_eventfd = eventfd(1, EFD_NONBLOCK);
+
+		if (_eventfd < 0) {
+			saved_errno = errno;
+
+			log_error("Could not create background job eventfd: %s (%d)",
+			          get_errno_name(errno), errno);
+
+			_eventfd = IO_HANDLE_INVALID;
+			errno = saved_errno;
+
+			return -1;
+		}
+
+		if (event_add_source(_eventfd, EVENT_SOURCE_TYPE_GENERIC,
+		                     "background-job", EVENT_READ,
+		                     background_job_handle_event, NULL) < 0) {
+			saved_errno = errno;
+
+			close(_eventfd);
+
+			_eventfd = IO_HANDLE_INVALID;
+			errno = saved_errno;
+
+			return -1;
+		}
+	}
+
+	job->running = true;
+
+	node_insert_before(&_sentinel, &job->node);
+
+	return 0;
+}
+
+void background_job_stop(BackgroundJob *job) {
+	if (!job->running) {
+		return;
+	}
+
+	job->running = false;
+
+	if (_next == &job->node) {
+		_next = job->node.next;
+	}
+
+	node_remove(&job->node);
+
+	if (_sentinel.next == &_sentinel) {
+		event_remove_source(_eventfd, EVENT_SOURCE_TYPE_GENERIC);
+		close(_eventfd);
+
+		_eventfd = IO_HANDLE_INVALID;
+	}
+}
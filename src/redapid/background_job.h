@@ -0,0 +1,43 @@
+/*
+ * redapid
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * background_job.h: Incremental work done in the event loop
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef REDAPID_BACKGROUND_JOB_H
+#define REDAPID_BACKGROUND_JOB_H
+
+#include <stdbool.h>
+
+#include <daemonlib/node.h>
+
+typedef void (*BackgroundJobFunction)(void *opaque);
+
+typedef struct {
+	Node node; // in the list of running background jobs, if running
+	bool running;
+	BackgroundJobFunction function; // does one bounded step of the job
+	void *opaque;
+} BackgroundJob;
+
+void background_job_create(BackgroundJob *job, BackgroundJobFunction function, void *opaque);
+
+int background_job_start(BackgroundJob *job);
+void background_job_stop(BackgroundJob *job);
+
+#endif // REDAPID_BACKGROUND_JOB_H
@@ -0,0 +1,270 @@
+/*
+ * redapid
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * checksum.c: Incremental CRC32 and SHA-256 checksums, rolling checksum
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * CRC32 uses the IEEE 802.3 polynomial in reflected form, as used by zlib,
+ * gzip and PNG. SHA-256 follows FIPS 180-4. both are computed incrementally,
+ * so large files can be fed in chunks. the digests are stored in big-endian
+ * byte order, matching their usual hex notation.
+ *
+ * the rolling checksum is the weak block checksum used by rsync. it can be
+ * moved forward by one byte in constant time, so a client can cheaply search
+ * for blocks of an existing file at every byte offset of a new file.
+ */
+
+#include <string.h>
+
+#include "checksum.h"
+
+static uint32_t _crc32_table[256];
+static bool _crc32_table_initialized = false;
+
+static const uint32_t _sha256_k[64] = {
+	0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+	0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+	0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+	0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+	0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+	0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+	0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+	0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2
+};
+
+static const uint32_t _sha256_initial_state[8] = {
+	0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19
+};
+
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void checksum_init_crc32_table(void) {
+	uint32_t crc;
+	int i;
+	int k;
+
+	for (i = 0; i < 256; ++i) {
+		crc = i;
+
+		for (k = 0; k < 8; ++k) {
+			crc = (crc & 1) != 0 ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+		}
+
+		_crc32_table[i] = crc;
+	}
+
+	_crc32_table_initialized = true;
+}
+
+static void checksum_put_uint32_be(uint8_t *buffer, uint32_t value) {
+	buffer[0] = value >> 24;
+	buffer[1] = value >> 16;
+	buffer[2] = value >> 8;
+	buffer[3] = value;
+}
+
+static void checksum_sha256_transform(Checksum *checksum, const uint8_t *block) {
+	uint32_t w[64];
+	uint32_t s[8];
+	uint32_t t1, t2;
+	int i;
+
+	for (i = 0; i < 16; ++i) {
+		w[i] = (uint32_t)block[i * 4] << 24 | (uint32_t)block[i * 4 + 1] << 16 |
+		       (uint32_t)block[i * 4 + 2] << 8 | (uint32_t)block[i * 4 + 3];
+	}
+
+	for (i = 16; i < 64; ++i) {
+		w[i] = w[i - 16] + (ROTR(w[i - 15], 7) ^ ROTR(w[i - 15], 18) ^ (w[i - 15] >> 3)) +
+		       w[i - 7] + (ROTR(w[i - 2], 17) ^ ROTR(w[i - 2], 19) ^ (w[i - 2] >> 10));
+	}
+
+	memcpy(s, checksum->sha256_state, sizeof(s));
+
+	for (i = 0; i < 64; ++i) {
+		t1 = s[7] + (ROTR(s[4], 6) ^ ROTR(s[4], 11) ^ ROTR(s[4], 25)) +
+		     ((s[4] & s[5]) ^ (~s[4] & s[6])) + _sha256_k[i] + w[i];
+		t2 = (ROTR(s[0], 2) ^ ROTR(s[0], 13) ^ ROTR(s[0], 22)) +
+		     ((s[0] & s[1]) ^ (s[0] & s[2]) ^ (s[1] & s[2]));
+
+		s[7] = s[6];
+		s[6] = s[5];
+		s[5] = s[4];
+		s[4] = s[3] + t1;
+		s[3] = s[2];
+		s[2] = s[1];
+		s[1] = s[0];
+		s[0] = t1 + t2;
+	}
+
+	for (i = 0; i < 8; ++i) {
+		checksum->sha256_state[i] += s[i];
+	}
+}
+
+bool checksum_is_valid_algorithm(uint8_t algorithm) {
+	switch (algorithm) {
+	case CHECKSUM_ALGORITHM_CRC32:
+	case CHECKSUM_ALGORITHM_SHA256:
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+const char *checksum_get_algorithm_name(ChecksumAlgorithm algorithm) {
+	switch (algorithm) {
+	case CHECKSUM_ALGORITHM_CRC32:  return "CRC32";
+	case CHECKSUM_ALGORITHM_SHA256: return "SHA-256";
+
+	default:                        return "<unknown>";
+	}
+}
+
+void checksum_init(Checksum *checksum, ChecksumAlgorithm algorithm) {
+	checksum->algorithm = algorithm;
+
+	if (algorithm == CHECKSUM_ALGORITHM_CRC32) {
+		if (!_crc32_table_initialized) {
+			checksum_init_crc32_table();
+		}
+
+		checksum->crc32 = 0xFFFFFFFF;
+	} else {
+		memcpy(checksum->sha256_state, _sha256_initial_state, sizeof(checksum->sha256_state));
+
+		checksum->sha256_block_length = 0;
+		checksum->sha256_total_length = 0;
+	}
+}
+
+void checksum_update(Checksum *checksum, const void *buffer, uint32_t length) {
+	const uint8_t *bytes = buffer;
+	uint32_t crc;
+	uint32_t chunk;
+
+	if (checksum->algorithm == CHECKSUM_ALGORITHM_CRC32) {
+		crc = checksum->crc32;
+
+		while (length-- > 0) {
+			crc = _crc32_table[(crc ^ *bytes++) & 0xFF] ^ (crc >> 8);
+		}
+
+		checksum->crc32 = crc;
+
+		return;
+	}
+
+	checksum->sha256_total_length += length;
+
+	// fill up a partial block first, then transform full blocks directly
+	// from the buffer and keep the rest for the next update
+	if (checksum->sha256_block_length > 0) {
+		chunk = sizeof(checksum->sha256_block) - checksum->sha256_block_length;
+
+		if (chunk > length) {
+			chunk = length;
+		}
+
+		memcpy(checksum->sha256_block + checksum->sha256_block_length, bytes, chunk);
+
+		checksum->sha256_block_length += chunk;
+		bytes += chunk;
+		length -= chunk;
+
+		if (checksum->sha256_block_length < sizeof(checksum->sha256_block)) {
+			return;
+		}
+
+		checksum_sha256_transform(checksum, checksum->sha256_block);
+
+		checksum->sha256_block_length = 0;
+	}
+
+	while (length >= sizeof(checksum->sha256_block)) {
+		checksum_sha256_transform(checksum, bytes);
+
+		bytes += sizeof(checksum->sha256_block);
+		length -= sizeof(checksum->sha256_block);
+	}
+
+	memcpy(checksum->sha256_block, bytes, length);
+
+	checksum->sha256_block_length = length;
+}
+
+// stores the digest in big-endian byte order and returns its length
+uint8_t checksum_finish(Checksum *checksum, uint8_t *digest) {
+	uint64_t bit_length;
+	int i;
+
+	if (checksum->algorithm == CHECKSUM_ALGORITHM_CRC32) {
+		checksum_put_uint32_be(digest, checksum->crc32 ^ 0xFFFFFFFF);
+
+		return 4;
+	}
+
+	bit_length = checksum->sha256_total_length * 8;
+
+	// append the 0x80 terminator and zero padding, then the message length
+	// in bits into the last 8 bytes of the last block
+	checksum->sha256_block[checksum->sha256_block_length++] = 0x80;
+
+	if (checksum->sha256_block_length > sizeof(checksum->sha256_block) - 8) {
+		memset(checksum->sha256_block + checksum->sha256_block_length, 0,
+		       sizeof(checksum->sha256_block) - checksum->sha256_block_length);
+
+		checksum_sha256_transform(checksum, checksum->sha256_block);
+
+		checksum->sha256_block_length = 0;
+	}
+
+	memset(checksum->sha256_block + checksum->sha256_block_length, 0,
+	       sizeof(checksum->sha256_block) - 8 - checksum->sha256_block_length);
+
+	checksum_put_uint32_be(checksum->sha256_block + 56, bit_length >> 32);
+	checksum_put_uint32_be(checksum->sha256_block + 60, bit_length);
+
+	checksum_sha256_transform(checksum, checksum->sha256_block);
+
+	for (i = 0; i < 8; ++i) {
+		checksum_put_uint32_be(digest + i * 4, checksum->sha256_state[i]);
+	}
+
+	return 32;
+}
+
+// a is the sum of all bytes, b is the sum of all bytes weighted by their
+// distance to the end of the block plus one. both are kept modulo 2^16. to
+// move a block of length n forward by one byte, dropping x and adding y:
+// a' = a - x + y and b' = b - n * x + a'
+uint32_t checksum_get_rolling(const void *buffer, uint32_t length) {
+	const uint8_t *bytes = buffer;
+	uint32_t a = 0;
+	uint32_t b = 0;
+	uint32_t i;
+
+	for (i = 0; i < length; ++i) {
+		a += bytes[i];
+		b += (length - i) * bytes[i];
+	}
+
+	return (a & 0xFFFF) | (b << 16);
+}
@@ -0,0 +1,53 @@
+/*
+ * redapid
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * checksum.h: Incremental CRC32 and SHA-256 checksums, rolling checksum
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef REDAPID_CHECKSUM_H
+#define REDAPID_CHECKSUM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum {
+	CHECKSUM_ALGORITHM_CRC32 = 0,
+	CHECKSUM_ALGORITHM_SHA256
+} ChecksumAlgorithm;
+
+#define CHECKSUM_MAX_LENGTH 32
+
+typedef struct {
+	ChecksumAlgorithm algorithm;
+	uint32_t crc32;
+	uint32_t sha256_state[8];
+	uint8_t sha256_block[64];
+	uint32_t sha256_block_length;
+	uint64_t sha256_total_length;
+} Checksum;
+
+bool checksum_is_valid_algorithm(uint8_t algorithm);
+const char *checksum_get_algorithm_name(ChecksumAlgorithm algorithm);
+
+void checksum_init(Checksum *checksum, ChecksumAlgorithm algorithm);
+void checksum_update(Checksum *checksum, const void *buffer, uint32_t length);
+uint8_t checksum_finish(Checksum *checksum, uint8_t *digest);
+
+uint32_t checksum_get_rolling(const void *buffer, uint32_t length);
+
+#endif // REDAPID_CHECKSUM_H
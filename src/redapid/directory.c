@@ -20,18 +20,23 @@
  */
 
 #include <errno.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <inttypes.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
+#include <daemonlib/array.h>
 #include <daemonlib/log.h>
 #include <daemonlib/utils.h>
 
 #include "directory.h"
 
 #include "api.h"
+#include "background_job.h"
 #include "file.h"
 #include "inventory.h"
 #include "process.h"
@@ -39,14 +44,62 @@
 
 static LogSource _log_source = LOG_SOURCE_INITIALIZER;
 
+#define DIRECTORY_MAX_OPEN_DEPTH 64 // limits the number of open directories per walk or operation
+#define DIRECTORY_MAX_ENTRIES_PER_CALL 4096
+#define DIRECTORY_OPERATION_ENTRIES_PER_STEP 256
+#define DIRECTORY_OPERATION_PROGRESS_INTERVAL 4096 // entries between two progress callbacks
+
+struct _DirectoryWalk {
+	Array levels; // open subdirectories below the root directory, from the top down
+	uint16_t max_depth; // number of directory levels to walk, 0 means no limit
+	char *include_patterns; // NULL-separated, only allocated if there are patterns
+	int include_pattern_count;
+	char *exclude_patterns;
+	int exclude_pattern_count;
+};
+
+typedef enum {
+	DIRECTORY_OPERATION_TYPE_REMOVE = 0,
+	DIRECTORY_OPERATION_TYPE_DISK_USAGE
+} DirectoryOperationType;
+
+typedef struct {
+	DIR *dp;
+	char *name; // relative to the parent directory, NULL for the root directory
+} DirectoryOperationLevel;
+
+typedef struct {
+	BackgroundJob job;
+	DirectoryOperationType type;
+	String *name;
+	bool started;
+	bool recursive;
+	Array levels; // open directories from the root directory down to the current one
+	uint64_t entry_count;
+	uint64_t length; // sum of the lengths, only for DIRECTORY_OPERATION_TYPE_DISK_USAGE
+	uint64_t allocated_length; // sum of the allocated blocks, as reported by du
+	uint64_t next_progress_entry_count;
+} DirectoryOperation;
+
+static void directory_walk_close_level(void *item) {
+	closedir(*(DIR **)item);
+}
+
 static void directory_destroy(Object *object) {
 	Directory *directory = (Directory *)object;
 
+	if (directory->walk != NULL) {
+		array_destroy(&directory->walk->levels, directory_walk_close_level);
+		free(directory->walk->include_patterns);
+		free(directory->walk->exclude_patterns);
+		free(directory->walk);
+	}
+
 	closedir(directory->dp);
 
 	string_unlock_and_release(directory->name);
 
-	free(directory);
+	inventory_free_object(OBJECT_TYPE_DIRECTORY, directory);
 }
 
 static void directory_signature(Object *object, char *signature) {
@@ -56,6 +109,39 @@ static void directory_signature(Object *object, char *signature) {
 	         directory->name->buffer);
 }
 
+static uint8_t directory_get_entry_type_from_dirent_type(unsigned char type) {
+	switch (type) {
+	default:      return DIRECTORY_ENTRY_TYPE_UNKNOWN;
+	case DT_REG:  return DIRECTORY_ENTRY_TYPE_REGULAR;
+	case DT_DIR:  return DIRECTORY_ENTRY_TYPE_DIRECTORY;
+	case DT_CHR:  return DIRECTORY_ENTRY_TYPE_CHARACTER;
+	case DT_BLK:  return DIRECTORY_ENTRY_TYPE_BLOCK;
+	case DT_FIFO: return DIRECTORY_ENTRY_TYPE_FIFO;
+	case DT_LNK:  return DIRECTORY_ENTRY_TYPE_SYMLINK;
+	case DT_SOCK: return DIRECTORY_ENTRY_TYPE_SOCKET;
+	}
+}
+
+static uint8_t directory_get_entry_type_from_stat_mode(mode_t mode) {
+	if (S_ISREG(mode)) {
+		return DIRECTORY_ENTRY_TYPE_REGULAR;
+	} else if (S_ISDIR(mode)) {
+		return DIRECTORY_ENTRY_TYPE_DIRECTORY;
+	} else if (S_ISCHR(mode)) {
+		return DIRECTORY_ENTRY_TYPE_CHARACTER;
+	} else if (S_ISBLK(mode)) {
+		return DIRECTORY_ENTRY_TYPE_BLOCK;
+	} else if (S_ISFIFO(mode)) {
+		return DIRECTORY_ENTRY_TYPE_FIFO;
+	} else if (S_ISLNK(mode)) {
+		return DIRECTORY_ENTRY_TYPE_SYMLINK;
+	} else if (S_ISSOCK(mode)) {
+		return DIRECTORY_ENTRY_TYPE_SOCKET;
+	} else {
+		return DIRECTORY_ENTRY_TYPE_UNKNOWN;
+	}
+}
+
 // NOTE: assumes that name is absolute (starts with '/')
 static APIE directory_create_helper(char *name, uint32_t flags, mode_t mode) {
 	char *p;
@@ -125,8 +211,9 @@ static APIE directory_create_helper(char *name, uint32_t flags, mode_t mode) {
 	return API_E_SUCCESS;
 }
 
-// public API
-APIE directory_open(ObjectID name_id, Session *session, ObjectID *id) {
+// takes ownership of walk on success
+static APIE directory_open_(ObjectID name_id, DirectoryWalk *walk,
+                            Session *session, ObjectID *id) {
 	int phase = 0;
 	APIE error_code;
 	String *name;
@@ -182,7 +269,7 @@ APIE directory_open(ObjectID name_id, Session *session, ObjectID *id) {
 	phase = 2;
 
 	// create directory object
-	directory = calloc(1, sizeof(Directory));
+	directory = inventory_allocate_object(OBJECT_TYPE_DIRECTORY);
 
 	if (directory == NULL) {
 		error_code = API_E_NO_FREE_MEMORY;
@@ -198,6 +285,7 @@ APIE directory_open(ObjectID name_id, Session *session, ObjectID *id) {
 	directory->name = name;
 	directory->name_length = name->length;
 	directory->dp = dp;
+	directory->walk = walk;
 
 	string_copy(directory->buffer, sizeof(directory->buffer), name->buffer, -1);
 
@@ -225,7 +313,7 @@ APIE directory_open(ObjectID name_id, Session *session, ObjectID *id) {
 cleanup:
 	switch (phase) { // no breaks, all cases fall through intentionally
 	case 3:
-		free(directory);
+		inventory_free_object(OBJECT_TYPE_DIRECTORY, directory);
 		// fall through
 
 	case 2:
@@ -243,6 +331,153 @@ cleanup:
 	return phase == 4 ? API_E_SUCCESS : error_code;
 }
 
+// public API
+APIE directory_open(ObjectID name_id, Session *session, ObjectID *id) {
+	return directory_open_(name_id, NULL, session, id);
+}
+
+// splits the patterns at '/', as that cannot be part of an entry name
+static APIE directory_walk_get_patterns(ObjectID patterns_id, const char *caller,
+                                        char **patterns, int *pattern_count) {
+	String *string;
+	APIE error_code = string_get(patterns_id, caller, &string);
+	char *p;
+
+	if (error_code != API_E_SUCCESS) {
+		return error_code;
+	}
+
+	if (string->length == 0) {
+		return API_E_SUCCESS;
+	}
+
+	*patterns = strdup(string->buffer);
+
+	if (*patterns == NULL) {
+		log_error("Could not duplicate directory walk patterns: %s (%d)",
+		          get_errno_name(ENOMEM), ENOMEM);
+
+		return API_E_NO_FREE_MEMORY;
+	}
+
+	*pattern_count = 1;
+
+	for (p = *patterns; *p != '\0'; ++p) {
+		if (*p == '/') {
+			*p = '\0';
+
+			++*pattern_count;
+		}
+	}
+
+	return API_E_SUCCESS;
+}
+
+static bool directory_walk_match(const char *patterns, int pattern_count, const char *name) {
+	int i;
+
+	for (i = 0; i < pattern_count; ++i) {
+		if (fnmatch(patterns, name, FNM_PERIOD) == 0) {
+			return true;
+		}
+
+		patterns += strlen(patterns) + 1;
+	}
+
+	return false;
+}
+
+/*
+ * a directory walk is a directory object that lists the whole tree below the
+ * directory with get_directory_entries. the tree is walked depth-first and
+ * each directory is descended into right after its own entry is listed. an
+ * entry therefore belongs to the last listed directory with a depth one less
+ * than its own, so each entry only needs its own name and not its full path.
+ * entries whose name matches one of the exclude patterns are skipped, this
+ * includes the content of excluded directories. if there are include
+ * patterns then only directories and entries whose name matches one of them
+ * are listed. the subdirectories are opened relative to their parent with
+ * openat and the entries are examined with fstatat, so names are never
+ * resolved from the root directory again
+ */
+
+// public API
+APIE directory_walk(ObjectID name_id, ObjectID include_patterns_id,
+                    ObjectID exclude_patterns_id, uint16_t max_depth,
+                    Session *session, ObjectID *id) {
+	int phase = 0;
+	APIE error_code;
+	DirectoryWalk *walk;
+
+	walk = calloc(1, sizeof(DirectoryWalk));
+
+	if (walk == NULL) {
+		error_code = API_E_NO_FREE_MEMORY;
+
+		log_error("Could not allocate directory walk: %s (%d)",
+		          get_errno_name(ENOMEM), ENOMEM);
+
+		goto cleanup;
+	}
+
+	phase = 1;
+
+	error_code = directory_walk_get_patterns(include_patterns_id, "directory_walk:include_patterns",
+	                                         &walk->include_patterns,
+	                                         &walk->include_pattern_count);
+
+	if (error_code != API_E_SUCCESS) {
+		goto cleanup;
+	}
+
+	error_code = directory_walk_get_patterns(exclude_patterns_id, "directory_walk:exclude_patterns",
+	                                         &walk->exclude_patterns,
+	                                         &walk->exclude_pattern_count);
+
+	if (error_code != API_E_SUCCESS) {
+		goto cleanup;
+	}
+
+	if (array_create(&walk->levels, 8, sizeof(DIR *), true) < 0) {
+		error_code = api_get_error_code_from_errno();
+
+		log_error("Could not create directory walk level array: %s (%d)",
+		          get_errno_name(errno), errno);
+
+		goto cleanup;
+	}
+
+	phase = 2;
+
+	walk->max_depth = max_depth;
+
+	error_code = directory_open_(name_id, walk, session, id);
+
+	if (error_code != API_E_SUCCESS) {
+		goto cleanup;
+	}
+
+	phase = 3;
+
+cleanup:
+	switch (phase) { // no breaks, all cases fall through intentionally
+	case 2:
+		array_destroy(&walk->levels, NULL);
+		// fall through
+
+	case 1:
+		free(walk->include_patterns);
+		free(walk->exclude_patterns);
+		free(walk);
+		// fall through
+
+	default:
+		break;
+	}
+
+	return phase == 3 ? API_E_SUCCESS : error_code;
+}
+
 // public API
 APIE directory_get_name(Directory *directory, Session *session, ObjectID *name_id) {
 	APIE error_code = object_add_external_reference(&directory->name->base, session);
@@ -263,6 +498,13 @@ APIE directory_get_next_entry(Directory *directory, Session *session,
 	APIE error_code;
 	struct stat st;
 
+	if (directory->walk != NULL) {
+		log_warn("Cannot get next entry of directory object (id: %u, name: %s), it is a directory walk",
+		         directory->base.id, directory->name->buffer);
+
+		return API_E_NOT_SUPPORTED;
+	}
+
 	for (;;) {
 		errno = 0;
 		dirent = readdir(directory->dp);
@@ -298,16 +540,7 @@ APIE directory_get_next_entry(Directory *directory, Session *session,
 
 		string_append(directory->buffer, sizeof(directory->buffer), dirent->d_name);
 
-		switch (dirent->d_type) {
-		default:      *type = DIRECTORY_ENTRY_TYPE_UNKNOWN;   break;
-		case DT_REG:  *type = DIRECTORY_ENTRY_TYPE_REGULAR;   break;
-		case DT_DIR:  *type = DIRECTORY_ENTRY_TYPE_DIRECTORY; break;
-		case DT_CHR:  *type = DIRECTORY_ENTRY_TYPE_CHARACTER; break;
-		case DT_BLK:  *type = DIRECTORY_ENTRY_TYPE_BLOCK;     break;
-		case DT_FIFO: *type = DIRECTORY_ENTRY_TYPE_FIFO;      break;
-		case DT_LNK:  *type = DIRECTORY_ENTRY_TYPE_SYMLINK;   break;
-		case DT_SOCK: *type = DIRECTORY_ENTRY_TYPE_SOCKET;    break;
-		}
+		*type = directory_get_entry_type_from_dirent_type(dirent->d_type);
 
 		if (*type == DIRECTORY_ENTRY_TYPE_UNKNOWN) {
 			if (lstat(directory->buffer, &st) < 0) {
@@ -320,23 +553,7 @@ APIE directory_get_next_entry(Directory *directory, Session *session,
 				return error_code;
 			}
 
-			if (S_ISREG(st.st_mode)) {
-				*type = DIRECTORY_ENTRY_TYPE_REGULAR;
-			} else if (S_ISDIR(st.st_mode)) {
-				*type = DIRECTORY_ENTRY_TYPE_DIRECTORY;
-			} else if (S_ISCHR(st.st_mode)) {
-				*type = DIRECTORY_ENTRY_TYPE_CHARACTER;
-			} else if (S_ISBLK(st.st_mode)) {
-				*type = DIRECTORY_ENTRY_TYPE_BLOCK;
-			} else if (S_ISFIFO(st.st_mode)) {
-				*type = DIRECTORY_ENTRY_TYPE_FIFO;
-			} else if (S_ISLNK(st.st_mode)) {
-				*type = DIRECTORY_ENTRY_TYPE_SYMLINK;
-			} else if (S_ISSOCK(st.st_mode)) {
-				*type = DIRECTORY_ENTRY_TYPE_SOCKET;
-			} else {
-				*type = DIRECTORY_ENTRY_TYPE_UNKNOWN;
-			}
+			*type = directory_get_entry_type_from_stat_mode(st.st_mode);
 		}
 
 		return string_wrap(directory->buffer,
@@ -345,114 +562,969 @@ APIE directory_get_next_entry(Directory *directory, Session *session,
 	}
 }
 
-// public API
-APIE directory_rewind(Directory *directory) {
-	rewinddir(directory->dp);
-
-	return API_E_SUCCESS;
-}
+/*
+ * returns as many of the remaining entries as fit into max_length bytes in
+ * one string object, instead of one string object per entry. each entry is
+ * stored as a sequence of fields, each terminated by '/', which cannot be
+ * part of an entry name:
+ *
+ *   <type>/<name>/
+ *   <type>/<length>/<modification timestamp>/<name>/ (DIRECTORY_ENTRIES_FLAG_STATUS)
+ *
+ * the status is taken from one fstatat call per entry relative to the open
+ * directory, so the name doesn't have to be resolved from the root again.
+ * an entry that doesn't fit anymore is returned by the next call. for a
+ * directory walk each entry is stored as:
+ *
+ *   <depth>/<type>/<length>/<modification timestamp>/<permissions>/<name>/
+ *
+ * max_length is limited to DIRECTORY_MAX_ENTRIES_LENGTH and at most
+ * DIRECTORY_MAX_ENTRIES_PER_CALL entries are examined per call, so a huge
+ * directory or tree doesn't block the event loop. if all of them were
+ * filtered out by a walk then the returned string object is empty
+ */
 
-// public API
-APIE directory_create(const char *name, uint32_t flags, uint16_t permissions,
-                      uint32_t uid, uint32_t gid) {
-	mode_t mode;
-	char *tmp;
+static APIE directory_get_walk_entries(Directory *directory, uint32_t max_length,
+                                       String *entries, bool *end_reached) {
+	DirectoryWalk *walk = directory->walk;
+	int examined = 0;
+	int depth;
+	DIR *dp;
+	long position;
+	struct dirent *dirent;
+	struct stat st;
+	uint8_t type;
+	char record[DIRECTORY_MAX_ENTRY_LENGTH + 96];
+	int length;
+	int fd;
+	DIR **level;
 	APIE error_code;
-	pid_t pid;
-	int rc;
-	int status;
 
-	if (*name == '\0') {
-		log_warn("Directory name cannot be empty");
+	*end_reached = false;
 
-		return API_E_INVALID_PARAMETER;
-	}
+	while (examined < DIRECTORY_MAX_ENTRIES_PER_CALL) {
+		depth = walk->levels.count;
+		dp = depth > 0 ? *(DIR **)array_get(&walk->levels, depth - 1) : directory->dp;
+		position = telldir(dp);
 
-	if (*name != '/') {
-		log_warn("Cannot create directory with relative name '%s'", name);
+		errno = 0;
+		dirent = readdir(dp);
 
-		return API_E_INVALID_PARAMETER;
-	}
+		if (dirent == NULL) {
+			if (errno != 0) {
+				error_code = api_get_error_code_from_errno();
 
-	if ((flags & ~DIRECTORY_FLAG_ALL) != 0) {
-		log_warn("Invalid directory flags 0x%04X", flags);
+				log_error("Could not get next entry of directory walk object (id: %u, name: %s) at depth %d: %s (%d)",
+				          directory->base.id, directory->name->buffer, depth,
+				          get_errno_name(errno), errno);
 
-		return API_E_INVALID_PARAMETER;
-	}
+				return error_code;
+			}
 
-	if ((permissions & ~FILE_PERMISSION_ALL) != 0) {
-		log_warn("Invalid file permissions 0o%04o", permissions);
+			if (depth == 0) {
+				*end_reached = true;
 
-		return API_E_INVALID_PARAMETER;
-	}
+				break;
+			}
 
-	mode = file_get_mode_from_permissions(permissions);
+			array_remove(&walk->levels, depth - 1, directory_walk_close_level);
 
-	// duplicate name, because directory_create_helper might modify it
-	tmp = strdup(name);
+			continue;
+		}
 
-	if (tmp == NULL) {
-		log_error("Could not duplicate directory name: %s (%d)",
-		          get_errno_name(ENOMEM), ENOMEM);
+		if (strcmp(dirent->d_name, ".") == 0 || strcmp(dirent->d_name, "..") == 0) {
+			continue;
+		}
 
-		return API_E_NO_FREE_MEMORY;
-	}
+		++examined;
 
-	if (geteuid() == uid && getegid() == gid) {
-		error_code = directory_create_helper(tmp, flags, mode);
-	} else {
-		error_code = process_fork(&pid);
+		if (strlen(dirent->d_name) > DIRECTORY_MAX_ENTRY_LENGTH) {
+			log_error("Directory entry name is too long");
 
-		if (error_code != API_E_SUCCESS) {
-			goto cleanup;
+			return API_E_OUT_OF_RANGE;
 		}
 
-		if (pid == 0) { // child
-			// change user and groups
-			error_code = process_set_identity(uid, gid);
+		if (walk->exclude_pattern_count > 0 &&
+		    directory_walk_match(walk->exclude_patterns, walk->exclude_pattern_count, dirent->d_name)) {
+			continue;
+		}
 
-			if (error_code != API_E_SUCCESS) {
-				goto child_cleanup;
+		if (fstatat(dirfd(dp), dirent->d_name, &st, AT_SYMLINK_NOFOLLOW) < 0) {
+			if (errno == ENOENT) {
+				continue; // removed since it was read from the directory
 			}
 
-			// create directory
-			error_code = directory_create_helper(tmp, flags, mode);
+			error_code = api_get_error_code_from_errno();
 
-		child_cleanup:
-			// report error code as exit status
-			_exit(error_code);
+			log_error("Could not get information for entry '%s' of directory walk object (id: %u, name: %s): %s (%d)",
+			          dirent->d_name, directory->base.id, directory->name->buffer,
+			          get_errno_name(errno), errno);
+
+			return error_code;
 		}
 
-		// wait for child to exit
-		do {
-			rc = waitpid(pid, &status, 0);
-		} while (rc < 0 && errno_interrupted());
+		type = directory_get_entry_type_from_stat_mode(st.st_mode);
 
-		if (rc < 0) {
-			error_code = api_get_error_code_from_errno();
+		if (type != DIRECTORY_ENTRY_TYPE_DIRECTORY && walk->include_pattern_count > 0 &&
+		    !directory_walk_match(walk->include_patterns, walk->include_pattern_count, dirent->d_name)) {
+			continue;
+		}
 
-			log_error("Could not wait for child process creating directory '%s' as %u:%u: %s (%d)",
-			          name, uid, gid, get_errno_name(errno), errno);
+		length = snprintf(record, sizeof(record), "%d/%u/%"PRIu64"/%"PRIu64"/%u/%s/",
+		                  depth, type, (uint64_t)st.st_size, (uint64_t)st.st_mtime,
+		                  (unsigned int)(st.st_mode & FILE_PERMISSION_ALL), dirent->d_name);
 
-			goto cleanup;
+		if (entries->length + length > max_length) {
+			if (entries->length == 0) {
+				log_warn("Entry '%s' of directory walk object (id: %u, name: %s) is longer than %u byte(s)",
+				         dirent->d_name, directory->base.id, directory->name->buffer,
+				         max_length);
+
+				return API_E_OUT_OF_RANGE;
+			}
+
+			// return this entry on the next call
+			seekdir(dp, position);
+
+			break;
 		}
 
-		// check if child exited normally
-		if (!WIFEXITED(status)) {
-			error_code = API_E_INTERNAL_ERROR;
+		error_code = string_reserve(entries, entries->length + length);
 
-			log_error("Child process creating directory '%s' as %u:%u did not exit normally",
-			          name, uid, gid);
+		if (error_code != API_E_SUCCESS) {
+			return error_code;
+		}
 
-			goto cleanup;
+		memcpy(entries->buffer + entries->length, record, length);
+
+		entries->length += length;
+
+		if (type != DIRECTORY_ENTRY_TYPE_DIRECTORY ||
+		    (walk->max_depth > 0 && depth + 1 >= walk->max_depth)) {
+			continue;
 		}
 
-		// get child error code from child exit status
-		error_code = WEXITSTATUS(status);
+		if (depth + 1 >= DIRECTORY_MAX_OPEN_DEPTH) {
+			log_warn("Not descending into entry '%s' of directory walk object (id: %u, name: %s), exceeds maximum depth of %d",
+			         dirent->d_name, directory->base.id, directory->name->buffer,
+			         DIRECTORY_MAX_OPEN_DEPTH);
+
+			continue;
+		}
+
+		// descend right away, so all following entries with a greater depth
+		// belong to this directory. a directory that cannot be opened is
+		// listed without content, instead of aborting the whole walk
+		fd = openat(dirfd(dp), dirent->d_name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+
+		if (fd < 0) {
+			log_warn("Could not open entry '%s' of directory walk object (id: %u, name: %s), listing it without content: %s (%d)",
+			         dirent->d_name, directory->base.id, directory->name->buffer,
+			         get_errno_name(errno), errno);
+
+			continue;
+		}
+
+		level = array_append(&walk->levels);
+
+		if (level == NULL) {
+			error_code = api_get_error_code_from_errno();
+
+			log_error("Could not append to directory walk level array: %s (%d)",
+			          get_errno_name(errno), errno);
+
+			close(fd);
+
+			return error_code;
+		}
+
+		*level = fdopendir(fd);
+
+		if (*level == NULL) {
+			error_code = api_get_error_code_from_errno();
+
+			log_error("Could not open entry '%s' of directory walk object (id: %u, name: %s): %s (%d)",
+			          dirent->d_name, directory->base.id, directory->name->buffer,
+			          get_errno_name(errno), errno);
+
+			array_remove(&walk->levels, walk->levels.count - 1, NULL);
+			close(fd);
+
+			return error_code;
+		}
 	}
 
-cleanup:
-	free(tmp);
+	return API_E_SUCCESS;
+}
 
-	return error_code;
+// public API
+APIE directory_get_entries(Directory *directory, uint32_t flags, uint32_t max_length,
+                           Session *session, ObjectID *entries_id) {
+	String *entries;
+	long position;
+	struct dirent *dirent;
+	uint8_t type;
+	struct stat st;
+	char record[DIRECTORY_MAX_ENTRY_LENGTH + 64];
+	int length;
+	int examined = 0;
+	bool end_reached = false;
+	APIE error_code;
+
+	if ((flags & ~DIRECTORY_ENTRIES_FLAG_ALL) != 0) {
+		log_warn("Invalid directory entries flags 0x%04X", flags);
+
+		return API_E_INVALID_PARAMETER;
+	}
+
+	if (max_length == 0 || max_length > DIRECTORY_MAX_ENTRIES_LENGTH) {
+		log_warn("Length of %u byte(s) exceeds maximum length of %u byte(s) for directory entries or is zero",
+		         max_length, DIRECTORY_MAX_ENTRIES_LENGTH);
+
+		return API_E_OUT_OF_RANGE;
+	}
+
+	error_code = string_wrap("", session, OBJECT_CREATE_FLAG_EXTERNAL, NULL, &entries);
+
+	if (error_code != API_E_SUCCESS) {
+		return error_code;
+	}
+
+	if (directory->walk != NULL) {
+		error_code = directory_get_walk_entries(directory, max_length, entries, &end_reached);
+
+		if (error_code != API_E_SUCCESS) {
+			goto error;
+		}
+	}
+
+	while (directory->walk == NULL && examined < DIRECTORY_MAX_ENTRIES_PER_CALL) {
+		++examined;
+		position = telldir(directory->dp);
+
+		errno = 0;
+		dirent = readdir(directory->dp);
+
+		if (dirent == NULL) {
+			if (errno == 0) {
+				end_reached = true;
+
+				break;
+			}
+
+			error_code = api_get_error_code_from_errno();
+
+			log_error("Could not get next entry of directory object (id: %u, name: %s): %s (%d)",
+			          directory->base.id, directory->name->buffer,
+			          get_errno_name(errno), errno);
+
+			goto error;
+		}
+
+		if (strcmp(dirent->d_name, ".") == 0 || strcmp(dirent->d_name, "..") == 0) {
+			continue;
+		}
+
+		if (strlen(dirent->d_name) > DIRECTORY_MAX_ENTRY_LENGTH) {
+			error_code = API_E_OUT_OF_RANGE;
+
+			log_error("Directory entry name is too long");
+
+			goto error;
+		}
+
+		type = directory_get_entry_type_from_dirent_type(dirent->d_type);
+
+		if ((flags & DIRECTORY_ENTRIES_FLAG_STATUS) != 0 || type == DIRECTORY_ENTRY_TYPE_UNKNOWN) {
+			if (fstatat(dirfd(directory->dp), dirent->d_name, &st, AT_SYMLINK_NOFOLLOW) < 0) {
+				if (errno == ENOENT) {
+					continue; // removed since it was read from the directory
+				}
+
+				error_code = api_get_error_code_from_errno();
+
+				log_error("Could not get information for entry '%s' of directory object (id: %u, name: %s): %s (%d)",
+				          dirent->d_name, directory->base.id, directory->name->buffer,
+				          get_errno_name(errno), errno);
+
+				goto error;
+			}
+
+			type = directory_get_entry_type_from_stat_mode(st.st_mode);
+		}
+
+		if ((flags & DIRECTORY_ENTRIES_FLAG_STATUS) != 0) {
+			length = snprintf(record, sizeof(record), "%u/%"PRIu64"/%"PRIu64"/%s/",
+			                  type, (uint64_t)st.st_size, (uint64_t)st.st_mtime,
+			                  dirent->d_name);
+		} else {
+			length = snprintf(record, sizeof(record), "%u/%s/", type, dirent->d_name);
+		}
+
+		if (entries->length + length > max_length) {
+			if (entries->length == 0) {
+				error_code = API_E_OUT_OF_RANGE;
+
+				log_warn("Entry '%s' of directory object (id: %u, name: %s) is longer than %u byte(s)",
+				         dirent->d_name, directory->base.id, directory->name->buffer,
+				         max_length);
+
+				goto error;
+			}
+
+			// return this entry on the next call
+			seekdir(directory->dp, position);
+
+			break;
+		}
+
+		error_code = string_reserve(entries, entries->length + length);
+
+		if (error_code != API_E_SUCCESS) {
+			goto error;
+		}
+
+		memcpy(entries->buffer + entries->length, record, length);
+
+		entries->length += length;
+	}
+
+	if (entries->length == 0 && end_reached) {
+		error_code = API_E_NO_MORE_DATA;
+
+		log_debug("Reached end of directory object (id: %u, name: %s)",
+		          directory->base.id, directory->name->buffer);
+
+		goto error;
+	}
+
+	entries->buffer[entries->length] = '\0';
+
+	*entries_id = entries->base.id;
+
+	return API_E_SUCCESS;
+
+error:
+	object_remove_external_reference(&entries->base, session);
+
+	return error_code;
+}
+
+// public API
+APIE directory_rewind(Directory *directory) {
+	if (directory->walk != NULL) {
+		array_resize(&directory->walk->levels, 0, directory_walk_close_level);
+	}
+
+	rewinddir(directory->dp);
+
+	return API_E_SUCCESS;
+}
+
+// public API
+APIE directory_create(const char *name, uint32_t flags, uint16_t permissions,
+                      uint32_t uid, uint32_t gid) {
+	mode_t mode;
+	char *tmp;
+	APIE error_code;
+	pid_t pid;
+	int rc;
+	int status;
+
+	if (*name == '\0') {
+		log_warn("Directory name cannot be empty");
+
+		return API_E_INVALID_PARAMETER;
+	}
+
+	if (*name != '/') {
+		log_warn("Cannot create directory with relative name '%s'", name);
+
+		return API_E_INVALID_PARAMETER;
+	}
+
+	if ((flags & ~DIRECTORY_FLAG_ALL) != 0) {
+		log_warn("Invalid directory flags 0x%04X", flags);
+
+		return API_E_INVALID_PARAMETER;
+	}
+
+	if ((permissions & ~FILE_PERMISSION_ALL) != 0) {
+		log_warn("Invalid file permissions 0o%04o", permissions);
+
+		return API_E_INVALID_PARAMETER;
+	}
+
+	mode = file_get_mode_from_permissions(permissions);
+
+	// duplicate name, because directory_create_helper might modify it
+	tmp = strdup(name);
+
+	if (tmp == NULL) {
+		log_error("Could not duplicate directory name: %s (%d)",
+		          get_errno_name(ENOMEM), ENOMEM);
+
+		return API_E_NO_FREE_MEMORY;
+	}
+
+	if (geteuid() == uid && getegid() == gid) {
+		error_code = directory_create_helper(tmp, flags, mode);
+	} else {
+		error_code = process_fork(&pid);
+
+		if (error_code != API_E_SUCCESS) {
+			goto cleanup;
+		}
+
+		if (pid == 0) { // child
+			// change user and groups
+			error_code = process_set_identity(uid, gid);
+
+			if (error_code != API_E_SUCCESS) {
+				goto child_cleanup;
+			}
+
+			// create directory
+			error_code = directory_create_helper(tmp, flags, mode);
+
+		child_cleanup:
+			// report error code as exit status
+			_exit(error_code);
+		}
+
+		// wait for child to exit
+		do {
+			rc = waitpid(pid, &status, 0);
+		} while (rc < 0 && errno_interrupted());
+
+		if (rc < 0) {
+			error_code = api_get_error_code_from_errno();
+
+			log_error("Could not wait for child process creating directory '%s' as %u:%u: %s (%d)",
+			          name, uid, gid, get_errno_name(errno), errno);
+
+			goto cleanup;
+		}
+
+		// check if child exited normally
+		if (!WIFEXITED(status)) {
+			error_code = API_E_INTERNAL_ERROR;
+
+			log_error("Child process creating directory '%s' as %u:%u did not exit normally",
+			          name, uid, gid);
+
+			goto cleanup;
+		}
+
+		// get child error code from child exit status
+		error_code = WEXITSTATUS(status);
+	}
+
+cleanup:
+	free(tmp);
+
+	return error_code;
+}
+
+static const char *directory_get_operation_type_name(DirectoryOperationType type) {
+	switch (type) {
+	case DIRECTORY_OPERATION_TYPE_REMOVE:     return "removal";
+	case DIRECTORY_OPERATION_TYPE_DISK_USAGE: return "disk usage computation";
+
+	default:                                  return "<unknown>";
+	}
+}
+
+static void directory_operation_close_level(void *item) {
+	DirectoryOperationLevel *level = item;
+
+	closedir(level->dp);
+	free(level->name);
+}
+
+static void directory_send_operation_callback(DirectoryOperation *operation,
+                                              APIE error_code, bool finished) {
+	if (operation->type == DIRECTORY_OPERATION_TYPE_REMOVE) {
+		api_send_async_path_removal_callback(operation->name->base.id, error_code,
+		                                     operation->entry_count, finished);
+	} else {
+		api_send_async_disk_usage_callback(operation->name->base.id, error_code,
+		                                   operation->length,
+		                                   operation->allocated_length,
+		                                   operation->entry_count, finished);
+	}
+}
+
+static void directory_finish_operation(DirectoryOperation *operation, APIE error_code) {
+	if (error_code == API_E_SUCCESS) {
+		log_debug("Finished %s of '%s', %"PRIu64" entries",
+		          directory_get_operation_type_name(operation->type),
+		          operation->name->buffer, operation->entry_count);
+	}
+
+	directory_send_operation_callback(operation, error_code, true);
+
+	background_job_stop(&operation->job);
+
+	array_destroy(&operation->levels, directory_operation_close_level);
+	string_unlock_and_release(operation->name);
+	free(operation);
+}
+
+static void directory_add_operation_entry(DirectoryOperation *operation, struct stat *st) {
+	++operation->entry_count;
+
+	if (operation->type == DIRECTORY_OPERATION_TYPE_DISK_USAGE) {
+		operation->length += st->st_size;
+		operation->allocated_length += (uint64_t)st->st_blocks * 512;
+	}
+}
+
+// opens a directory relative to the current level, name is NULL for the root
+// directory. takes ownership of name
+static APIE directory_push_operation_level(DirectoryOperation *operation, char *name) {
+	DirectoryOperationLevel *parent;
+	DirectoryOperationLevel *level;
+	int fd;
+	APIE error_code;
+
+	if (operation->levels.count >= DIRECTORY_MAX_OPEN_DEPTH) {
+		log_warn("Cannot descend into '%s' below '%s' during %s, exceeds maximum depth of %d",
+		         name, operation->name->buffer,
+		         directory_get_operation_type_name(operation->type),
+		         DIRECTORY_MAX_OPEN_DEPTH);
+
+		free(name);
+
+		return API_E_OUT_OF_RANGE;
+	}
+
+	if (name == NULL) {
+		fd = open(operation->name->buffer, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+	} else {
+		parent = array_get(&operation->levels, operation->levels.count - 1);
+		fd = openat(dirfd(parent->dp), name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+	}
+
+	if (fd < 0) {
+		error_code = api_get_error_code_from_errno();
+
+		log_error("Could not open directory '%s' below '%s' during %s: %s (%d)",
+		          name != NULL ? name : ".", operation->name->buffer,
+		          directory_get_operation_type_name(operation->type),
+		          get_errno_name(errno), errno);
+
+		free(name);
+
+		return error_code;
+	}
+
+	level = array_append(&operation->levels);
+
+	if (level == NULL) {
+		error_code = api_get_error_code_from_errno();
+
+		log_error("Could not append to directory operation level array: %s (%d)",
+		          get_errno_name(errno), errno);
+
+		close(fd);
+		free(name);
+
+		return error_code;
+	}
+
+	level->dp = fdopendir(fd);
+	level->name = name;
+
+	if (level->dp == NULL) {
+		error_code = api_get_error_code_from_errno();
+
+		log_error("Could not open directory '%s' below '%s' during %s: %s (%d)",
+		          name != NULL ? name : ".", operation->name->buffer,
+		          directory_get_operation_type_name(operation->type),
+		          get_errno_name(errno), errno);
+
+		array_remove(&operation->levels, operation->levels.count - 1, NULL);
+		close(fd);
+		free(name);
+
+		return error_code;
+	}
+
+	return API_E_SUCCESS;
+}
+
+// closes the current level, a removal also removes the now empty directory
+static APIE directory_pop_operation_level(DirectoryOperation *operation) {
+	DirectoryOperationLevel *level = array_get(&operation->levels, operation->levels.count - 1);
+	DirectoryOperationLevel *parent;
+	char *name = level->name;
+	int rc;
+	APIE error_code;
+
+	closedir(level->dp);
+
+	level->name = NULL;
+
+	array_remove(&operation->levels, operation->levels.count - 1, NULL);
+
+	if (operation->type == DIRECTORY_OPERATION_TYPE_REMOVE) {
+		if (name == NULL) {
+			rc = rmdir(operation->name->buffer);
+		} else {
+			parent = array_get(&operation->levels, operation->levels.count - 1);
+			rc = unlinkat(dirfd(parent->dp), name, AT_REMOVEDIR);
+		}
+
+		if (rc < 0) {
+			error_code = api_get_error_code_from_errno();
+
+			log_error("Could not remove directory '%s' below '%s': %s (%d)",
+			          name != NULL ? name : ".", operation->name->buffer,
+			          get_errno_name(errno), errno);
+
+			free(name);
+
+			return error_code;
+		}
+
+		++operation->entry_count;
+	}
+
+	free(name);
+
+	return API_E_SUCCESS;
+}
+
+// handles the root itself. a file, or a directory that is not removed
+// recursively, is done right away
+static APIE directory_start_operation_root(DirectoryOperation *operation, bool *done) {
+	struct stat st;
+	int rc;
+	APIE error_code;
+
+	*done = false;
+
+	if (lstat(operation->name->buffer, &st) < 0) {
+		error_code = api_get_error_code_from_errno();
+
+		log_error("Could not get information for '%s': %s (%d)",
+		          operation->name->buffer, get_errno_name(errno), errno);
+
+		return error_code;
+	}
+
+	if (operation->type == DIRECTORY_OPERATION_TYPE_DISK_USAGE) {
+		directory_add_operation_entry(operation, &st);
+	}
+
+	if (S_ISDIR(st.st_mode) && (operation->type != DIRECTORY_OPERATION_TYPE_REMOVE || operation->recursive)) {
+		return directory_push_operation_level(operation, NULL);
+	}
+
+	*done = true;
+
+	if (operation->type != DIRECTORY_OPERATION_TYPE_REMOVE) {
+		return API_E_SUCCESS;
+	}
+
+	rc = S_ISDIR(st.st_mode) ? rmdir(operation->name->buffer) : unlink(operation->name->buffer);
+
+	if (rc < 0) {
+		error_code = api_get_error_code_from_errno();
+
+		log_error("Could not remove '%s': %s (%d)",
+		          operation->name->buffer, get_errno_name(errno), errno);
+
+		return error_code;
+	}
+
+	++operation->entry_count;
+
+	return API_E_SUCCESS;
+}
+
+// handles the next entry of the current level. sets done if the root
+// directory itself was finished
+static APIE directory_handle_operation_entry(DirectoryOperation *operation, bool *done) {
+	DirectoryOperationLevel *level = array_get(&operation->levels, operation->levels.count - 1);
+	struct dirent *dirent;
+	struct stat st;
+	char *name;
+	APIE error_code;
+
+	errno = 0;
+	dirent = readdir(level->dp);
+
+	if (dirent == NULL) {
+		if (errno != 0) {
+			error_code = api_get_error_code_from_errno();
+
+			log_error("Could not get next entry of '%s' below '%s' during %s: %s (%d)",
+			          level->name != NULL ? level->name : ".", operation->name->buffer,
+			          directory_get_operation_type_name(operation->type),
+			          get_errno_name(errno), errno);
+
+			return error_code;
+		}
+
+		error_code = directory_pop_operation_level(operation);
+
+		*done = operation->levels.count == 0;
+
+		return error_code;
+	}
+
+	if (strcmp(dirent->d_name, ".") == 0 || strcmp(dirent->d_name, "..") == 0) {
+		return API_E_SUCCESS;
+	}
+
+	if (fstatat(dirfd(level->dp), dirent->d_name, &st, AT_SYMLINK_NOFOLLOW) < 0) {
+		if (errno == ENOENT) {
+			return API_E_SUCCESS; // removed since it was read from the directory
+		}
+
+		error_code = api_get_error_code_from_errno();
+
+		log_error("Could not get information for '%s' below '%s' during %s: %s (%d)",
+		          dirent->d_name, operation->name->buffer,
+		          directory_get_operation_type_name(operation->type),
+		          get_errno_name(errno), errno);
+
+		return error_code;
+	}
+
+	if (S_ISDIR(st.st_mode)) {
+		// a removed directory is counted when it's removed after its content
+		if (operation->type == DIRECTORY_OPERATION_TYPE_DISK_USAGE) {
+			directory_add_operation_entry(operation, &st);
+		}
+
+		name = strdup(dirent->d_name);
+
+		if (name == NULL) {
+			log_error("Could not duplicate directory entry name: %s (%d)",
+			          get_errno_name(ENOMEM), ENOMEM);
+
+			return API_E_NO_FREE_MEMORY;
+		}
+
+		return directory_push_operation_level(operation, name);
+	}
+
+	if (operation->type == DIRECTORY_OPERATION_TYPE_REMOVE &&
+	    unlinkat(dirfd(level->dp), dirent->d_name, 0) < 0 && errno != ENOENT) {
+		error_code = api_get_error_code_from_errno();
+
+		log_error("Could not remove '%s' below '%s': %s (%d)",
+		          dirent->d_name, operation->name->buffer,
+		          get_errno_name(errno), errno);
+
+		return error_code;
+	}
+
+	directory_add_operation_entry(operation, &st);
+
+	return API_E_SUCCESS;
+}
+
+// handles a limited number of entries per step, to avoid blocking the event
+// loop for large trees
+static void directory_handle_operation(void *opaque) {
+	DirectoryOperation *operation = opaque;
+	bool done = false;
+	int i;
+	APIE error_code = API_E_SUCCESS;
+
+	if (!operation->started) {
+		operation->started = true;
+		error_code = directory_start_operation_root(operation, &done);
+	}
+
+	for (i = 0; i < DIRECTORY_OPERATION_ENTRIES_PER_STEP &&
+	     error_code == API_E_SUCCESS && !done; ++i) {
+		error_code = directory_handle_operation_entry(operation, &done);
+	}
+
+	if (error_code != API_E_SUCCESS || done) {
+		directory_finish_operation(operation, error_code);
+
+		return;
+	}
+
+	if (operation->entry_count >= operation->next_progress_entry_count) {
+		operation->next_progress_entry_count += DIRECTORY_OPERATION_PROGRESS_INTERVAL;
+
+		directory_send_operation_callback(operation, API_E_SUCCESS, false);
+	}
+}
+
+// returns true if any component of the name is . or .., those could make an
+// innocent looking name refer to the root directory
+static bool directory_has_dot_component(const char *name) {
+	const char *component = name;
+	size_t length;
+
+	while (*component != '\0') {
+		component += strspn(component, "/");
+		length = strcspn(component, "/");
+
+		if ((length == 1 && component[0] == '.') ||
+		    (length == 2 && component[0] == '.' && component[1] == '.')) {
+			return true;
+		}
+
+		component += length;
+	}
+
+	return false;
+}
+
+static APIE directory_start_operation(ObjectID name_id, DirectoryOperationType type,
+                                      bool recursive) {
+	int phase = 0;
+	APIE error_code;
+	String *name;
+	struct stat st;
+	struct stat root_st;
+	DirectoryOperation *operation;
+
+	// acquire and lock name string object, it identifies the operation in
+	// the callbacks and stays valid until the operation is finished
+	error_code = string_get_acquired_and_locked(name_id, "directory_start_operation:name", &name);
+
+	if (error_code != API_E_SUCCESS) {
+		goto cleanup;
+	}
+
+	phase = 1;
+
+	if (*name->buffer != '/') {
+		error_code = API_E_INVALID_PARAMETER;
+
+		log_warn("Cannot start %s of relative or empty name '%s'",
+		         directory_get_operation_type_name(type), name->buffer);
+
+		goto cleanup;
+	}
+
+	if (type == DIRECTORY_OPERATION_TYPE_REMOVE && directory_has_dot_component(name->buffer)) {
+		error_code = API_E_INVALID_PARAMETER;
+
+		log_warn("Cannot remove '%s' with . or .. component", name->buffer);
+
+		goto cleanup;
+	}
+
+	// report a missing path right away instead of by callback
+	if (lstat(name->buffer, &st) < 0) {
+		error_code = api_get_error_code_from_errno();
+
+		log_warn("Could not get information for '%s': %s (%d)",
+		         name->buffer, get_errno_name(errno), errno);
+
+		goto cleanup;
+	}
+
+	// compare by identity, because the name can still reach the root
+	// directory by other means, e.g. a trailing / after a symlink
+	if (type == DIRECTORY_OPERATION_TYPE_REMOVE) {
+		if (stat("/", &root_st) < 0) {
+			error_code = api_get_error_code_from_errno();
+
+			log_error("Could not get information for '/': %s (%d)",
+			          get_errno_name(errno), errno);
+
+			goto cleanup;
+		}
+
+		if (st.st_dev == root_st.st_dev && st.st_ino == root_st.st_ino) {
+			error_code = API_E_INVALID_PARAMETER;
+
+			log_warn("Refusing to remove the root directory '%s'", name->buffer);
+
+			goto cleanup;
+		}
+	}
+
+	operation = calloc(1, sizeof(DirectoryOperation));
+
+	if (operation == NULL) {
+		error_code = API_E_NO_FREE_MEMORY;
+
+		log_error("Could not allocate directory operation: %s (%d)",
+		          get_errno_name(ENOMEM), ENOMEM);
+
+		goto cleanup;
+	}
+
+	phase = 2;
+
+	if (array_create(&operation->levels, 8, sizeof(DirectoryOperationLevel), true) < 0) {
+		error_code = api_get_error_code_from_errno();
+
+		log_error("Could not create directory operation level array: %s (%d)",
+		          get_errno_name(errno), errno);
+
+		goto cleanup;
+	}
+
+	phase = 3;
+
+	operation->type = type;
+	operation->name = name;
+	operation->started = false;
+	operation->recursive = recursive;
+	operation->next_progress_entry_count = DIRECTORY_OPERATION_PROGRESS_INTERVAL;
+
+	// the work is done in a background job, so the response of this function
+	// is sent before the first callback
+	background_job_create(&operation->job, directory_handle_operation, operation);
+
+	if (background_job_start(&operation->job) < 0) {
+		error_code = API_E_INTERNAL_ERROR;
+
+		goto cleanup;
+	}
+
+	log_debug("Started %s of '%s'", directory_get_operation_type_name(type), name->buffer);
+
+	phase = 4;
+
+cleanup:
+	switch (phase) { // no breaks, all cases fall through intentionally
+	case 3:
+		array_destroy(&operation->levels, NULL);
+		// fall through
+
+	case 2:
+		free(operation);
+		// fall through
+
+	case 1:
+		string_unlock_and_release(name);
+		// fall through
+
+	default:
+		break;
+	}
+
+	return phase == 4 ? API_E_SUCCESS : error_code;
+}
+
+// public API
+APIE directory_remove_path(ObjectID name_id, uint32_t flags) {
+	if ((flags & ~DIRECTORY_FLAG_RECURSIVE) != 0) {
+		log_warn("Invalid remove path flags 0x%04X", flags);
+
+		return API_E_INVALID_PARAMETER;
+	}
+
+	return directory_start_operation(name_id, DIRECTORY_OPERATION_TYPE_REMOVE,
+	                                 (flags & DIRECTORY_FLAG_RECURSIVE) != 0);
+}
+
+// public API
+APIE directory_get_disk_usage(ObjectID name_id) {
+	return directory_start_operation(name_id, DIRECTORY_OPERATION_TYPE_DISK_USAGE, true);
 }
@@ -29,6 +29,7 @@
 
 #define DIRECTORY_MAX_NAME_LENGTH 1024
 #define DIRECTORY_MAX_ENTRY_LENGTH 1024
+#define DIRECTORY_MAX_ENTRIES_LENGTH 1048576 // for get_directory_entries
 
 typedef enum { // bitmask
 	DIRECTORY_FLAG_RECURSIVE = 0x0001,
@@ -38,6 +39,14 @@ typedef enum { // bitmask
 #define DIRECTORY_FLAG_ALL (DIRECTORY_FLAG_RECURSIVE | \
                             DIRECTORY_FLAG_EXCLUSIVE)
 
+typedef enum { // bitmask
+	DIRECTORY_ENTRIES_FLAG_STATUS = 0x0001 // include length and modification timestamp
+} DirectoryEntriesFlag;
+
+#define DIRECTORY_ENTRIES_FLAG_ALL DIRECTORY_ENTRIES_FLAG_STATUS
+
+typedef struct _DirectoryWalk DirectoryWalk;
+
 typedef enum {
 	DIRECTORY_ENTRY_TYPE_UNKNOWN = 0,
 	DIRECTORY_ENTRY_TYPE_REGULAR,
@@ -56,17 +65,26 @@ typedef struct {
 	int name_length; // length of name in buffer
 	DIR *dp;
 	char buffer[DIRECTORY_MAX_NAME_LENGTH + 1 /* for / */ + DIRECTORY_MAX_ENTRY_LENGTH + 1 /* for \0 */];
+	DirectoryWalk *walk; // only allocated for directory objects created by directory_walk
 } Directory;
 
 APIE directory_open(ObjectID name_id, Session *session, ObjectID *id);
+APIE directory_walk(ObjectID name_id, ObjectID include_patterns_id,
+                    ObjectID exclude_patterns_id, uint16_t max_depth,
+                    Session *session, ObjectID *id);
 
 APIE directory_get_name(Directory *directory, Session *session, ObjectID *name_id);
 
 APIE directory_get_next_entry(Directory *directory, Session *session,
                               ObjectID *name_id, uint8_t *type);
+APIE directory_get_entries(Directory *directory, uint32_t flags, uint32_t max_length,
+                           Session *session, ObjectID *entries_id);
 APIE directory_rewind(Directory *directory);
 
 APIE directory_create(const char *name, uint32_t flags, uint16_t permissions,
                       uint32_t uid, uint32_t gid);
 
+APIE directory_remove_path(ObjectID name_id, uint32_t flags);
+APIE directory_get_disk_usage(ObjectID name_id);
+
 #endif // REDAPID_DIRECTORY_H
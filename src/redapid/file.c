@@ -27,10 +27,12 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
-#include <sys/socket.h>
-#include <sys/wait.h>
 #include <unistd.h>
+#include <zlib.h>
 
 #include <daemonlib/event.h>
 #include <daemonlib/log.h>
@@ -39,8 +41,11 @@
 #include "file.h"
 
 #include "api.h"
+#include "background_job.h"
+#include "checksum.h"
+#include "file_broker.h"
 #include "inventory.h"
-#include "process.h"
+#include "wheel_timer.h"
 
 static LogSource _log_source = LOG_SOURCE_INITIALIZER;
 
@@ -49,76 +54,121 @@ static LogSource _log_source = LOG_SOURCE_INITIALIZER;
 #define file_expand_signature(file) (file)->base.id, \
 	file_get_type_name((file)->type), (file)->name->buffer, (file)->flags
 
-static int sendfd(int socket_handle, int fd) {
-	uint8_t buffer[1] = { 0 };
-	struct iovec iovec;
-	struct msghdr msghdr;
-	struct cmsghdr *cmsghdr;
-	uint8_t control[CMSG_SPACE(sizeof(int))];
-
-	iovec.iov_base = buffer;
-	iovec.iov_len = sizeof(buffer);
-
-	memset(&msghdr, 0, sizeof(msghdr));
-
-	msghdr.msg_iov = &iovec;
-	msghdr.msg_iovlen = 1;
-
-	if (fd < 0) {
-		msghdr.msg_control = NULL;
-		msghdr.msg_controllen = 0;
-	} else {
-		msghdr.msg_control = (caddr_t)control;
-		msghdr.msg_controllen = CMSG_LEN(sizeof(int));
-
-		cmsghdr = CMSG_FIRSTHDR(&msghdr);
-		cmsghdr->cmsg_len = CMSG_LEN(sizeof(int));
-		cmsghdr->cmsg_level = SOL_SOCKET;
-		cmsghdr->cmsg_type = SCM_RIGHTS;
-
-		memcpy(CMSG_DATA(cmsghdr), &fd, sizeof(int));
-	}
-
-	if (sendmsg(socket_handle, &msghdr, 0) != (int)iovec.iov_len) {
-		return -1;
-	}
-
-	return 0;
-}
-
-static int recvfd(int socket_handle, int *fd) {
-	uint8_t buffer[1] = { 0 };
-	struct iovec iovec;
-	struct msghdr msghdr;
-	struct cmsghdr *cmsghdr;
-	uint8_t control[CMSG_SPACE(sizeof(int))];
-
-	iovec.iov_base = buffer;
-	iovec.iov_len = sizeof(buffer);
-
-	memset(&msghdr, 0, sizeof (msghdr));
-
-	msghdr.msg_name = 0;
-	msghdr.msg_namelen = 0;
-	msghdr.msg_iov = &iovec;
-	msghdr.msg_iovlen = 1;
-	msghdr.msg_control = (caddr_t)control;
-	msghdr.msg_controllen = sizeof(control);
-
-	if (recvmsg(socket_handle, &msghdr, 0) <= 0) {
-		return -1;
-	}
-
-	cmsghdr = CMSG_FIRSTHDR(&msghdr);
-
-	if (cmsghdr != NULL) {
-		memcpy(fd, CMSG_DATA(cmsghdr), sizeof(int));
-	} else {
-		*fd = -1;
-	}
-
-	return 0;
-}
+#define FILE_READ_STRING_CHUNK_LENGTH 65536
+#define FILE_MAX_ASYNC_READ_CHUNKS_PER_EVENT 64
+#define FILE_MAX_ASYNC_READ_CREDIT UINT16_MAX
+#define FILE_FOLLOW_EVENT_BUFFER_LENGTH 4096
+#define FILE_WRITE_BEHIND_BUFFER_LENGTH 65536
+#define FILE_WRITE_BEHIND_BLOCK_LENGTH 4096
+#define FILE_WRITE_BEHIND_IDLE_TIMEOUT 100000 // microseconds
+#define FILE_COMPRESSION_BUFFER_LENGTH 16384
+#define FILE_CHUNK_BUFFER_LENGTH 65536 // for checksum, signatures, delta and read/write based copy
+#define FILE_COPY_CHUNK_LENGTH 1048576 // for copy_file_range and sendfile based copy
+
+struct _FileFollow {
+	IOHandle inotify_fd;
+	int file_watch;
+	int directory_watch; // detects a new file replacing the followed one
+	bool waiting; // eventfd removed from event loop, at end-of-file
+	bool rotated; // reopen by name after reading the old file to its end
+	uint32_t idle_timeout; // seconds, zero to follow until aborted
+	WheelTimer idle_timer; // ends following if no data arrived for a while
+};
+
+struct _FileWriteBehind {
+	uint32_t length;
+	off_t position; // file position of the first buffered byte
+	int flush_errno; // error of last background flush, reported by the next write
+	WheelTimer timer; // flushes the buffer if no write happened for a while
+	uint8_t buffer[FILE_WRITE_BEHIND_BUFFER_LENGTH];
+};
+
+struct _FileCompression {
+	z_stream stream; // deflate if opened read-only, inflate if opened write-only
+	bool input_ended; // deflate only, end of the file was read
+	bool stream_ended; // end of the zlib stream was produced or consumed
+	uint8_t buffer[FILE_COMPRESSION_BUFFER_LENGTH]; // uncompressed data
+};
+
+typedef enum {
+	FILE_JOB_TYPE_CHECKSUM = 0,
+	FILE_JOB_TYPE_COPY,
+	FILE_JOB_TYPE_SIGNATURES,
+	FILE_JOB_TYPE_DELTA
+} FileJobType;
+
+// a file object runs at most one job at a time, the type specific job state
+// embeds this as its first member
+struct _FileJob {
+	FileJobType type;
+	File *file;
+	BackgroundJob background_job;
+};
+
+typedef struct {
+	FileJob base;
+
+	Checksum checksum;
+	uint64_t offset; // next position to read, independent of file position
+	uint64_t length_left;
+} FileChecksumJob;
+
+typedef enum {
+	FILE_COPY_METHOD_COPY_FILE_RANGE = 0,
+	FILE_COPY_METHOD_SENDFILE,
+	FILE_COPY_METHOD_READ_WRITE
+} FileCopyMethod;
+
+typedef struct {
+	FileJob base;
+
+	IOHandle source_fd;
+	FileCopyMethod method; // falls back to the next method if unsupported
+	uint64_t length;
+} FileCopyJob;
+
+typedef struct {
+	FileJob base;
+
+	uint32_t block_length;
+	uint32_t block_index; // next block to read, independent of file position
+} FileSignatureJob;
+
+typedef enum {
+	FILE_DELTA_COMMAND_NONE = 0, // the next command has to be read
+	FILE_DELTA_COMMAND_COPY,
+	FILE_DELTA_COMMAND_LITERAL
+} FileDeltaCommand;
+
+typedef struct {
+	FileJob base;
+
+	File *basis; // acquired while the job is in progress
+	File *delta; // acquired while the job is in progress
+	uint32_t block_length;
+	uint64_t offset; // next position to read in the delta file
+	FileDeltaCommand command;
+	uint64_t basis_offset; // next position to read in the basis file
+	uint64_t length_left; // of the current command
+	uint64_t length; // written to this file so far
+} FileDeltaJob;
+
+typedef struct {
+	uint8_t buffer[FILE_MAX_WRITE_ASYNC_BUFFER_LENGTH];
+	uint8_t length;
+	uint8_t length_written;
+} FileAsyncWrite;
+
+static uint8_t _chunk_buffer[FILE_CHUNK_BUFFER_LENGTH]; // only used from the event loop
+
+static void file_handle_writable_event(void *opaque);
+static void file_stop_async_read(File *file);
+static void file_handle_async_read(void *opaque);
+static APIE file_open_as(const char *name, uint32_t flags, int oflags,
+                         mode_t mode, uint32_t uid, uint32_t gid, IOHandle *fd_);
+static void file_stop_job(File *file);
+static int file_write_behind_flush(File *file, uint32_t length);
+static void file_write_behind_flush_all(File *file);
 
 static const char *file_get_type_name(FileType type) {
 	switch (type) {
@@ -135,6 +185,16 @@ static const char *file_get_type_name(FileType type) {
 	}
 }
 
+static const char *file_get_job_type_name(FileJobType type) {
+	switch (type) {
+	default:                       return "<unknown>";
+	case FILE_JOB_TYPE_CHECKSUM:   return "checksum";
+	case FILE_JOB_TYPE_COPY:       return "copy";
+	case FILE_JOB_TYPE_SIGNATURES: return "signatures";
+	case FILE_JOB_TYPE_DELTA:      return "delta";
+	}
+}
+
 static FileType file_get_type_from_stat_mode(mode_t mode) {
 	if (S_ISREG(mode)) {
 		return FILE_TYPE_REGULAR;
@@ -204,7 +264,70 @@ static void file_destroy(Object *object) {
 		log_warn("Destroying file object ("FILE_SIGNATURE_FORMAT") while an asynchronous read for %"PRIu64" byte(s) is in progress",
 		         file_expand_signature(file), file->length_to_read_async);
 
-		event_remove_source(file->async_read_eventfd, EVENT_SOURCE_TYPE_GENERIC);
+		file_stop_async_read(file);
+	}
+
+	if (file->job != NULL) {
+		log_warn("Destroying file object ("FILE_SIGNATURE_FORMAT") while a %s job is in progress",
+		         file_expand_signature(file), file_get_job_type_name(file->job->type));
+
+		file_stop_job(file);
+	}
+
+	if (file->write_behind != NULL) {
+		// don't report a flush error by callback here, the file object ID
+		// is about to be released and might already be reused by then
+		if (file->write_behind->length > 0 &&
+		    file_write_behind_flush(file, file->write_behind->length) < 0) {
+			log_error("Could not flush write-behind buffer of file object ("FILE_SIGNATURE_FORMAT") while destroying it: %s (%d)",
+			          file_expand_signature(file), get_errno_name(errno), errno);
+		}
+
+		wheel_timer_destroy(&file->write_behind->timer);
+		free(file->write_behind);
+	}
+
+	if (file->compression != NULL) {
+		if ((file->flags & FILE_FLAG_WRITE_ONLY) != 0) {
+			if (!file->compression->stream_ended) {
+				log_warn("Destroying file object ("FILE_SIGNATURE_FORMAT") before the end of the compressed stream was written",
+				         file_expand_signature(file));
+			}
+
+			inflateEnd(&file->compression->stream);
+		} else {
+			deflateEnd(&file->compression->stream);
+		}
+
+		free(file->compression);
+	}
+
+	if (file->archive_extractor != NULL) {
+		if (!archive_extractor_is_finished(file->archive_extractor)) {
+			log_warn("Destroying file object ("FILE_SIGNATURE_FORMAT") before the end of the archive was written, %u entries extracted",
+			         file_expand_signature(file),
+			         archive_extractor_get_entry_count(file->archive_extractor));
+		} else {
+			log_debug("Extracted %u entries from archive written to file object ("FILE_SIGNATURE_FORMAT")",
+			          archive_extractor_get_entry_count(file->archive_extractor),
+			          file_expand_signature(file));
+		}
+
+		archive_extractor_destroy(file->archive_extractor);
+	}
+
+	if (file->archive_creator != NULL) {
+		if (!archive_creator_is_finished(file->archive_creator)) {
+			log_debug("Destroying file object ("FILE_SIGNATURE_FORMAT") before the end of the archive was read, %u entries added",
+			          file_expand_signature(file),
+			          archive_creator_get_entry_count(file->archive_creator));
+		} else {
+			log_debug("Added %u entries to archive read from file object ("FILE_SIGNATURE_FORMAT")",
+			          archive_creator_get_entry_count(file->archive_creator),
+			          file_expand_signature(file));
+		}
+
+		archive_creator_destroy(file->archive_creator);
 	}
 
 	if (file->type == FILE_TYPE_PIPE) {
@@ -212,10 +335,16 @@ static void file_destroy(Object *object) {
 			event_remove_source(file->pipe.base.read_handle, EVENT_SOURCE_TYPE_GENERIC);
 		}
 
-		if ((file->events & FILE_EVENT_WRITABLE) != 0) {
+		if (file->writable_event_added) {
 			event_remove_source(file->pipe.base.write_handle, EVENT_SOURCE_TYPE_GENERIC);
 		}
 
+		if (file->async_write_queue.count > 0) {
+			log_warn("Destroying file object ("FILE_SIGNATURE_FORMAT") while %d asynchronous write(s) are still queued",
+			         file_expand_signature(file), file->async_write_queue.count);
+		}
+
+		queue_destroy(&file->async_write_queue, NULL);
 		pipe_destroy(&file->pipe);
 	} else {
 		// unlink before close, this is safe on POSIX systems
@@ -230,7 +359,7 @@ static void file_destroy(Object *object) {
 
 	string_unlock_and_release(file->name);
 
-	free(file);
+	inventory_free_object(OBJECT_TYPE_FILE, file);
 }
 
 static void file_signature(Object *object, char *signature) {
@@ -261,6 +390,60 @@ static void file_send_async_write_callback(File *file, APIE error_code,
 	}
 }
 
+static void file_send_async_checksum_callback(FileChecksumJob *job, APIE error_code,
+                                              uint8_t *checksum, uint8_t checksum_length) {
+	File *file = job->base.file;
+
+	// only send a async-file-checksum callback if there is at least one
+	// external reference to the file object. otherwise there is no one that
+	// could be interested in this callback anyway
+	if (file->base.external_reference_count > 0) {
+		api_send_async_file_checksum_callback(file->base.id, error_code,
+		                                      job->checksum.algorithm,
+		                                      checksum, checksum_length);
+	}
+}
+
+static void file_send_async_copy_callback(FileCopyJob *job, APIE error_code) {
+	File *file = job->base.file;
+
+	// only send a async-file-copied callback if there is at least one
+	// external reference to the file object. otherwise there is no one that
+	// could be interested in this callback anyway
+	if (file->base.external_reference_count > 0) {
+		api_send_async_file_copied_callback(file->base.id, error_code, job->length);
+	}
+}
+
+static void file_send_async_signature_callback(FileSignatureJob *job, APIE error_code,
+                                               uint32_t block_length,
+                                               uint32_t rolling_checksum,
+                                               uint8_t *strong_checksum) {
+	File *file = job->base.file;
+
+	// only send a async-file-signature callback if there is at least one
+	// external reference to the file object. otherwise there is no one that
+	// could be interested in this callback anyway
+	if (file->base.external_reference_count > 0) {
+		api_send_async_file_signature_callback(file->base.id, error_code,
+		                                       job->block_index,
+		                                       block_length, rolling_checksum,
+		                                       strong_checksum);
+	}
+}
+
+static void file_send_async_delta_callback(FileDeltaJob *job, APIE error_code) {
+	File *file = job->base.file;
+
+	// only send a async-file-delta-applied callback if there is at least one
+	// external reference to the file object. otherwise there is no one that
+	// could be interested in this callback anyway
+	if (file->base.external_reference_count > 0) {
+		api_send_async_file_delta_applied_callback(file->base.id, error_code,
+		                                           job->length);
+	}
+}
+
 static void file_send_events_occurred_callback(File *file, uint16_t events) {
 	// only send a file-events-occurred callback if there is at least one
 	// external reference to the file object. otherwise there is no one that
@@ -280,14 +463,94 @@ static void file_handle_readable_event(void *opaque) {
 	file_send_events_occurred_callback(file, FILE_EVENT_READABLE);
 }
 
+// the write handle is in the event loop if the client asked for writable
+// events or if there are queued asynchronous writes. sets errno on error
+static int file_update_writable_event(File *file) {
+	bool needed = (file->events & FILE_EVENT_WRITABLE) != 0 ||
+	              file->async_write_queue.count > 0;
+
+	if (needed && !file->writable_event_added) {
+		if (event_add_source(file->pipe.base.write_handle, EVENT_SOURCE_TYPE_GENERIC,
+		                     "pipe-write", EVENT_WRITE, file_handle_writable_event, file) < 0) {
+			return -1;
+		}
+
+		file->writable_event_added = true;
+	} else if (!needed && file->writable_event_added) {
+		event_remove_source(file->pipe.base.write_handle, EVENT_SOURCE_TYPE_GENERIC);
+
+		file->writable_event_added = false;
+	}
+
+	return 0;
+}
+
+// writes as much of the queued asynchronous writes as possible without
+// blocking and reports each completed or failed write by callback
+static void file_drain_async_write_queue(File *file) {
+	FileAsyncWrite *async_write;
+	int rc;
+	APIE error_code;
+
+	while (file->async_write_queue.count > 0) {
+		async_write = queue_peek(&file->async_write_queue);
+		rc = file->write(file, async_write->buffer + async_write->length_written,
+		                 async_write->length - async_write->length_written);
+
+		if (rc < 0) {
+			if (errno_interrupted()) {
+				continue;
+			}
+
+			if (errno_would_block()) {
+				return;
+			}
+
+			// the pipe is broken, fail all queued writes
+			error_code = api_get_error_code_from_errno();
+
+			log_error("Could not write %d queued asynchronous write(s) to file object ("FILE_SIGNATURE_FORMAT"): %s (%d)",
+			          file->async_write_queue.count, file_expand_signature(file),
+			          get_errno_name(errno), errno);
+
+			while (file->async_write_queue.count > 0) {
+				async_write = queue_peek(&file->async_write_queue);
+
+				file_send_async_write_callback(file, error_code, async_write->length_written);
+				queue_pop(&file->async_write_queue, NULL);
+			}
+
+			return;
+		}
+
+		async_write->length_written += rc;
+
+		if (async_write->length_written < async_write->length) {
+			continue;
+		}
+
+		file_send_async_write_callback(file, API_E_SUCCESS, async_write->length);
+		queue_pop(&file->async_write_queue, NULL);
+	}
+}
+
 static void file_handle_writable_event(void *opaque) {
 	File *file = opaque;
 
-	event_remove_source(file->pipe.base.write_handle, EVENT_SOURCE_TYPE_GENERIC);
+	file_drain_async_write_queue(file);
+
+	// only report writability to the client once all queued asynchronous
+	// writes are done, otherwise the client might interleave its writes
+	if ((file->events & FILE_EVENT_WRITABLE) != 0 && file->async_write_queue.count == 0) {
+		file->events &= ~FILE_EVENT_WRITABLE;
 
-	file->events &= ~FILE_EVENT_WRITABLE;
+		file_send_events_occurred_callback(file, FILE_EVENT_WRITABLE);
+	}
 
-	file_send_events_occurred_callback(file, FILE_EVENT_WRITABLE);
+	if (file_update_writable_event(file) < 0) {
+		log_error("Could not update writable event of file object ("FILE_SIGNATURE_FORMAT"): %s (%d)",
+		          file_expand_signature(file), get_errno_name(errno), errno);
+	}
 }
 
 // sets errno on error
@@ -317,1039 +580,3232 @@ static off_t file_handle_seek(File *file, off_t offset, int whence) {
 	return lseek(file->fd, offset, whence);
 }
 
-// sets errno on error
-static int pipe_handle_read(File *file, void *buffer, int length) {
-	if ((file->flags & PIPE_FLAG_NON_BLOCKING_READ) == 0) {
-		errno = ENOTSUP;
+/*
+ * if FILE_FLAG_WRITE_BEHIND is used then the read, write and seek functions
+ * of the file object are replaced by variants that go through a write-behind
+ * buffer. small writes are merged in this buffer and written to the file in
+ * large block-aligned chunks. the buffer is flushed before each read and seek,
+ * if it is full, if no write happened for FILE_WRITE_BEHIND_IDLE_TIMEOUT and
+ * when the file object is destroyed. errors of background flushes are reported
+ * by an async-file-write callback and by the next write. errors of the final
+ * flush on destruction are only logged
+ */
 
-		return -1;
-	}
+// writes the first length bytes of the write-behind buffer to the file. on
+// error the buffer is discarded. sets errno on error
+static int file_write_behind_flush(File *file, uint32_t length) {
+	FileWriteBehind *write_behind = file->write_behind;
+	uint32_t offset = 0;
+	int rc;
 
-	return pipe_read(&file->pipe, buffer, length);
-}
+	while (offset < length) {
+		rc = file_handle_write(file, write_behind->buffer + offset, length - offset);
 
-// sets errno on error
-static int pipe_handle_write(File *file, void *buffer, int length) {
-	if ((file->flags & PIPE_FLAG_NON_BLOCKING_WRITE) == 0) {
-		errno = ENOTSUP;
+		if (rc < 0) {
+			write_behind->length = 0;
 
-		return -1;
-	}
+			wheel_timer_configure(&write_behind->timer, 0, 0);
 
-	return pipe_write(&file->pipe, buffer, length);
-}
+			return -1;
+		}
 
-// sets errno on error
-static off_t pipe_handle_seek(File *file, off_t offset, int whence) {
-	(void)file;
-	(void)offset;
-	(void)whence;
+		offset += rc;
+	}
 
-	errno = ESPIPE;
+	write_behind->length -= length;
+	write_behind->position += length;
 
-	return (off_t)-1;
+	if (write_behind->length > 0) {
+		memmove(write_behind->buffer, write_behind->buffer + length,
+		        write_behind->length);
+	} else {
+		wheel_timer_configure(&write_behind->timer, 0, 0);
+	}
+
+	return 0;
 }
 
-// FIXME: maybe add a loop here and read multiple times per read event
-static void file_handle_async_read(void *opaque) {
-	File *file = opaque;
-	uint8_t buffer[FILE_MAX_READ_ASYNC_BUFFER_LENGTH];
-	uint8_t length_to_read = sizeof(buffer);
-	int length_read;
+// flushes the whole write-behind buffer, if any, and reports errors
+// asynchronously
+static void file_write_behind_flush_all(File *file) {
+	FileWriteBehind *write_behind = file->write_behind;
 	APIE error_code;
 
-	if (!file->async_read_in_progress) {
-		log_error("Got asynchronous read event for file object ("FILE_SIGNATURE_FORMAT") without an asynchronous read in progress",
-		          file_expand_signature(file));
-
-		event_remove_source(file->async_read_eventfd, EVENT_SOURCE_TYPE_GENERIC);
-
+	if (write_behind == NULL || write_behind->length == 0) {
 		return;
 	}
 
-	if (length_to_read > file->length_to_read_async) {
-		length_to_read = file->length_to_read_async;
-	}
-
-	length_read = file->read(file, buffer, length_to_read);
-
-	if (length_read < 0) {
-		if (errno_interrupted()) {
-			log_debug("Reading from file object ("FILE_SIGNATURE_FORMAT") asynchronously was interrupted, retrying",
-			          file_expand_signature(file));
-
-			return;
-		} else if (errno_would_block()) {
-			// don't report an error, just return an empty buffer if there is
-			// nothing to read at this time
-			length_read = 0;
-		} else {
-			error_code = api_get_error_code_from_errno();
-
-			log_error("Could not read %u byte(s) from file object ("FILE_SIGNATURE_FORMAT") asynchronously: %s (%d)",
-			          length_to_read, file_expand_signature(file),
-			          get_errno_name(errno), errno);
-
-			event_remove_source(file->async_read_eventfd, EVENT_SOURCE_TYPE_GENERIC);
-
-			file->async_read_in_progress = false;
-			file->length_to_read_async = 0;
+	if (file_write_behind_flush(file, write_behind->length) < 0) {
+		write_behind->flush_errno = errno;
+		error_code = api_get_error_code_from_errno();
 
-			file_send_async_read_callback(file, error_code, NULL, 0);
+		log_error("Could not flush write-behind buffer of file object ("FILE_SIGNATURE_FORMAT"): %s (%d)",
+		          file_expand_signature(file), get_errno_name(write_behind->flush_errno),
+		          write_behind->flush_errno);
 
-			return;
-		}
+		file_send_async_write_callback(file, error_code, 0);
 	}
+}
 
-	file->length_to_read_async -= length_read;
+static void file_handle_write_behind_timeout(void *opaque) {
+	File *file = opaque;
 
-	log_debug("Read %d byte(s) from file object ("FILE_SIGNATURE_FORMAT") asynchronously, %"PRIu64" byte(s) left to read",
-	          length_read, file_expand_signature(file), file->length_to_read_async);
+	log_debug("Flushing %u byte(s) of idle write-behind buffer of file object ("FILE_SIGNATURE_FORMAT")",
+	          file->write_behind->length, file_expand_signature(file));
 
-	if (length_read == 0 || file->length_to_read_async == 0) {
-		// finished asynchronous reading either because there is nothing
-		// to read or the request amount was read
-		file->async_read_in_progress = false;
-		file->length_to_read_async = 0;
+	file_write_behind_flush_all(file);
+}
 
-		event_remove_source(file->async_read_eventfd, EVENT_SOURCE_TYPE_GENERIC);
+// sets errno on error
+static int file_handle_write_behind_read(File *file, void *buffer, int length) {
+	if (file->write_behind->length > 0 &&
+	    file_write_behind_flush(file, file->write_behind->length) < 0) {
+		return -1;
 	}
 
-	file_send_async_read_callback(file, API_E_SUCCESS, buffer, length_read);
-
-	if (!file->async_read_in_progress) {
-		log_debug("Finished asynchronous reading from file object ("FILE_SIGNATURE_FORMAT")",
-		          file_expand_signature(file));
-	}
+	return file_handle_read(file, buffer, length);
 }
 
-// NOTE: assumes that name is absolute (starts with '/')
-static APIE file_open_as(const char *name, uint32_t flags, int oflags,
-                         mode_t mode, uint32_t uid, uint32_t gid, IOHandle *fd_) {
-	APIE error_code;
-	int pair[2];
-	pid_t pid;
-	int fd = -1;
-	int rc;
-	int status;
-
-	// create socket pair to pass FD from child to parent
-	if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) < 0) {
-		error_code = api_get_error_code_from_errno();
+// sets errno on error
+static int file_handle_write_behind_write(File *file, void *buffer, int length) {
+	FileWriteBehind *write_behind = file->write_behind;
+	off_t position;
+	uint32_t flush_length;
 
-		log_error("Could not create socket pair for opening file '%s': %s (%d)",
-		          name, get_errno_name(errno), errno);
+	if ((file->flags & FILE_FLAG_NON_BLOCKING) == 0) {
+		errno = ENOTSUP;
 
-		return error_code;
+		return -1;
 	}
 
-	error_code = process_fork(&pid);
+	if (write_behind->flush_errno != 0) {
+		errno = write_behind->flush_errno;
+		write_behind->flush_errno = 0;
 
-	if (error_code != API_E_SUCCESS) {
-		return error_code;
+		return -1;
 	}
 
-	if (pid == 0) { // child
-		// close socket pair read end in child
-		close(pair[0]);
+	if (write_behind->length + length > FILE_WRITE_BEHIND_BUFFER_LENGTH) {
+		// only write up to the last block boundary, keep the rest buffered
+		flush_length = (write_behind->position + write_behind->length) % FILE_WRITE_BEHIND_BLOCK_LENGTH;
 
-		// change user and groups
-		error_code = process_set_identity(uid, gid);
-
-		if (error_code != API_E_SUCCESS) {
-			goto child_cleanup;
+		if (flush_length < write_behind->length &&
+		    write_behind->length - flush_length + length <= FILE_WRITE_BEHIND_BUFFER_LENGTH) {
+			flush_length = write_behind->length - flush_length;
+		} else {
+			flush_length = write_behind->length;
 		}
 
-		// open file
-		fd = open(name, oflags, mode);
-
-		if (fd < 0) {
-			error_code = api_get_error_code_from_errno();
+		if (file_write_behind_flush(file, flush_length) < 0) {
+			return -1;
+		}
 
-			if (errno == ENOENT) {
-				log_debug("Could not open non-existing file '%s'", name);
-			} else if ((flags & (FILE_FLAG_CREATE | FILE_FLAG_EXCLUSIVE)) ==
-			           (FILE_FLAG_CREATE | FILE_FLAG_EXCLUSIVE) && errno == EEXIST) {
-				log_debug("Could not exclusively create already existing file '%s'", name);
-			} else {
-				log_error("Could not open file '%s' with flags 0x%04X as %u:%u: %s (%d)",
-				          name, flags, uid, gid, get_errno_name(errno), errno);
+		// writes that are too large for the buffer bypass it
+		if (length > FILE_WRITE_BEHIND_BUFFER_LENGTH) {
+			if (write_behind->length > 0 &&
+			    file_write_behind_flush(file, write_behind->length) < 0) {
+				return -1;
 			}
 
-			goto child_cleanup;
+			return file_handle_write(file, buffer, length);
 		}
+	}
 
-		error_code = API_E_SUCCESS;
+	if (write_behind->length == 0) {
+		position = file_handle_seek(file, 0, SEEK_CUR);
 
-	child_cleanup:
-		// send FD to parent in all cases
-		do {
-			rc = sendfd(pair[1], fd);
-		} while (rc < 0 && errno_interrupted());
+		write_behind->position = position != (off_t)-1 ? position : 0;
+	}
 
-		if (rc < 0) {
-			log_error("Could not send file descriptor to parent process for file '%s': %s (%d)",
-			          name, get_errno_name(errno), errno);
+	memcpy(write_behind->buffer + write_behind->length, buffer, length);
 
-			if (fd >= 0) {
-				close(fd);
-			}
-		}
+	write_behind->length += length;
 
-		// close socket pair write end in child
-		close(pair[1]);
+	// restarting the timer is an in-memory operation of the timer wheel
+	if (wheel_timer_configure(&write_behind->timer, FILE_WRITE_BEHIND_IDLE_TIMEOUT, 0) < 0) {
+		log_warn("Could not start write-behind timer of file object ("FILE_SIGNATURE_FORMAT"), flushing now",
+		         file_expand_signature(file));
 
-		// report error code as exit status
-		_exit(error_code);
+		if (file_write_behind_flush(file, write_behind->length) < 0) {
+			return -1;
+		}
 	}
 
-	// close socket pair write end in parent
-	close(pair[1]);
+	return length;
+}
 
-	// receive FD from child
-	do {
-		rc = recvfd(pair[0], &fd);
-	} while (rc < 0 && errno_interrupted());
+// sets errno on error
+static off_t file_handle_write_behind_seek(File *file, off_t offset, int whence) {
+	if (file->write_behind->length > 0 &&
+	    file_write_behind_flush(file, file->write_behind->length) < 0) {
+		return (off_t)-1;
+	}
 
-	if (rc < 0) {
-		error_code = api_get_error_code_from_errno();
+	return file_handle_seek(file, offset, whence);
+}
 
-		log_error("Could not receive file descriptor from child process opening file '%s' as %u:%u: %s (%d)",
-		          name, uid, gid, get_errno_name(errno), errno);
+/*
+ * if FILE_FLAG_COMPRESSED is used then the read, write and seek functions of
+ * the file object are replaced by variants that transfer a zlib stream. if the
+ * file is opened read-only then reading produces the deflate compressed file
+ * content. if the file is opened write-only then writing consumes a deflate
+ * compressed stream and writes the inflated data to the file. this reduces the
+ * number of packets to transfer compressible files such as logs or sources.
+ * seeking is not supported, because the stream cannot be repositioned
+ */
 
-		// close socket pair read end in parent
-		close(pair[0]);
+// sets errno on error
+static int file_handle_compressed_read(File *file, void *buffer, int length) {
+	FileCompression *compression = file->compression;
+	z_stream *stream = &compression->stream;
+	int length_read;
+	int rc;
 
-		// wait for child to exit
-		while (waitpid(pid, NULL, 0) < 0 && errno_interrupted());
+	if ((file->flags & FILE_FLAG_NON_BLOCKING) == 0) {
+		errno = ENOTSUP;
 
-		return error_code;
+		return -1;
 	}
 
-	// close socket pair read end in parent
-	close(pair[0]);
+	if ((file->flags & FILE_FLAG_READ_ONLY) == 0) {
+		errno = EBADF;
 
-	// wait for child to exit
-	do {
-		rc = waitpid(pid, &status, 0);
-	} while (rc < 0 && errno_interrupted());
+		return -1;
+	}
 
-	if (rc < 0) {
-		error_code = api_get_error_code_from_errno();
+	stream->next_out = buffer;
+	stream->avail_out = length;
 
-		log_error("Could not wait for child process opening file '%s' as %u:%u: %s (%d)",
-		          name, uid, gid, get_errno_name(errno), errno);
+	// only return zero bytes at the end of the compressed stream, callers
+	// interpret this as end-of-file
+	while (stream->avail_out > 0 && !compression->stream_ended) {
+		if (stream->avail_in == 0 && !compression->input_ended) {
+			length_read = robust_read(file->fd, compression->buffer, sizeof(compression->buffer));
 
-		if (fd >= 0) {
-			close(fd);
-		}
+			if (length_read < 0) {
+				if (stream->avail_out < (uInt)length) {
+					break; // report the error on the next call
+				}
 
-		return error_code;
-	}
+				return -1;
+			}
 
-	// check if child exited normally
-	if (!WIFEXITED(status)) {
-		log_error("Child process opening file '%s' as %u:%u did not exit normally",
-		          name, uid, gid);
+			if (length_read == 0) {
+				compression->input_ended = true;
+			}
 
-		if (fd >= 0) {
-			close(fd);
+			stream->next_in = compression->buffer;
+			stream->avail_in = length_read;
 		}
 
-		return API_E_INTERNAL_ERROR;
-	}
+		rc = deflate(stream, compression->input_ended ? Z_FINISH : Z_NO_FLUSH);
 
-	// get child error code from child exit status
-	error_code = WEXITSTATUS(status);
+		if (rc == Z_STREAM_END) {
+			compression->stream_ended = true;
+		} else if (rc != Z_OK && rc != Z_BUF_ERROR) {
+			log_error("Could not compress data of file object ("FILE_SIGNATURE_FORMAT"): %s (%d)",
+			          file_expand_signature(file), stream->msg != NULL ? stream->msg : "<unknown>", rc);
 
-	if (error_code != API_E_SUCCESS) {
-		if (fd >= 0) {
-			close(fd);
-		}
+			errno = EIO;
 
-		return error_code;
+			return -1;
+		}
 	}
 
-	// check if FD is invalid after child process exited successfully. this
-	// should not be possible. the check is here just to be on the safe side
-	if (fd < 0) {
-		log_error("Child process opening file '%s' as %u:%u succeeded, but returned an invalid file descriptor",
-		          name, uid, gid);
+	return length - stream->avail_out;
+}
 
-		return API_E_INTERNAL_ERROR;
-	}
+// returns the number of consumed compressed bytes. sets errno on error
+static int file_handle_compressed_write(File *file, void *buffer, int length) {
+	FileCompression *compression = file->compression;
+	z_stream *stream = &compression->stream;
+	uint32_t length_inflated;
+	uint32_t offset;
+	int rc;
 
-	*fd_ = fd;
+	if ((file->flags & FILE_FLAG_NON_BLOCKING) == 0) {
+		errno = ENOTSUP;
 
-	return API_E_SUCCESS;
-}
+		return -1;
+	}
 
-static int file_get_oflags_from_flags(uint32_t flags) {
-	int oflags = 0;
+	if ((file->flags & FILE_FLAG_WRITE_ONLY) == 0) {
+		errno = EBADF;
 
-	if ((flags & FILE_FLAG_READ_ONLY) != 0) {
-		oflags |= O_RDONLY;
+		return -1;
 	}
 
-	if ((flags & FILE_FLAG_WRITE_ONLY) != 0) {
-		oflags |= O_WRONLY;
-	}
+	if (compression->stream_ended) {
+		errno = EINVAL; // data after the end of the compressed stream
 
-	if ((flags & FILE_FLAG_READ_WRITE) != 0) {
-		oflags |= O_RDWR;
+		return -1;
 	}
 
-	if ((flags & FILE_FLAG_APPEND) != 0) {
-		oflags |= O_APPEND;
-	}
+	stream->next_in = buffer;
+	stream->avail_in = length;
 
-	if ((flags & FILE_FLAG_CREATE) != 0) {
-		oflags |= O_CREAT;
-	}
+	// inflate until all input is consumed and no more output is pending
+	do {
+		stream->next_out = compression->buffer;
+		stream->avail_out = sizeof(compression->buffer);
 
-	if ((flags & FILE_FLAG_EXCLUSIVE) != 0) {
-		oflags |= O_EXCL;
-	}
+		rc = inflate(stream, Z_NO_FLUSH);
 
-	if ((flags & FILE_FLAG_NON_BLOCKING) != 0) {
-		oflags |= O_NONBLOCK;
-	}
+		if (rc == Z_STREAM_END) {
+			compression->stream_ended = true;
+		} else if (rc != Z_OK && rc != Z_BUF_ERROR) {
+			log_error("Could not decompress data for file object ("FILE_SIGNATURE_FORMAT"): %s (%d)",
+			          file_expand_signature(file), stream->msg != NULL ? stream->msg : "<unknown>", rc);
 
-	if ((flags & FILE_FLAG_TRUNCATE) != 0) {
-		oflags |= O_TRUNC;
-	}
+			errno = EINVAL;
 
-	return oflags;
-}
+			return -1;
+		}
 
-mode_t file_get_mode_from_permissions(uint16_t permissions) {
-	mode_t mode = 0;
+		length_inflated = sizeof(compression->buffer) - stream->avail_out;
 
-	if ((permissions & FILE_PERMISSION_USER_READ) != 0) {
-		mode |= S_IRUSR;
-	}
+		for (offset = 0; offset < length_inflated; offset += rc) {
+			rc = robust_write(file->fd, compression->buffer + offset, length_inflated - offset);
 
-	if ((permissions & FILE_PERMISSION_USER_WRITE) != 0) {
-		mode |= S_IWUSR;
-	}
+			if (rc < 0) {
+				return -1;
+			}
+		}
+	} while ((stream->avail_in > 0 || stream->avail_out == 0) && !compression->stream_ended);
 
-	if ((permissions & FILE_PERMISSION_USER_EXECUTE) != 0) {
-		mode |= S_IXUSR;
-	}
+	return length - stream->avail_in;
+}
 
-	if ((permissions & FILE_PERMISSION_GROUP_READ) != 0) {
-		mode |= S_IRGRP;
-	}
+// sets errno on error
+static off_t file_handle_compressed_seek(File *file, off_t offset, int whence) {
+	(void)file;
+	(void)offset;
+	(void)whence;
 
-	if ((permissions & FILE_PERMISSION_GROUP_WRITE) != 0) {
-		mode |= S_IWGRP;
-	}
+	errno = ESPIPE;
 
-	if ((permissions & FILE_PERMISSION_GROUP_EXECUTE) != 0) {
-		mode |= S_IXGRP;
-	}
+	return (off_t)-1;
+}
 
-	if ((permissions & FILE_PERMISSION_OTHERS_READ) != 0) {
-		mode |= S_IROTH;
-	}
+// sets errno on error
+static int pipe_handle_archive_write(File *file, void *buffer, int length) {
+	APIE error_code = archive_extractor_write(file->archive_extractor, buffer, length);
 
-	if ((permissions & FILE_PERMISSION_OTHERS_WRITE) != 0) {
-		mode |= S_IWOTH;
-	}
+	if (error_code != API_E_SUCCESS) {
+		errno = api_get_errno_from_error_code(error_code);
 
-	if ((permissions & FILE_PERMISSION_OTHERS_EXECUTE) != 0) {
-		mode |= S_IXOTH;
+		return -1;
 	}
 
-	return mode;
+	return length;
 }
 
-// public API
-APIE file_open(ObjectID name_id, uint32_t flags, uint16_t permissions,
-               uint32_t uid, uint32_t gid, Session *session,
-               uint16_t object_create_flags, ObjectID *id, File **object) {
-	int phase = 0;
-	APIE error_code;
-	int oflags = O_NOCTTY;
-	mode_t mode = 0;
-	String *name;
-	IOHandle fd;
-	IOHandle async_read_eventfd;
-	File *file;
-	struct stat st;
-
-	// check parameters
-	if ((flags & ~FILE_FLAG_ALL) != 0) {
-		error_code = API_E_INVALID_PARAMETER;
+// returns zero at the end of the archive. sets errno on error
+static int pipe_handle_archive_read(File *file, void *buffer, int length) {
+	uint32_t length_read;
+	APIE error_code = archive_creator_read(file->archive_creator, buffer, length, &length_read);
 
-		log_warn("Invalid file flags 0x%04X", flags);
+	if (error_code != API_E_SUCCESS) {
+		errno = api_get_errno_from_error_code(error_code);
 
-		goto cleanup;
+		return -1;
 	}
 
-	if ((permissions & ~FILE_PERMISSION_ALL) != 0) {
-		error_code = API_E_INVALID_PARAMETER;
+	return length_read;
+}
 
-		log_warn("Invalid file permissions 0o%04o", permissions);
+// the archive can only be read. sets errno
+static int pipe_handle_archive_read_only_write(File *file, void *buffer, int length) {
+	(void)file;
+	(void)buffer;
+	(void)length;
 
-		goto cleanup;
-	}
+	errno = EBADF;
 
-	if ((flags & FILE_FLAG_CREATE) != 0 && permissions == 0) {
-		error_code = API_E_INVALID_PARAMETER;
+	return -1;
+}
 
-		log_warn("FILE_FLAG_CREATE used without specifying file permissions");
+static int pipe_handle_read(File *file, void *buffer, int length) {
+	if ((file->flags & PIPE_FLAG_NON_BLOCKING_READ) == 0) {
+		errno = ENOTSUP;
 
-		goto cleanup;
+		return -1;
 	}
 
-	if ((flags & FILE_FLAG_CREATE) == 0 && permissions != 0) {
-		error_code = API_E_INVALID_PARAMETER;
+	return pipe_read(&file->pipe, buffer, length);
+}
 
-		log_warn("Permissions specified without using FILE_FLAG_CREATE");
+// sets errno on error
+static int pipe_handle_write(File *file, void *buffer, int length) {
+	if ((file->flags & PIPE_FLAG_NON_BLOCKING_WRITE) == 0) {
+		errno = ENOTSUP;
 
-		goto cleanup;
+		return -1;
 	}
 
-	// translate flags
-	oflags |= file_get_oflags_from_flags(flags);
+	return pipe_write(&file->pipe, buffer, length);
+}
 
-	if ((flags & FILE_FLAG_TEMPORARY) != 0 &&
-	    ((flags & FILE_FLAG_CREATE) == 0 || (flags & FILE_FLAG_EXCLUSIVE) == 0)) {
-		error_code = API_E_INVALID_PARAMETER;
+// sets errno on error
+static off_t pipe_handle_seek(File *file, off_t offset, int whence) {
+	(void)file;
+	(void)offset;
+	(void)whence;
 
-		log_warn("FILE_FLAG_TEMPORARY used without using FILE_FLAG_CREATE and FILE_FLAG_EXCLUSIVE as well");
+	errno = ESPIPE;
 
-		goto cleanup;
-	}
+	return (off_t)-1;
+}
 
-	if ((flags & FILE_FLAG_REPLACE) != 0 && (flags & FILE_FLAG_CREATE) == 0) {
-		error_code = API_E_INVALID_PARAMETER;
+static void file_stop_follow(File *file) {
+	event_remove_source(file->follow->inotify_fd, EVENT_SOURCE_TYPE_GENERIC);
+	close(file->follow->inotify_fd);
+	wheel_timer_destroy(&file->follow->idle_timer);
+	free(file->follow);
 
-		log_warn("FILE_FLAG_REPLACE used without using FILE_FLAG_CREATE as well");
+	file->follow = NULL;
+}
 
-		goto cleanup;
+static void file_stop_async_read(File *file) {
+	if (!file->async_read_paused && (file->follow == NULL || !file->follow->waiting)) {
+		event_remove_source(file->async_read_eventfd, EVENT_SOURCE_TYPE_GENERIC);
 	}
 
-	// translate create permissions
-	if ((flags & FILE_FLAG_CREATE) != 0) {
-		mode |= file_get_mode_from_permissions(permissions);
+	if (file->follow != NULL) {
+		file_stop_follow(file);
 	}
 
-	// acquire and lock name string object
-	error_code = string_get_acquired_and_locked(name_id, "file_open:name", &name);
+	file->async_read_in_progress = false;
+	file->length_to_read_async = 0;
+	file->async_read_credit_mode = false;
+	file->async_read_credit = 0;
+	file->async_read_paused = false;
+}
+
+// the followed file was replaced by a new file with the same name, for example
+// by log rotation. reopen the name and continue reading the new file from its
+// beginning
+static APIE file_follow_reopen(File *file) {
+	int oflags = O_RDONLY | O_NOCTTY;
+	IOHandle fd;
+	APIE error_code;
+
+	if ((file->flags & FILE_FLAG_NON_BLOCKING) != 0) {
+		oflags |= O_NONBLOCK;
+	}
+
+	// open with the same identity as the followed file
+	error_code = file_open_as(file->name->buffer, FILE_FLAG_READ_ONLY, oflags,
+	                          0, file->uid, file->gid, &fd);
 
 	if (error_code != API_E_SUCCESS) {
-		goto cleanup;
+		return error_code;
 	}
 
-	phase = 1;
+	// keep the handle number, so nothing else has to be updated
+	if (dup2(fd, file->fd) < 0) {
+		error_code = api_get_error_code_from_errno();
 
-	if (*name->buffer == '\0') {
-		error_code = API_E_INVALID_PARAMETER;
+		log_error("Could not replace handle of file object ("FILE_SIGNATURE_FORMAT"): %s (%d)",
+		          file_expand_signature(file), get_errno_name(errno), errno);
 
-		log_warn("File name cannot be empty");
+		close(fd);
 
-		goto cleanup;
+		return error_code;
 	}
 
-	if (*name->buffer != '/') {
-		error_code = API_E_INVALID_PARAMETER;
-
-		log_warn("Cannot open/create file with relative name '%s'", name->buffer);
+	close(fd);
 
-		goto cleanup;
+	if (file->follow->file_watch >= 0) {
+		inotify_rm_watch(file->follow->inotify_fd, file->follow->file_watch);
 	}
 
-	// unlink existing
-	if ((flags & FILE_FLAG_REPLACE) != 0) {
-		if (unlink(name->buffer) < 0 && errno != ENOENT) {
-			error_code = api_get_error_code_from_errno();
+	file->follow->file_watch = inotify_add_watch(file->follow->inotify_fd,
+	                                            file->name->buffer, IN_MODIFY);
 
-			log_error("Could not unlink '%s' to replace it: %s (%d)",
-			          name->buffer, get_errno_name(errno), errno);
+	if (file->follow->file_watch < 0) {
+		error_code = api_get_error_code_from_errno();
 
-			goto cleanup;
-		}
+		log_error("Could not watch file object ("FILE_SIGNATURE_FORMAT"): %s (%d)",
+		          file_expand_signature(file), get_errno_name(errno), errno);
+
+		return error_code;
 	}
 
-	// open file
-	if (geteuid() == uid && getegid() == gid) {
-		fd = open(name->buffer, oflags, mode);
+	file->follow->rotated = false;
 
-		if (fd < 0) {
-			error_code = api_get_error_code_from_errno();
+	log_debug("Reopened rotated file object ("FILE_SIGNATURE_FORMAT") to follow it",
+	          file_expand_signature(file));
 
-			if (errno == ENOENT) {
-				log_debug("Could not open non-existing file '%s'", name->buffer);
-			} else if ((flags & (FILE_FLAG_CREATE | FILE_FLAG_EXCLUSIVE)) ==
-			           (FILE_FLAG_CREATE | FILE_FLAG_EXCLUSIVE) && errno == EEXIST) {
-				log_debug("Could not exclusively create already existing file '%s'",
-				          name->buffer);
-			} else {
-				log_error("Could not open file '%s' with flags 0x%04X as %u:%u: %s (%d)",
-				          name->buffer, flags, uid, gid, get_errno_name(errno), errno);
-			}
+	return API_E_SUCCESS;
+}
 
-			goto cleanup;
-		}
-	} else {
-		error_code = file_open_as(name->buffer, flags, oflags, mode, uid, gid, &fd);
+// called if reading in follow mode reached the end of the file. returns 0 if
+// the asynchronous read continues or -1 if it failed
+static int file_handle_follow_end_of_file(File *file) {
+	struct stat st;
+	off_t position;
+	APIE error_code;
+
+	// the old file was read to its end, switch to the new one
+	if (file->follow->rotated) {
+		error_code = file_follow_reopen(file);
 
 		if (error_code != API_E_SUCCESS) {
-			goto cleanup;
+			file_stop_async_read(file);
+			file_send_async_read_callback(file, error_code, NULL, 0);
+
+			return -1;
 		}
+
+		return 0; // continue reading on next event
 	}
 
-	phase = 2;
+	// the file was truncated, for example by copy-and-truncate log rotation
+	position = lseek(file->fd, 0, SEEK_CUR);
 
-	if (fstat(fd, &st) < 0) {
-		error_code = api_get_error_code_from_errno();
+	if (position > 0 && fstat(file->fd, &st) >= 0 && st.st_size < position) {
+		log_debug("Followed file object ("FILE_SIGNATURE_FORMAT") was truncated, reading from its beginning",
+		          file_expand_signature(file));
 
-		log_error("Could not get information for file '%s': %s (%d)",
-		          name->buffer, get_errno_name(errno), errno);
+		lseek(file->fd, 0, SEEK_SET);
 
-		goto cleanup;
+		return 0; // continue reading on next event
 	}
 
-	// allocate file object
-	file = calloc(1, sizeof(File));
+	// stop polling the eventfd until the inotify handle reports a change
+	event_remove_source(file->async_read_eventfd, EVENT_SOURCE_TYPE_GENERIC);
 
-	if (file == NULL) {
-		error_code = API_E_NO_FREE_MEMORY;
+	file->follow->waiting = true;
+
+	return 0;
+}
+
+static void file_handle_follow_event(void *opaque) {
+	File *file = opaque;
+	uint8_t buffer[FILE_FOLLOW_EVENT_BUFFER_LENGTH] __attribute__((aligned(__alignof__(struct inotify_event))));
+	struct inotify_event *event;
+	const char *basename = strrchr(file->name->buffer, '/') + 1;
+	ssize_t length;
+	ssize_t offset;
+	bool changed = false;
+
+	for (;;) {
+		length = read(file->follow->inotify_fd, buffer, sizeof(buffer));
+
+		if (length < 0) {
+			if (errno_interrupted()) {
+				continue;
+			}
+
+			if (!errno_would_block()) {
+				log_error("Could not read from inotify handle of file object ("FILE_SIGNATURE_FORMAT"): %s (%d)",
+				          file_expand_signature(file), get_errno_name(errno), errno);
+			}
+
+			break;
+		}
+
+		for (offset = 0; offset < length; offset += sizeof(struct inotify_event) + event->len) {
+			event = (struct inotify_event *)(buffer + offset);
+
+			if (event->wd == file->follow->file_watch && (event->mask & IN_MODIFY) != 0) {
+				changed = true;
+			} else if (event->wd == file->follow->directory_watch && event->len > 0 &&
+			           strcmp(event->name, basename) == 0) {
+				file->follow->rotated = true;
+				changed = true;
+			}
+		}
+	}
+
+	if (changed && file->follow->waiting) {
+		if (event_add_source(file->async_read_eventfd, EVENT_SOURCE_TYPE_GENERIC,
+		                     "file-async-read", EVENT_READ, file_handle_async_read, file) < 0) {
+			file_stop_async_read(file); // eventfd is not in the event loop
+			file_send_async_read_callback(file, API_E_INTERNAL_ERROR, NULL, 0);
+
+			return;
+		}
+
+		file->follow->waiting = false;
+	}
+}
+
+static void file_handle_follow_idle_timeout(void *opaque) {
+	File *file = opaque;
+
+	log_debug("Stopped following file object ("FILE_SIGNATURE_FORMAT"), no new data arrived",
+	          file_expand_signature(file));
+
+	// report the end like an asynchronous read that reached end-of-file
+	file_stop_async_read(file);
+	file_send_async_read_callback(file, API_E_SUCCESS, NULL, 0);
+}
+
+// reads one chunk and sends it as async-file-read callback. returns 1 if the
+// asynchronous read continues, 0 if reading was interrupted without sending a
+// callback and -1 if the asynchronous read is finished or failed
+static int file_handle_async_read_chunk(File *file) {
+	uint8_t buffer[FILE_MAX_READ_ASYNC_BUFFER_LENGTH];
+	uint8_t length_to_read = sizeof(buffer);
+	int length_read;
+	APIE error_code;
+
+	if (length_to_read > file->length_to_read_async) {
+		length_to_read = file->length_to_read_async;
+	}
+
+	length_read = file->read(file, buffer, length_to_read);
+
+	if (length_read < 0) {
+		if (errno_interrupted()) {
+			log_debug("Reading from file object ("FILE_SIGNATURE_FORMAT") asynchronously was interrupted, retrying",
+			          file_expand_signature(file));
+
+			return 0;
+		} else if (errno_would_block()) {
+			// don't report an error, just return an empty buffer if there is
+			// nothing to read at this time
+			length_read = 0;
+		} else {
+			error_code = api_get_error_code_from_errno();
+
+			log_error("Could not read %u byte(s) from file object ("FILE_SIGNATURE_FORMAT") asynchronously: %s (%d)",
+			          length_to_read, file_expand_signature(file),
+			          get_errno_name(errno), errno);
+
+			file_stop_async_read(file);
+			file_send_async_read_callback(file, error_code, NULL, 0);
+
+			return -1;
+		}
+	}
+
+	if (file->follow != NULL) {
+		if (length_read == 0) {
+			return file_handle_follow_end_of_file(file);
+		}
+
+		// new data arrived, restart the idle timeout
+		if (file->follow->idle_timeout > 0) {
+			wheel_timer_configure(&file->follow->idle_timer,
+			                      (uint64_t)file->follow->idle_timeout * 1000000, 0);
+		}
+	}
+
+	file->length_to_read_async -= length_read;
+
+	log_debug("Read %d byte(s) from file object ("FILE_SIGNATURE_FORMAT") asynchronously, %"PRIu64" byte(s) left to read",
+	          length_read, file_expand_signature(file), file->length_to_read_async);
+
+	if (length_read == 0 || file->length_to_read_async == 0) {
+		// finished asynchronous reading either because there is nothing
+		// to read or the request amount was read
+		file_stop_async_read(file);
+	}
+
+	file_send_async_read_callback(file, API_E_SUCCESS, buffer, length_read);
+
+	if (!file->async_read_in_progress) {
+		log_debug("Finished asynchronous reading from file object ("FILE_SIGNATURE_FORMAT")",
+		          file_expand_signature(file));
+
+		return -1;
+	}
+
+	return 1;
+}
+
+static void file_handle_async_read(void *opaque) {
+	File *file = opaque;
+	int i;
+	int rc;
+
+	if (!file->async_read_in_progress) {
+		log_error("Got asynchronous read event for file object ("FILE_SIGNATURE_FORMAT") without an asynchronous read in progress",
+		          file_expand_signature(file));
+
+		event_remove_source(file->async_read_eventfd, EVENT_SOURCE_TYPE_GENERIC);
+
+		return;
+	}
+
+	if (!file->async_read_credit_mode) {
+		file_handle_async_read_chunk(file);
+
+		return;
+	}
+
+	// in credit mode send multiple callbacks per event, but not more than the
+	// client granted credit for, to avoid overrunning the client
+	for (i = 0; i < FILE_MAX_ASYNC_READ_CHUNKS_PER_EVENT && file->async_read_credit > 0; ++i) {
+		rc = file_handle_async_read_chunk(file);
+
+		if (rc < 0) {
+			return;
+		}
+
+		if (rc == 0) {
+			break; // retry on next event
+		}
+
+		--file->async_read_credit;
+	}
+
+	if (file->async_read_credit == 0) {
+		// stop polling the eventfd until the client grants more credit
+		event_remove_source(file->async_read_eventfd, EVENT_SOURCE_TYPE_GENERIC);
+
+		file->async_read_paused = true;
+
+		log_debug("Paused asynchronous reading from file object ("FILE_SIGNATURE_FORMAT"), out of credit",
+		          file_expand_signature(file));
+	}
+}
+
+// allocates the job state and starts the job. the caller initializes the
+// type specific part of the job state before returning to the event loop
+static APIE file_start_job(File *file, FileJobType type, size_t size,
+                           BackgroundJobFunction function, FileJob **job_) {
+	FileJob *job;
+
+	if (file->job != NULL) {
+		log_warn("Cannot start %s job for file object ("FILE_SIGNATURE_FORMAT") while a %s job is in progress",
+		         file_get_job_type_name(type), file_expand_signature(file),
+		         file_get_job_type_name(file->job->type));
+
+		return API_E_INVALID_OPERATION;
+	}
+
+	job = calloc(1, size);
+
+	if (job == NULL) {
+		log_error("Could not allocate %s job: %s (%d)",
+		          file_get_job_type_name(type), get_errno_name(ENOMEM), ENOMEM);
+
+		return API_E_NO_FREE_MEMORY;
+	}
+
+	job->type = type;
+	job->file = file;
+
+	background_job_create(&job->background_job, function, job);
+
+	if (background_job_start(&job->background_job) < 0) {
+		free(job);
+
+		return API_E_INTERNAL_ERROR;
+	}
+
+	file->job = job;
+	*job_ = job;
+
+	return API_E_SUCCESS;
+}
+
+static void file_stop_job(File *file) {
+	FileJob *job = file->job;
+	FileDeltaJob *delta_job;
+
+	file->job = NULL;
+
+	background_job_stop(&job->background_job);
+
+	switch (job->type) {
+	case FILE_JOB_TYPE_COPY:
+		close(((FileCopyJob *)job)->source_fd);
+
+		break;
+
+	case FILE_JOB_TYPE_DELTA:
+		delta_job = (FileDeltaJob *)job;
+
+		file_release(delta_job->delta);
+		file_release(delta_job->basis);
+
+		break;
+
+	default:
+		break;
+	}
+
+	free(job);
+}
+
+// reads one chunk per step, to avoid blocking the event loop while computing
+// the checksum of large files
+static void file_handle_checksum(void *opaque) {
+	FileChecksumJob *job = opaque;
+	File *file = job->base.file;
+	uint32_t length_to_read;
+	ssize_t length_read;
+	uint8_t checksum[CHECKSUM_MAX_LENGTH];
+	uint8_t checksum_length;
+	APIE error_code;
+
+	length_to_read = sizeof(_chunk_buffer);
+
+	if (length_to_read > job->length_left) {
+		length_to_read = job->length_left;
+	}
+
+	// use pread to leave the file position untouched
+	length_read = pread(file->fd, _chunk_buffer, length_to_read, job->offset);
+
+	if (length_read < 0) {
+		if (errno_interrupted()) {
+			return; // retry on next step
+		}
+
+		error_code = api_get_error_code_from_errno();
+
+		log_error("Could not read %u byte(s) from file object ("FILE_SIGNATURE_FORMAT") to compute checksum: %s (%d)",
+		          length_to_read, file_expand_signature(file),
+		          get_errno_name(errno), errno);
+
+		file_send_async_checksum_callback(job, error_code, NULL, 0);
+		file_stop_job(file);
+
+		return;
+	}
+
+	checksum_update(&job->checksum, _chunk_buffer, length_read);
+
+	job->offset += length_read;
+	job->length_left -= length_read;
+
+	if (length_read == 0 || job->length_left == 0) {
+		// finished either because the end of the file was reached or
+		// because the requested range was read
+		checksum_length = checksum_finish(&job->checksum, checksum);
+
+		log_debug("Finished computing %s checksum of file object ("FILE_SIGNATURE_FORMAT")",
+		          checksum_get_algorithm_name(job->checksum.algorithm),
+		          file_expand_signature(file));
+
+		file_send_async_checksum_callback(job, API_E_SUCCESS, checksum, checksum_length);
+		file_stop_job(file);
+	}
+}
+
+// errors that indicate that the current copy method cannot be used for the
+// given pair of files. no data was copied in this case
+static bool file_copy_method_is_unsupported(void) {
+	return errno == ENOSYS || errno == EINVAL || errno == EXDEV ||
+	       errno == EOPNOTSUPP || errno == EBADF;
+}
+
+// copies one chunk and returns the number of bytes copied, 0 at the end of
+// the source file or -1 on error
+static ssize_t file_copy_chunk(FileCopyJob *job) {
+	File *file = job->base.file;
+	ssize_t length_read;
+	ssize_t length_written;
+	ssize_t rc;
+
+	for (;;) {
+		switch (job->method) {
+		case FILE_COPY_METHOD_COPY_FILE_RANGE:
+#ifdef __NR_copy_file_range
+			// use the syscall directly, older glibc versions don't wrap it
+			rc = syscall(__NR_copy_file_range, job->source_fd, NULL,
+			             file->fd, NULL, FILE_COPY_CHUNK_LENGTH, 0);
+
+			if (rc >= 0 || !file_copy_method_is_unsupported()) {
+				return rc;
+			}
+#endif
+
+			log_debug("Cannot copy to file object ("FILE_SIGNATURE_FORMAT") using copy_file_range, falling back to sendfile",
+			          file_expand_signature(file));
+
+			job->method = FILE_COPY_METHOD_SENDFILE;
+
+			break;
+
+		case FILE_COPY_METHOD_SENDFILE:
+			rc = sendfile(file->fd, job->source_fd, NULL, FILE_COPY_CHUNK_LENGTH);
+
+			if (rc >= 0 || !file_copy_method_is_unsupported()) {
+				return rc;
+			}
+
+			log_debug("Cannot copy to file object ("FILE_SIGNATURE_FORMAT") using sendfile, falling back to read/write",
+			          file_expand_signature(file));
+
+			job->method = FILE_COPY_METHOD_READ_WRITE;
+
+			break;
+
+		default:
+			length_read = read(job->source_fd, _chunk_buffer, sizeof(_chunk_buffer));
+
+			if (length_read <= 0) {
+				return length_read;
+			}
+
+			for (length_written = 0; length_written < length_read; length_written += rc) {
+				rc = robust_write(file->fd, _chunk_buffer + length_written,
+				                  length_read - length_written);
+
+				if (rc < 0) {
+					return -1;
+				}
+			}
+
+			return length_read;
+		}
+	}
+}
+
+// copies one chunk per step, to avoid blocking the event loop while copying
+// large files
+static void file_handle_copy(void *opaque) {
+	FileCopyJob *job = opaque;
+	File *file = job->base.file;
+	ssize_t rc;
+	APIE error_code;
+
+	rc = file_copy_chunk(job);
+
+	if (rc < 0) {
+		if (errno_interrupted()) {
+			return; // retry on next step
+		}
+
+		error_code = api_get_error_code_from_errno();
+
+		log_error("Could not copy to file object ("FILE_SIGNATURE_FORMAT") after %"PRIu64" byte(s): %s (%d)",
+		          file_expand_signature(file), job->length,
+		          get_errno_name(errno), errno);
+
+		file_send_async_copy_callback(job, error_code);
+		file_stop_job(file);
+
+		return;
+	}
+
+	job->length += rc;
+
+	if (rc == 0) {
+		log_debug("Finished copying %"PRIu64" byte(s) to file object ("FILE_SIGNATURE_FORMAT")",
+		          job->length, file_expand_signature(file));
+
+		file_send_async_copy_callback(job, API_E_SUCCESS);
+		file_stop_job(file);
+	}
+}
+
+// reads one block per step and reports its signature, to avoid blocking the
+// event loop for large files
+static void file_handle_signatures(void *opaque) {
+	FileSignatureJob *job = opaque;
+	File *file = job->base.file;
+	ssize_t length_read;
+	APIE error_code;
+	Checksum checksum;
+	uint8_t strong_checksum[CHECKSUM_MAX_LENGTH];
+
+	length_read = pread(file->fd, _chunk_buffer, job->block_length,
+	                    (off_t)job->block_index * job->block_length);
+
+	if (length_read < 0) {
+		if (errno_interrupted()) {
+			return; // retry on next step
+		}
+
+		error_code = api_get_error_code_from_errno();
+
+		log_error("Could not read block %u from file object ("FILE_SIGNATURE_FORMAT") to compute its signature: %s (%d)",
+		          job->block_index, file_expand_signature(file),
+		          get_errno_name(errno), errno);
+
+		file_send_async_signature_callback(job, error_code, 0, 0, NULL);
+		file_stop_job(file);
+
+		return;
+	}
+
+	if (length_read == 0) {
+		log_debug("Finished computing signatures of %u block(s) of file object ("FILE_SIGNATURE_FORMAT")",
+		          job->block_index, file_expand_signature(file));
+
+		// a block length of zero marks the end of the signatures
+		file_send_async_signature_callback(job, API_E_SUCCESS, 0, 0, NULL);
+		file_stop_job(file);
+
+		return;
+	}
+
+	checksum_init(&checksum, CHECKSUM_ALGORITHM_SHA256);
+	checksum_update(&checksum, _chunk_buffer, length_read);
+	checksum_finish(&checksum, strong_checksum);
+
+	file_send_async_signature_callback(job, API_E_SUCCESS, length_read,
+	                                   checksum_get_rolling(_chunk_buffer, length_read),
+	                                   strong_checksum);
+
+	++job->block_index;
+}
+
+static uint32_t file_get_uint32_le(uint8_t *buffer) {
+	return (uint32_t)buffer[0] | (uint32_t)buffer[1] << 8 |
+	       (uint32_t)buffer[2] << 16 | (uint32_t)buffer[3] << 24;
+}
+
+// reads the next command from the delta file. returns 1 if a command was read,
+// 0 at the end of the delta file or -1 on error. sets errno on error
+static int file_read_delta_command(FileDeltaJob *job) {
+	File *file = job->base.file;
+	uint8_t buffer[9];
+	ssize_t length_read;
+	uint32_t block_index;
+	uint32_t block_count;
+
+	length_read = pread(job->delta->fd, buffer, sizeof(buffer), job->offset);
+
+	if (length_read <= 0) {
+		return length_read;
+	}
+
+	switch (buffer[0]) {
+	case FILE_DELTA_COMMAND_COPY:
+		if (length_read < 9) {
+			break;
+		}
+
+		block_index = file_get_uint32_le(buffer + 1);
+		block_count = file_get_uint32_le(buffer + 5);
+
+		job->offset += 9;
+		job->command = FILE_DELTA_COMMAND_COPY;
+		job->basis_offset = (uint64_t)block_index * job->block_length;
+		job->length_left = (uint64_t)block_count * job->block_length;
+
+		return 1;
+
+	case FILE_DELTA_COMMAND_LITERAL:
+		if (length_read < 5) {
+			break;
+		}
+
+		job->offset += 5;
+		job->command = FILE_DELTA_COMMAND_LITERAL;
+		job->length_left = file_get_uint32_le(buffer + 1);
+
+		return 1;
+
+	default:
+		log_warn("Invalid command %u at offset %"PRIu64" of delta for file object ("FILE_SIGNATURE_FORMAT")",
+		         buffer[0], job->offset, file_expand_signature(file));
+
+		errno = EINVAL;
+
+		return -1;
+	}
+
+	log_warn("Truncated command at offset %"PRIu64" of delta for file object ("FILE_SIGNATURE_FORMAT")",
+	         job->offset, file_expand_signature(file));
+
+	errno = EINVAL;
+
+	return -1;
+}
+
+// writes one chunk of the new file. returns 1 if more data is left, 0 after
+// the last command or -1 on error. sets errno on error
+static int file_apply_delta_chunk(FileDeltaJob *job) {
+	File *file = job->base.file;
+	uint32_t length;
+	ssize_t length_read;
+	ssize_t length_written;
+	ssize_t rc;
+
+	while (job->length_left == 0) {
+		rc = file_read_delta_command(job);
+
+		if (rc <= 0) {
+			return rc;
+		}
+	}
+
+	length = sizeof(_chunk_buffer);
+
+	if (length > job->length_left) {
+		length = job->length_left;
+	}
+
+	if (job->command == FILE_DELTA_COMMAND_COPY) {
+		length_read = pread(job->basis->fd, _chunk_buffer, length,
+		                    job->basis_offset);
+
+		if (length_read < 0) {
+			return -1;
+		}
+
+		// only the last block of the basis file can be shorter than the
+		// block length, any other early end is an invalid block index
+		if (length_read == 0) {
+			if (job->length_left >= job->block_length) {
+				log_warn("Copy command references data beyond the end of the basis for file object ("FILE_SIGNATURE_FORMAT")",
+				         file_expand_signature(file));
+
+				errno = EINVAL;
+
+				return -1;
+			}
+
+			job->length_left = 0;
+
+			return 1;
+		}
+
+		job->basis_offset += length_read;
+	} else {
+		length_read = pread(job->delta->fd, _chunk_buffer, length,
+		                    job->offset);
+
+		if (length_read < 0) {
+			return -1;
+		}
+
+		if (length_read == 0) {
+			log_warn("Truncated literal data at offset %"PRIu64" of delta for file object ("FILE_SIGNATURE_FORMAT")",
+			         job->offset, file_expand_signature(file));
+
+			errno = EINVAL;
+
+			return -1;
+		}
+
+		job->offset += length_read;
+	}
+
+	job->length_left -= length_read;
+
+	for (length_written = 0; length_written < length_read; length_written += rc) {
+		rc = robust_write(file->fd, _chunk_buffer + length_written,
+		                  length_read - length_written);
+
+		if (rc < 0) {
+			return -1;
+		}
+	}
+
+	job->length += length_read;
+
+	return 1;
+}
+
+// writes one chunk per step, to avoid blocking the event loop while rebuilding
+// large files
+static void file_handle_delta(void *opaque) {
+	FileDeltaJob *job = opaque;
+	File *file = job->base.file;
+	int rc;
+	APIE error_code;
+
+	rc = file_apply_delta_chunk(job);
+
+	if (rc < 0) {
+		if (errno_interrupted()) {
+			return; // retry on next step
+		}
+
+		error_code = api_get_error_code_from_errno();
+
+		log_error("Could not apply delta to file object ("FILE_SIGNATURE_FORMAT") after %"PRIu64" byte(s): %s (%d)",
+		          file_expand_signature(file), job->length,
+		          get_errno_name(errno), errno);
+
+		file_send_async_delta_callback(job, error_code);
+		file_stop_job(file);
+
+		return;
+	}
+
+	if (rc == 0) {
+		log_debug("Finished applying delta, wrote %"PRIu64" byte(s) to file object ("FILE_SIGNATURE_FORMAT")",
+		          job->length, file_expand_signature(file));
+
+		file_send_async_delta_callback(job, API_E_SUCCESS);
+		file_stop_job(file);
+	}
+}
+
+static int file_get_oflags_from_flags(uint32_t flags) {
+	int oflags = 0;
+
+	if ((flags & FILE_FLAG_READ_ONLY) != 0) {
+		oflags |= O_RDONLY;
+	}
+
+	if ((flags & FILE_FLAG_WRITE_ONLY) != 0) {
+		oflags |= O_WRONLY;
+	}
+
+	if ((flags & FILE_FLAG_READ_WRITE) != 0) {
+		oflags |= O_RDWR;
+	}
+
+	if ((flags & FILE_FLAG_APPEND) != 0) {
+		oflags |= O_APPEND;
+	}
+
+	if ((flags & FILE_FLAG_CREATE) != 0) {
+		oflags |= O_CREAT;
+	}
+
+	if ((flags & FILE_FLAG_EXCLUSIVE) != 0) {
+		oflags |= O_EXCL;
+	}
+
+	if ((flags & FILE_FLAG_NON_BLOCKING) != 0) {
+		oflags |= O_NONBLOCK;
+	}
+
+	if ((flags & FILE_FLAG_TRUNCATE) != 0) {
+		oflags |= O_TRUNC;
+	}
+
+	return oflags;
+}
+
+mode_t file_get_mode_from_permissions(uint16_t permissions) {
+	mode_t mode = 0;
+
+	if ((permissions & FILE_PERMISSION_USER_READ) != 0) {
+		mode |= S_IRUSR;
+	}
+
+	if ((permissions & FILE_PERMISSION_USER_WRITE) != 0) {
+		mode |= S_IWUSR;
+	}
+
+	if ((permissions & FILE_PERMISSION_USER_EXECUTE) != 0) {
+		mode |= S_IXUSR;
+	}
+
+	if ((permissions & FILE_PERMISSION_GROUP_READ) != 0) {
+		mode |= S_IRGRP;
+	}
+
+	if ((permissions & FILE_PERMISSION_GROUP_WRITE) != 0) {
+		mode |= S_IWGRP;
+	}
+
+	if ((permissions & FILE_PERMISSION_GROUP_EXECUTE) != 0) {
+		mode |= S_IXGRP;
+	}
+
+	if ((permissions & FILE_PERMISSION_OTHERS_READ) != 0) {
+		mode |= S_IROTH;
+	}
+
+	if ((permissions & FILE_PERMISSION_OTHERS_WRITE) != 0) {
+		mode |= S_IWOTH;
+	}
+
+	if ((permissions & FILE_PERMISSION_OTHERS_EXECUTE) != 0) {
+		mode |= S_IXOTH;
+	}
+
+	return mode;
+}
+
+// opens the file directly if redapid already has the requested identity,
+// otherwise a file broker opens it on behalf of redapid
+static APIE file_open_as(const char *name, uint32_t flags, int oflags,
+                         mode_t mode, uint32_t uid, uint32_t gid, IOHandle *fd_) {
+	APIE error_code;
+	IOHandle fd;
+
+	if (geteuid() != uid || getegid() != gid) {
+		return file_broker_open(name, flags, oflags, mode, uid, gid, fd_);
+	}
+
+	fd = open(name, oflags, mode);
+
+	if (fd < 0) {
+		error_code = api_get_error_code_from_errno();
+
+		if (errno == ENOENT) {
+			log_debug("Could not open non-existing file '%s'", name);
+		} else if ((flags & (FILE_FLAG_CREATE | FILE_FLAG_EXCLUSIVE)) ==
+		           (FILE_FLAG_CREATE | FILE_FLAG_EXCLUSIVE) && errno == EEXIST) {
+			log_debug("Could not exclusively create already existing file '%s'",
+			          name);
+		} else {
+			log_error("Could not open file '%s' with flags 0x%04X as %u:%u: %s (%d)",
+			          name, flags, uid, gid, get_errno_name(errno), errno);
+		}
+
+		return error_code;
+	}
+
+	*fd_ = fd;
+
+	return API_E_SUCCESS;
+}
+
+// public API
+APIE file_open(ObjectID name_id, uint32_t flags, uint16_t permissions,
+               uint32_t uid, uint32_t gid, Session *session,
+               uint16_t object_create_flags, ObjectID *id, File **object) {
+	int phase = 0;
+	APIE error_code;
+	int oflags = O_NOCTTY;
+	mode_t mode = 0;
+	String *name;
+	IOHandle fd;
+	IOHandle async_read_eventfd;
+	FileWriteBehind *write_behind = NULL;
+	FileCompression *compression = NULL;
+	File *file;
+	struct stat st;
+	int rc;
+
+	// check parameters
+	if ((flags & ~FILE_FLAG_ALL) != 0) {
+		error_code = API_E_INVALID_PARAMETER;
+
+		log_warn("Invalid file flags 0x%04X", flags);
+
+		goto cleanup;
+	}
+
+	if ((permissions & ~FILE_PERMISSION_ALL) != 0) {
+		error_code = API_E_INVALID_PARAMETER;
+
+		log_warn("Invalid file permissions 0o%04o", permissions);
+
+		goto cleanup;
+	}
+
+	if ((flags & FILE_FLAG_CREATE) != 0 && permissions == 0) {
+		error_code = API_E_INVALID_PARAMETER;
+
+		log_warn("FILE_FLAG_CREATE used without specifying file permissions");
+
+		goto cleanup;
+	}
+
+	if ((flags & FILE_FLAG_CREATE) == 0 && permissions != 0) {
+		error_code = API_E_INVALID_PARAMETER;
+
+		log_warn("Permissions specified without using FILE_FLAG_CREATE");
+
+		goto cleanup;
+	}
+
+	// translate flags
+	oflags |= file_get_oflags_from_flags(flags);
+
+	if ((flags & FILE_FLAG_TEMPORARY) != 0 &&
+	    ((flags & FILE_FLAG_CREATE) == 0 || (flags & FILE_FLAG_EXCLUSIVE) == 0)) {
+		error_code = API_E_INVALID_PARAMETER;
+
+		log_warn("FILE_FLAG_TEMPORARY used without using FILE_FLAG_CREATE and FILE_FLAG_EXCLUSIVE as well");
+
+		goto cleanup;
+	}
+
+	if ((flags & FILE_FLAG_REPLACE) != 0 && (flags & FILE_FLAG_CREATE) == 0) {
+		error_code = API_E_INVALID_PARAMETER;
+
+		log_warn("FILE_FLAG_REPLACE used without using FILE_FLAG_CREATE as well");
+
+		goto cleanup;
+	}
+
+	if ((flags & FILE_FLAG_WRITE_BEHIND) != 0 &&
+	    (flags & (FILE_FLAG_WRITE_ONLY | FILE_FLAG_READ_WRITE)) == 0) {
+		error_code = API_E_INVALID_PARAMETER;
+
+		log_warn("FILE_FLAG_WRITE_BEHIND used without using FILE_FLAG_WRITE_ONLY or FILE_FLAG_READ_WRITE");
+
+		goto cleanup;
+	}
+
+	if ((flags & FILE_FLAG_COMPRESSED) != 0 &&
+	    (flags & (FILE_FLAG_READ_ONLY | FILE_FLAG_WRITE_ONLY | FILE_FLAG_READ_WRITE)) != FILE_FLAG_READ_ONLY &&
+	    (flags & (FILE_FLAG_READ_ONLY | FILE_FLAG_WRITE_ONLY | FILE_FLAG_READ_WRITE)) != FILE_FLAG_WRITE_ONLY) {
+		error_code = API_E_INVALID_PARAMETER;
+
+		log_warn("FILE_FLAG_COMPRESSED used without using either FILE_FLAG_READ_ONLY or FILE_FLAG_WRITE_ONLY");
+
+		goto cleanup;
+	}
+
+	if ((flags & FILE_FLAG_COMPRESSED) != 0 && (flags & FILE_FLAG_WRITE_BEHIND) != 0) {
+		error_code = API_E_INVALID_PARAMETER;
+
+		log_warn("FILE_FLAG_COMPRESSED used in combination with FILE_FLAG_WRITE_BEHIND");
+
+		goto cleanup;
+	}
+
+	// translate create permissions
+	if ((flags & FILE_FLAG_CREATE) != 0) {
+		mode |= file_get_mode_from_permissions(permissions);
+	}
+
+	// acquire and lock name string object
+	error_code = string_get_acquired_and_locked(name_id, "file_open:name", &name);
+
+	if (error_code != API_E_SUCCESS) {
+		goto cleanup;
+	}
+
+	phase = 1;
+
+	if (*name->buffer == '\0') {
+		error_code = API_E_INVALID_PARAMETER;
+
+		log_warn("File name cannot be empty");
+
+		goto cleanup;
+	}
+
+	if (*name->buffer != '/') {
+		error_code = API_E_INVALID_PARAMETER;
+
+		log_warn("Cannot open/create file with relative name '%s'", name->buffer);
+
+		goto cleanup;
+	}
+
+	// unlink existing
+	if ((flags & FILE_FLAG_REPLACE) != 0) {
+		if (unlink(name->buffer) < 0 && errno != ENOENT) {
+			error_code = api_get_error_code_from_errno();
+
+			log_error("Could not unlink '%s' to replace it: %s (%d)",
+			          name->buffer, get_errno_name(errno), errno);
+
+			goto cleanup;
+		}
+	}
+
+	// open file
+	error_code = file_open_as(name->buffer, flags, oflags, mode, uid, gid, &fd);
+
+	if (error_code != API_E_SUCCESS) {
+		goto cleanup;
+	}
+
+	phase = 2;
+
+	if (fstat(fd, &st) < 0) {
+		error_code = api_get_error_code_from_errno();
+
+		log_error("Could not get information for file '%s': %s (%d)",
+		          name->buffer, get_errno_name(errno), errno);
+
+		goto cleanup;
+	}
+
+	if ((flags & FILE_FLAG_WRITE_BEHIND) != 0 &&
+	    file_get_type_from_stat_mode(st.st_mode) != FILE_TYPE_REGULAR) {
+		error_code = API_E_INVALID_PARAMETER;
+
+		log_warn("FILE_FLAG_WRITE_BEHIND used for non-regular file '%s'", name->buffer);
+
+		goto cleanup;
+	}
+
+	if ((flags & FILE_FLAG_COMPRESSED) != 0 &&
+	    file_get_type_from_stat_mode(st.st_mode) != FILE_TYPE_REGULAR) {
+		error_code = API_E_INVALID_PARAMETER;
+
+		log_warn("FILE_FLAG_COMPRESSED used for non-regular file '%s'", name->buffer);
+
+		goto cleanup;
+	}
+
+	// allocate file object
+	file = inventory_allocate_object(OBJECT_TYPE_FILE);
+
+	if (file == NULL) {
+		error_code = API_E_NO_FREE_MEMORY;
+
+		log_error("Could not allocate file object: %s (%d)",
+		          get_errno_name(ENOMEM), ENOMEM);
+
+		goto cleanup;
+	}
+
+	phase = 3;
+
+	// create async read eventfd
+	async_read_eventfd = eventfd(1, EFD_NONBLOCK);
+
+	if (async_read_eventfd < 0) {
+		error_code = api_get_error_code_from_errno();
+
+		log_error("Could not create asynchronous read eventfd: %s (%d)",
+		          get_errno_name(errno), errno);
+
+		goto cleanup;
+	}
+
+	phase = 4;
+
+	// allocate write-behind buffer
+	if ((flags & FILE_FLAG_WRITE_BEHIND) != 0) {
+		write_behind = calloc(1, sizeof(FileWriteBehind));
+
+		if (write_behind == NULL) {
+			error_code = API_E_NO_FREE_MEMORY;
+
+			log_error("Could not allocate write-behind buffer: %s (%d)",
+			          get_errno_name(ENOMEM), ENOMEM);
+
+			goto cleanup;
+		}
+	}
+
+	phase = 5;
+
+	// allocate and initialize compression stream
+	if ((flags & FILE_FLAG_COMPRESSED) != 0) {
+		compression = calloc(1, sizeof(FileCompression));
+
+		if (compression == NULL) {
+			error_code = API_E_NO_FREE_MEMORY;
+
+			log_error("Could not allocate compression stream: %s (%d)",
+			          get_errno_name(ENOMEM), ENOMEM);
+
+			goto cleanup;
+		}
+
+		if ((flags & FILE_FLAG_READ_ONLY) != 0) {
+			rc = deflateInit(&compression->stream, Z_DEFAULT_COMPRESSION);
+		} else {
+			rc = inflateInit(&compression->stream);
+		}
+
+		if (rc != Z_OK) {
+			error_code = rc == Z_MEM_ERROR ? API_E_NO_FREE_MEMORY : API_E_INTERNAL_ERROR;
+
+			log_error("Could not initialize compression stream: %s (%d)",
+			          compression->stream.msg != NULL ? compression->stream.msg : "<unknown>", rc);
+
+			free(compression);
+
+			goto cleanup;
+		}
+	}
+
+	phase = 6;
+
+	// create file object
+	file->type = file_get_type_from_stat_mode(st.st_mode);
+	file->name = name;
+	file->flags = flags;
+	file->events = 0;
+	file->fd = fd;
+	file->uid = uid;
+	file->gid = gid;
+	file->async_read_eventfd = async_read_eventfd;
+	file->async_read_in_progress = false;
+	file->length_to_read_async = 0;
+	file->async_read_credit_mode = false;
+	file->async_read_credit = 0;
+	file->async_read_paused = false;
+	file->follow = NULL;
+	file->compression = compression;
+	file->archive_extractor = NULL;
+	file->archive_creator = NULL;
+	file->write_behind = write_behind;
+	file->writable_event_added = false;
+	file->job = NULL;
+
+	if (write_behind != NULL) {
+		wheel_timer_create(&write_behind->timer, file_handle_write_behind_timeout, file);
+
+		file->read = file_handle_write_behind_read;
+		file->write = file_handle_write_behind_write;
+		file->seek = file_handle_write_behind_seek;
+	} else if (compression != NULL) {
+		file->read = file_handle_compressed_read;
+		file->write = file_handle_compressed_write;
+		file->seek = file_handle_compressed_seek;
+	} else {
+		file->read = file_handle_read;
+		file->write = file_handle_write;
+		file->seek = file_handle_seek;
+	}
+
+	error_code = object_create(&file->base, OBJECT_TYPE_FILE, session,
+	                           object_create_flags, file_destroy, file_signature);
+
+	if (error_code != API_E_SUCCESS) {
+		goto cleanup;
+	}
+
+	phase = 7;
+
+	if (id != NULL) {
+		*id = file->base.id;
+	}
+
+	if (object != NULL) {
+		*object = file;
+	}
+
+	if ((flags & FILE_FLAG_TEMPORARY) != 0) {
+		log_debug("Created temporary file object ("FILE_SIGNATURE_FORMAT", permissions: 0o%04o, uid: %u, gid: %u, handle: %d)",
+		          file_expand_signature(file), permissions, uid, gid, fd);
+	} else if ((flags & FILE_FLAG_CREATE) != 0) {
+		log_debug("Opened/Created file object ("FILE_SIGNATURE_FORMAT", permissions: 0o%04o, uid: %u, gid: %u, handle: %d)",
+		          file_expand_signature(file), permissions, uid, gid, fd);
+	} else {
+		log_debug("Opened file object ("FILE_SIGNATURE_FORMAT", uid: %u, gid: %u, handle: %d)",
+		          file_expand_signature(file), uid, gid, fd);
+	}
+
+cleanup:
+	switch (phase) { // no breaks, all cases fall through intentionally
+	case 6:
+		if (compression != NULL) {
+			if ((flags & FILE_FLAG_READ_ONLY) != 0) {
+				deflateEnd(&compression->stream);
+			} else {
+				inflateEnd(&compression->stream);
+			}
+
+			free(compression);
+		}
+		// fall through
+
+	case 5:
+		free(write_behind);
+		// fall through
+
+	case 4:
+		close(async_read_eventfd);
+		// fall through
+
+	case 3:
+		inventory_free_object(OBJECT_TYPE_FILE, file);
+		// fall through
+
+	case 2:
+		close(fd);
+		// fall through
+
+	case 1:
+		string_unlock_and_release(name);
+		// fall through
+
+	default:
+		break;
+	}
+
+	return phase == 7 ? API_E_SUCCESS : error_code;
+}
+
+// public API
+APIE file_copy(ObjectID source_name_id, ObjectID target_name_id, uint32_t flags,
+               uint16_t permissions, uint32_t uid, uint32_t gid,
+               Session *session, ObjectID *id) {
+	int phase = 0;
+	APIE error_code;
+	String *source_name;
+	IOHandle source_fd;
+	struct stat st;
+	File *file;
+	FileJob *job;
+	FileCopyJob *copy_job;
+
+	// check parameters
+	if ((flags & (FILE_FLAG_WRITE_ONLY | FILE_FLAG_READ_WRITE)) == 0) {
+		error_code = API_E_INVALID_PARAMETER;
+
+		log_warn("Cannot copy to file without using FILE_FLAG_WRITE_ONLY or FILE_FLAG_READ_WRITE");
+
+		goto cleanup;
+	}
+
+	if ((flags & (FILE_FLAG_WRITE_BEHIND | FILE_FLAG_COMPRESSED)) != 0) {
+		error_code = API_E_INVALID_PARAMETER;
+
+		log_warn("FILE_FLAG_WRITE_BEHIND and FILE_FLAG_COMPRESSED cannot be used to copy a file");
+
+		goto cleanup;
+	}
+
+	// acquire and lock source name string object
+	error_code = string_get_acquired_and_locked(source_name_id, "file_copy:source_name",
+	                                            &source_name);
+
+	if (error_code != API_E_SUCCESS) {
+		goto cleanup;
+	}
+
+	phase = 1;
+
+	if (*source_name->buffer != '/') {
+		error_code = API_E_INVALID_PARAMETER;
+
+		log_warn("Cannot copy file with relative or empty name '%s'", source_name->buffer);
+
+		goto cleanup;
+	}
+
+	// open source file with the same identity as the target file
+	error_code = file_open_as(source_name->buffer, FILE_FLAG_READ_ONLY,
+	                          O_RDONLY | O_NOCTTY, 0, uid, gid, &source_fd);
+
+	if (error_code != API_E_SUCCESS) {
+		goto cleanup;
+	}
+
+	phase = 2;
+
+	if (fstat(source_fd, &st) < 0) {
+		error_code = api_get_error_code_from_errno();
+
+		log_error("Could not get information for file '%s': %s (%d)",
+		          source_name->buffer, get_errno_name(errno), errno);
+
+		goto cleanup;
+	}
+
+	if (S_ISDIR(st.st_mode)) {
+		error_code = API_E_IS_DIRECTORY;
+
+		log_warn("Cannot copy directory '%s'", source_name->buffer);
+
+		goto cleanup;
+	}
+
+	// open target file the same way open_file does, the returned file object
+	// reports the end of the copy by an async-file-copied callback
+	error_code = file_open(target_name_id, flags, permissions, uid, gid, session,
+	                       OBJECT_CREATE_FLAG_EXTERNAL, id, &file);
+
+	if (error_code != API_E_SUCCESS) {
+		goto cleanup;
+	}
+
+	phase = 3;
+
+	// copying the whole file here could block the event loop too long. copy
+	// it chunk by chunk in a background job instead
+	error_code = file_start_job(file, FILE_JOB_TYPE_COPY, sizeof(FileCopyJob),
+	                            file_handle_copy, &job);
+
+	if (error_code != API_E_SUCCESS) {
+		goto cleanup;
+	}
+
+	copy_job = (FileCopyJob *)job;
+
+	copy_job->source_fd = source_fd; // closed by file_stop_job
+	copy_job->method = FILE_COPY_METHOD_COPY_FILE_RANGE;
+	copy_job->length = 0;
+
+	log_debug("Started copying file '%s' to file object ("FILE_SIGNATURE_FORMAT")",
+	          source_name->buffer, file_expand_signature(file));
+
+	// the source name is not needed anymore, the source file is open now
+	string_unlock_and_release(source_name);
+
+	phase = 4;
+
+cleanup:
+	switch (phase) { // no breaks, all cases fall through intentionally
+	case 3:
+		object_remove_external_reference(&file->base, session); // destroys the file object
+		// fall through
+
+	case 2:
+		close(source_fd);
+		// fall through
+
+	case 1:
+		string_unlock_and_release(source_name);
+		// fall through
+
+	default:
+		break;
+	}
+
+	return phase == 4 ? API_E_SUCCESS : error_code;
+}
+
+// public API
+APIE pipe_create_(uint32_t flags, uint64_t length, Session *session,
+                  uint16_t object_create_flags, ObjectID *id, File **object) {
+	int phase = 0;
+	APIE error_code;
+	String *name;
+	IOHandle async_read_eventfd;
+	File *file;
+
+	// check parameters
+	if ((flags & ~PIPE_FLAG_ALL) != 0) {
+		error_code = API_E_INVALID_PARAMETER;
+
+		log_warn("Invalid pipe flags 0x%04X", flags);
+
+		goto cleanup;
+	}
+
+	if (length > INT32_MAX) {
+		log_warn("Length of %"PRIu64" bytes exceeds maximum pipe buffer length", length);
+
+		return API_E_OUT_OF_RANGE;
+	}
+
+	// get '<unnamed>' stock string object
+	error_code = inventory_get_stock_string("<unnamed>", &name);
+
+	if (error_code != API_E_SUCCESS) {
+		goto cleanup;
+	}
+
+	phase = 1;
+
+	// allocate file object
+	file = inventory_allocate_object(OBJECT_TYPE_FILE);
+
+	if (file == NULL) {
+		error_code = API_E_NO_FREE_MEMORY;
 
 		log_error("Could not allocate file object: %s (%d)",
 		          get_errno_name(ENOMEM), ENOMEM);
 
-		goto cleanup;
+		goto cleanup;
+	}
+
+	phase = 2;
+
+	// create pipe
+	if (pipe_create(&file->pipe, flags) < 0) {
+		error_code = api_get_error_code_from_errno();
+
+		log_error("Could not create pipe: %s (%d)",
+		          get_errno_name(errno), errno);
+
+		goto cleanup;
+	}
+
+	phase = 3;
+
+	if (length > 0 && fcntl(file->pipe.base.read_handle, F_SETPIPE_SZ, (int)length) < 0) {
+		error_code = api_get_error_code_from_errno();
+
+		log_error("Could not change pipe buffer size to %"PRIu64": %s (%d)",
+		          length, get_errno_name(errno), errno);
+
+		goto cleanup;
+	}
+
+	// create async read eventfd
+	async_read_eventfd = eventfd(1, EFD_NONBLOCK);
+
+	if (async_read_eventfd < 0) {
+		error_code = api_get_error_code_from_errno();
+
+		log_error("Could not create asynchronous read eventfd: %s (%d)",
+		          get_errno_name(errno), errno);
+
+		goto cleanup;
+	}
+
+	phase = 4;
+
+	// create async write queue
+	if (queue_create(&file->async_write_queue, sizeof(FileAsyncWrite)) < 0) {
+		error_code = api_get_error_code_from_errno();
+
+		log_error("Could not create asynchronous write queue: %s (%d)",
+		          get_errno_name(errno), errno);
+
+		goto cleanup;
+	}
+
+	phase = 5;
+
+	// create file object
+	file->type = FILE_TYPE_PIPE;
+	file->name = name;
+	file->flags = flags;
+	file->events = 0;
+	file->fd = -1;
+	file->uid = 0;
+	file->gid = 0;
+	file->async_read_eventfd = async_read_eventfd;
+	file->async_read_in_progress = false;
+	file->length_to_read_async = 0;
+	file->async_read_credit_mode = false;
+	file->async_read_credit = 0;
+	file->async_read_paused = false;
+	file->follow = NULL;
+	file->compression = NULL;
+	file->archive_extractor = NULL;
+	file->archive_creator = NULL;
+	file->write_behind = NULL;
+	file->writable_event_added = false;
+	file->job = NULL;
+
+	file->read = pipe_handle_read;
+	file->write = pipe_handle_write;
+	file->seek = pipe_handle_seek;
+
+	error_code = object_create(&file->base, OBJECT_TYPE_FILE, session,
+	                           object_create_flags, file_destroy, file_signature);
+
+	if (error_code != API_E_SUCCESS) {
+		goto cleanup;
+	}
+
+	phase = 6;
+
+	if (id != NULL) {
+		*id = file->base.id;
+	}
+
+	if (object != NULL) {
+		*object = file;
+	}
+
+	log_debug("Created file object ("FILE_SIGNATURE_FORMAT")",
+	          file_expand_signature(file));
+
+cleanup:
+	switch (phase) { // no breaks, all cases fall through intentionally
+	case 5:
+		queue_destroy(&file->async_write_queue, NULL);
+		// fall through
+
+	case 4:
+		close(async_read_eventfd);
+		// fall through
+
+	case 3:
+		pipe_destroy(&file->pipe);
+		// fall through
+
+	case 2:
+		inventory_free_object(OBJECT_TYPE_FILE, file);
+		// fall through
+
+	case 1:
+		string_unlock_and_release(name);
+		// fall through
+
+	default:
+		break;
+	}
+
+	return phase == 6 ? API_E_SUCCESS : error_code;
+}
+
+// public API
+APIE file_create_archive(ObjectID root_directory_name_id, uint32_t flags,
+                         Session *session, ObjectID *id) {
+	int phase = 0;
+	APIE error_code;
+	String *root_directory;
+	ArchiveCreator *creator;
+	File *file;
+
+	// acquire and lock root directory name string object
+	error_code = string_get_acquired_and_locked(root_directory_name_id,
+	                                            "file_create_archive:root_directory",
+	                                            &root_directory);
+
+	if (error_code != API_E_SUCCESS) {
+		goto cleanup;
+	}
+
+	phase = 1;
+
+	if (*root_directory->buffer != '/') {
+		error_code = API_E_INVALID_PARAMETER;
+
+		log_warn("Cannot create archive of relative or empty directory name '%s'",
+		         root_directory->buffer);
+
+		goto cleanup;
+	}
+
+	error_code = archive_creator_create(root_directory->buffer, flags, &creator);
+
+	if (error_code != API_E_SUCCESS) {
+		goto cleanup;
+	}
+
+	phase = 2;
+
+	// the client reads the archive from a pipe object as from any other pipe,
+	// but the reads are served by the creator instead of the pipe. the
+	// archive is produced while it is read, so reading ends at its end
+	error_code = pipe_create_(PIPE_FLAG_NON_BLOCKING_READ | PIPE_FLAG_NON_BLOCKING_WRITE,
+	                          0, session, OBJECT_CREATE_FLAG_EXTERNAL, id, &file);
+
+	if (error_code != API_E_SUCCESS) {
+		goto cleanup;
+	}
+
+	file->archive_creator = creator;
+	file->read = pipe_handle_archive_read;
+	file->write = pipe_handle_archive_read_only_write;
+
+	log_debug("Creating archive of '%s' read from file object ("FILE_SIGNATURE_FORMAT")",
+	          root_directory->buffer, file_expand_signature(file));
+
+	string_unlock_and_release(root_directory);
+
+	phase = 3;
+
+cleanup:
+	switch (phase) { // no breaks, all cases fall through intentionally
+	case 2:
+		archive_creator_destroy(creator);
+		// fall through
+
+	case 1:
+		string_unlock_and_release(root_directory);
+		// fall through
+
+	default:
+		break;
+	}
+
+	return phase == 3 ? API_E_SUCCESS : error_code;
+}
+
+// public API
+APIE file_extract_archive(ObjectID root_directory_name_id, uint32_t uid,
+                          uint32_t gid, Session *session, ObjectID *id) {
+	int phase = 0;
+	APIE error_code;
+	String *root_directory;
+	ArchiveExtractor *extractor;
+	File *file;
+
+	// acquire and lock root directory name string object
+	error_code = string_get_acquired_and_locked(root_directory_name_id,
+	                                            "file_extract_archive:root_directory",
+	                                            &root_directory);
+
+	if (error_code != API_E_SUCCESS) {
+		goto cleanup;
+	}
+
+	phase = 1;
+
+	if (*root_directory->buffer != '/') {
+		error_code = API_E_INVALID_PARAMETER;
+
+		log_warn("Cannot extract archive to relative or empty directory name '%s'",
+		         root_directory->buffer);
+
+		goto cleanup;
+	}
+
+	// create extractor, this also creates the root directory if necessary
+	error_code = archive_extractor_create(root_directory->buffer, uid, gid, &extractor);
+
+	if (error_code != API_E_SUCCESS) {
+		goto cleanup;
+	}
+
+	phase = 2;
+
+	// the client writes the archive to a pipe object as to any other pipe,
+	// but the writes are handed to the extractor instead of the pipe
+	error_code = pipe_create_(PIPE_FLAG_NON_BLOCKING_READ | PIPE_FLAG_NON_BLOCKING_WRITE,
+	                          0, session, OBJECT_CREATE_FLAG_EXTERNAL, id, &file);
+
+	if (error_code != API_E_SUCCESS) {
+		goto cleanup;
+	}
+
+	file->archive_extractor = extractor;
+	file->write = pipe_handle_archive_write;
+
+	log_debug("Extracting archive written to file object ("FILE_SIGNATURE_FORMAT") to '%s' as %u:%u",
+	          file_expand_signature(file), root_directory->buffer, uid, gid);
+
+	// the extractor keeps its own copy of the root directory name
+	string_unlock_and_release(root_directory);
+
+	phase = 3;
+
+cleanup:
+	switch (phase) { // no breaks, all cases fall through intentionally
+	case 2:
+		archive_extractor_destroy(extractor);
+		// fall through
+
+	case 1:
+		string_unlock_and_release(root_directory);
+		// fall through
+
+	default:
+		break;
+	}
+
+	return phase == 3 ? API_E_SUCCESS : error_code;
+}
+
+// public API
+APIE file_get_info(File *file, Session *session, uint8_t *type,
+                   ObjectID *name_id, uint32_t *flags,
+                   uint16_t *permissions, uint32_t *uid, uint32_t *gid,
+                   uint64_t *length, uint64_t *access_timestamp,
+                   uint64_t *modification_timestamp,
+                   uint64_t *status_change_timestamp) {
+	APIE error_code;
+	struct stat st;
+	int rc;
+	FileType current_type;
+
+	*type = file->type;
+
+	if (file->type == FILE_TYPE_PIPE) {
+		*name_id = OBJECT_ID_ZERO;
+	} else {
+		error_code = object_add_external_reference(&file->name->base, session);
+
+		if (error_code != API_E_SUCCESS) {
+			return error_code;
+		}
+
+		*name_id = file->name->base.id;
+	}
+
+	*flags = file->flags;
+
+	if (file->type == FILE_TYPE_PIPE) {
+		rc = fcntl(file->pipe.base.read_handle, F_GETPIPE_SZ);
+
+		if (rc < 0) {
+			error_code = api_get_error_code_from_errno();
+
+			log_error("Could not get pipe buffer length for file object ("FILE_SIGNATURE_FORMAT"): %s (%d)",
+			          file_expand_signature(file), get_errno_name(errno), errno);
+
+			return error_code;
+		}
+
+		*permissions = 0;
+		*uid = 0;
+		*gid = 0;
+		*length = rc;
+		*access_timestamp = 0;
+		*modification_timestamp = 0;
+		*status_change_timestamp = 0;
+	} else {
+		// make the length include buffered data
+		file_write_behind_flush_all(file);
+
+		rc = fstat(file->fd, &st);
+
+		if (rc < 0) {
+			error_code = api_get_error_code_from_errno();
+
+			log_error("Could not get information for file object ("FILE_SIGNATURE_FORMAT"): %s (%d)",
+			          file_expand_signature(file), get_errno_name(errno), errno);
+
+			return error_code;
+		}
+
+		current_type = file_get_type_from_stat_mode(st.st_mode);
+
+		if (current_type != file->type) {
+			log_error("Current type (%s) of file object ("FILE_SIGNATURE_FORMAT") differs from cached type",
+			          file_get_type_name(current_type), file_expand_signature(file));
+
+			return API_E_INTERNAL_ERROR;
+		}
+
+		*permissions = file_get_permissions_from_stat_mode(st.st_mode);
+		*uid = st.st_uid;
+		*gid = st.st_gid;
+		*length = st.st_size;
+		*access_timestamp = st.st_atime;
+		*modification_timestamp = st.st_mtime;
+		*status_change_timestamp = st.st_ctime;
+	}
+
+	return API_E_SUCCESS;
+}
+
+// public API
+APIE file_read_(File *file, uint8_t *buffer, uint8_t length_to_read,
+                uint8_t *length_read) {
+	int rc;
+	APIE error_code;
+
+	if (length_to_read > FILE_MAX_READ_BUFFER_LENGTH) {
+		log_warn("Length of %u byte(s) exceeds maximum length of file read buffer",
+		         length_to_read);
+
+		return API_E_OUT_OF_RANGE;
+	}
+
+	if (file->async_read_in_progress) {
+		log_warn("Cannot read %u byte(s) synchronously while reading %"PRIu64" byte(s) from file object ("FILE_SIGNATURE_FORMAT") asynchronously",
+		         length_to_read, file->length_to_read_async, file_expand_signature(file));
+
+		return API_E_INVALID_OPERATION;
+	}
+
+	rc = file->read(file, buffer, length_to_read); // FIXME: handle EINTR
+
+	if (rc < 0) {
+		if (errno_would_block()) {
+			// don't report an error, just return an empty buffer if there is
+			// nothing to read at this time
+			rc = 0;
+		} else {
+			error_code = api_get_error_code_from_errno();
+
+			log_error("Could not read %u byte(s) from file object ("FILE_SIGNATURE_FORMAT"): %s (%d)",
+			          length_to_read, file_expand_signature(file),
+			          get_errno_name(errno), errno);
+
+			return error_code;
+		}
+	}
+
+	*length_read = rc;
+
+	return API_E_SUCCESS;
+}
+
+static PacketE file_start_async_read(File *file, uint64_t length_to_read,
+                                     bool credit_mode, uint16_t credit) {
+	if (length_to_read > INT64_MAX) {
+		log_warn("Length of %"PRIu64" byte(s) exceeds maximum length of file",
+		         length_to_read);
+
+		// FIXME: this callback should be delivered after the response of this function
+		file_send_async_read_callback(file, API_E_OUT_OF_RANGE, NULL, 0);
+
+		return PACKET_E_INVALID_PARAMETER;
+	}
+
+	if (file->async_read_in_progress) {
+		log_warn("Still reading %"PRIu64" byte(s) from file object ("FILE_SIGNATURE_FORMAT") asynchronously",
+		         file->length_to_read_async, file_expand_signature(file));
+
+		// FIXME: this callback should be delivered after the response of this function
+		file_send_async_read_callback(file, API_E_INVALID_OPERATION, NULL, 0);
+
+		return PACKET_E_UNKNOWN_ERROR;
+	}
+
+	file->async_read_in_progress = true;
+	file->length_to_read_async = length_to_read;
+	file->async_read_credit_mode = credit_mode;
+	file->async_read_credit = credit;
+	file->async_read_paused = credit_mode && credit == 0;
+
+	// reading the whole file and generating the callbacks here could block the
+	// event loop too long. instead poll a readable eventfd for readability.
+	// when done reading asynchronously then remove the eventfd from the event
+	// loop again
+	if (!file->async_read_paused &&
+	    event_add_source(file->async_read_eventfd, EVENT_SOURCE_TYPE_GENERIC,
+	                     "file-async-read", EVENT_READ, file_handle_async_read, file) < 0) {
+		file->async_read_paused = true; // eventfd is not in the event loop
+
+		file_stop_async_read(file);
+
+		// FIXME: this callback should be delivered after the response of this function
+		file_send_async_read_callback(file, API_E_INTERNAL_ERROR, NULL, 0);
+
+		return PACKET_E_UNKNOWN_ERROR;
+	}
+
+	log_debug("Started reading of %"PRIu64" byte(s) from file object ("FILE_SIGNATURE_FORMAT") asynchronously",
+	          length_to_read, file_expand_signature(file));
+
+	return PACKET_E_SUCCESS;
+}
+
+// public API
+PacketE file_read_async(File *file, uint64_t length_to_read) {
+	return file_start_async_read(file, length_to_read, false, 0);
+}
+
+// public API
+PacketE file_read_async_with_credit(File *file, uint64_t length_to_read, uint16_t credit) {
+	return file_start_async_read(file, length_to_read, true, credit);
+}
+
+/*
+ * following a file works like tail -F. it is an asynchronous read in credit
+ * mode that doesn't end at end-of-file. instead the eventfd is removed from
+ * the event loop until inotify reports that the file was modified. the parent
+ * directory is watched as well to detect a new file with the same name, as
+ * created by log rotation. the old file is read to its end before the new one
+ * is opened. following ends if no new data arrived for idle_timeout seconds
+ * or if the asynchronous read is aborted
+ */
+
+// public API
+PacketE file_follow_async(File *file, uint16_t credit, uint32_t idle_timeout) {
+	PacketE error_code;
+	APIE api_error_code;
+	FileFollow *follow;
+	char *directory;
+
+	if (file->type != FILE_TYPE_REGULAR ||
+	    (file->flags & (FILE_FLAG_READ_ONLY | FILE_FLAG_READ_WRITE)) == 0 ||
+	    (file->flags & FILE_FLAG_COMPRESSED) != 0) {
+		log_warn("Cannot follow file object ("FILE_SIGNATURE_FORMAT"), it has to be a readable regular file opened without FILE_FLAG_COMPRESSED",
+		         file_expand_signature(file));
+
+		// FIXME: this callback should be delivered after the response of this function
+		file_send_async_read_callback(file, API_E_INVALID_OPERATION, NULL, 0);
+
+		return PACKET_E_UNKNOWN_ERROR;
+	}
+
+	error_code = file_start_async_read(file, INT64_MAX, true, credit);
+
+	if (error_code != PACKET_E_SUCCESS) {
+		return error_code;
+	}
+
+	follow = calloc(1, sizeof(FileFollow));
+
+	if (follow == NULL) {
+		api_error_code = API_E_NO_FREE_MEMORY;
+
+		log_error("Could not allocate follow state: %s (%d)",
+		          get_errno_name(ENOMEM), ENOMEM);
+
+		goto error;
 	}
 
-	phase = 3;
+	follow->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
 
-	// create async read eventfd
-	async_read_eventfd = eventfd(1, EFD_NONBLOCK);
+	if (follow->inotify_fd < 0) {
+		api_error_code = api_get_error_code_from_errno();
+
+		log_error("Could not create inotify handle to follow file object ("FILE_SIGNATURE_FORMAT"): %s (%d)",
+		          file_expand_signature(file), get_errno_name(errno), errno);
+
+		goto error_follow;
+	}
+
+	follow->file_watch = inotify_add_watch(follow->inotify_fd, file->name->buffer,
+	                                       IN_MODIFY);
+
+	if (follow->file_watch < 0) {
+		api_error_code = api_get_error_code_from_errno();
+
+		log_error("Could not watch file object ("FILE_SIGNATURE_FORMAT"): %s (%d)",
+		          file_expand_signature(file), get_errno_name(errno), errno);
+
+		goto error_inotify;
+	}
+
+	// the name is absolute, so there always is a last slash
+	directory = strdup(file->name->buffer);
+
+	if (directory == NULL) {
+		api_error_code = API_E_NO_FREE_MEMORY;
+
+		log_error("Could not duplicate file name: %s (%d)",
+		          get_errno_name(ENOMEM), ENOMEM);
+
+		goto error_inotify;
+	}
+
+	if (strrchr(directory, '/') == directory) {
+		directory[1] = '\0';
+	} else {
+		*strrchr(directory, '/') = '\0';
+	}
+
+	follow->directory_watch = inotify_add_watch(follow->inotify_fd, directory,
+	                                            IN_CREATE | IN_MOVED_TO);
+
+	if (follow->directory_watch < 0) {
+		api_error_code = api_get_error_code_from_errno();
+
+		log_error("Could not watch directory '%s' of file object ("FILE_SIGNATURE_FORMAT"): %s (%d)",
+		          directory, file_expand_signature(file), get_errno_name(errno), errno);
+
+		free(directory);
+
+		goto error_inotify;
+	}
+
+	free(directory);
+
+	if (event_add_source(follow->inotify_fd, EVENT_SOURCE_TYPE_GENERIC,
+	                     "file-follow", EVENT_READ, file_handle_follow_event, file) < 0) {
+		api_error_code = API_E_INTERNAL_ERROR;
+
+		goto error_inotify;
+	}
+
+	wheel_timer_create(&follow->idle_timer, file_handle_follow_idle_timeout, file);
+
+	follow->waiting = false;
+	follow->rotated = false;
+	follow->idle_timeout = idle_timeout;
+
+	file->follow = follow;
+
+	if (idle_timeout > 0 &&
+	    wheel_timer_configure(&follow->idle_timer, (uint64_t)idle_timeout * 1000000, 0) < 0) {
+		api_error_code = API_E_INTERNAL_ERROR;
+
+		file_stop_async_read(file); // also stops following
+
+		goto error_callback;
+	}
+
+	log_debug("Started following file object ("FILE_SIGNATURE_FORMAT") with %u credit(s) and %u second(s) idle timeout",
+	          file_expand_signature(file), credit, idle_timeout);
+
+	return PACKET_E_SUCCESS;
+
+error_inotify:
+	close(follow->inotify_fd);
+
+error_follow:
+	free(follow);
+
+error:
+	file_stop_async_read(file);
+
+error_callback:
+	// FIXME: this callback should be delivered after the response of this function
+	file_send_async_read_callback(file, api_error_code, NULL, 0);
+
+	return PACKET_E_UNKNOWN_ERROR;
+}
+
+// public API
+APIE file_grant_async_read_credit(File *file, uint16_t credit) {
+	if (!file->async_read_in_progress) {
+		// the asynchronous read might have finished while the credit was
+		// granted, this is not an error
+		log_debug("Ignoring %u credit(s) for file object ("FILE_SIGNATURE_FORMAT") without an asynchronous read in progress",
+		          credit, file_expand_signature(file));
+
+		return API_E_SUCCESS;
+	}
+
+	if (!file->async_read_credit_mode) {
+		log_warn("Cannot grant %u credit(s) to asynchronous read without credit from file object ("FILE_SIGNATURE_FORMAT")",
+		         credit, file_expand_signature(file));
+
+		return API_E_INVALID_OPERATION;
+	}
+
+	file->async_read_credit += credit;
+
+	if (file->async_read_credit > FILE_MAX_ASYNC_READ_CREDIT) {
+		file->async_read_credit = FILE_MAX_ASYNC_READ_CREDIT;
+	}
+
+	if (file->async_read_paused && file->async_read_credit > 0) {
+		if (event_add_source(file->async_read_eventfd, EVENT_SOURCE_TYPE_GENERIC,
+		                     "file-async-read", EVENT_READ, file_handle_async_read, file) < 0) {
+			file_stop_async_read(file);
+
+			// FIXME: this callback should be delivered after the response of this function
+			file_send_async_read_callback(file, API_E_INTERNAL_ERROR, NULL, 0);
+
+			return API_E_INTERNAL_ERROR;
+		}
+
+		file->async_read_paused = false;
+
+		log_debug("Resumed asynchronous reading from file object ("FILE_SIGNATURE_FORMAT") with %u credit(s)",
+		          file_expand_signature(file), file->async_read_credit);
+	}
+
+	return API_E_SUCCESS;
+}
+
+// public API
+APIE file_abort_async_read(File *file) {
+	if (file->async_read_in_progress) {
+		file_stop_async_read(file);
+
+		// FIXME: this callback should be delivered after the response of this function
+		file_send_async_read_callback(file, API_E_OPERATION_ABORTED, NULL, 0);
+	}
+
+	return API_E_SUCCESS;
+}
+
+// public API
+APIE file_write_(File *file, uint8_t *buffer, uint8_t length_to_write,
+                 uint8_t *length_written) {
+	int rc;
+	APIE error_code;
+
+	if (length_to_write > FILE_MAX_WRITE_BUFFER_LENGTH) {
+		log_warn("Length of %u byte(s) exceeds maximum length of file write buffer",
+		         length_to_write);
+
+		return API_E_OUT_OF_RANGE;
+	}
+
+	if (file->async_read_in_progress) {
+		log_warn("Cannot write %u byte(s) while reading %"PRIu64" byte(s) from file object ("FILE_SIGNATURE_FORMAT") asynchronously",
+		         length_to_write, file->length_to_read_async, file_expand_signature(file));
+
+		return API_E_INVALID_OPERATION;
+	}
+
+	if (file->type == FILE_TYPE_PIPE && file->async_write_queue.count > 0) {
+		log_debug("Cannot write %u byte(s) to file object ("FILE_SIGNATURE_FORMAT") while asynchronous writes are queued",
+		          length_to_write, file_expand_signature(file));
+
+		return API_E_WOULD_BLOCK;
+	}
+
+	rc = file->write(file, buffer, length_to_write); // FIXME: handle EINTR
+
+	if (rc < 0) {
+		error_code = api_get_error_code_from_errno();
+
+		if (errno_would_block()) {
+			log_debug("Writing %u byte(s) to file object ("FILE_SIGNATURE_FORMAT") would block",
+			          length_to_write, file_expand_signature(file));
+		} else {
+			log_error("Could not write %u byte(s) to file object ("FILE_SIGNATURE_FORMAT"): %s (%d)",
+			          length_to_write, file_expand_signature(file),
+			          get_errno_name(errno), errno);
+		}
+
+		return error_code;
+	}
+
+	*length_written = rc;
+
+	return API_E_SUCCESS;
+}
+
+// public API
+PacketE file_write_unchecked(File *file, uint8_t *buffer, uint8_t length_to_write) {
+	if (length_to_write > FILE_MAX_WRITE_UNCHECKED_BUFFER_LENGTH) {
+		log_warn("Length of %u byte(s) exceeds maximum length of file unchecked write buffer",
+		         length_to_write);
+
+		return PACKET_E_INVALID_PARAMETER;
+	}
+
+	if (file->async_read_in_progress) {
+		log_warn("Cannot write %u byte(s) unchecked while reading %"PRIu64" byte(s) from file object ("FILE_SIGNATURE_FORMAT") asynchronously",
+		         length_to_write, file->length_to_read_async, file_expand_signature(file));
+
+		return PACKET_E_UNKNOWN_ERROR;
+	}
+
+	if (file->type == FILE_TYPE_PIPE && file->async_write_queue.count > 0) {
+		log_debug("Cannot write %u byte(s) unchecked to file object ("FILE_SIGNATURE_FORMAT") while asynchronous writes are queued",
+		          length_to_write, file_expand_signature(file));
+
+		return PACKET_E_UNKNOWN_ERROR;
+	}
+
+	if (file->write(file, buffer, length_to_write) < 0) { // FIXME: handle EINTR
+		if (errno_would_block()) {
+			log_debug("Writing %u byte(s) unchecked to file object ("FILE_SIGNATURE_FORMAT") would block",
+			          length_to_write, file_expand_signature(file));
+		} else {
+			log_error("Could not write %u byte(s) to file object ("FILE_SIGNATURE_FORMAT") unchecked: %s (%d)",
+			          length_to_write, file_expand_signature(file),
+			          get_errno_name(errno), errno);
+		}
+
+		return PACKET_E_UNKNOWN_ERROR;
+	}
+
+	return PACKET_E_SUCCESS;
+}
+
+// public API
+PacketE file_write_async(File *file, uint8_t *buffer, uint8_t length_to_write) {
+	int length_written;
+	APIE error_code;
+	FileAsyncWrite *async_write;
+
+	if (length_to_write > FILE_MAX_WRITE_ASYNC_BUFFER_LENGTH) {
+		log_warn("Length of %u byte(s) exceeds maximum length of file async write buffer",
+		         length_to_write);
+
+		// FIXME: this callback should be delivered after the response of this function
+		file_send_async_write_callback(file, API_E_OUT_OF_RANGE, 0);
+
+		return PACKET_E_INVALID_PARAMETER;
+	}
+
+	if (file->async_read_in_progress) {
+		log_warn("Cannot write %u byte(s) asynchronously while reading %"PRIu64" byte(s) from file object ("FILE_SIGNATURE_FORMAT") asynchronously",
+		         length_to_write, file->length_to_read_async, file_expand_signature(file));
+
+		// FIXME: this callback should be delivered after the response of this function
+		file_send_async_write_callback(file, API_E_INVALID_OPERATION, 0);
+
+		return PACKET_E_UNKNOWN_ERROR;
+	}
+
+	if (file->type == FILE_TYPE_PIPE && file->async_write_queue.count > 0) {
+		length_written = 0; // keep order, queue behind the other writes
+	} else {
+		length_written = file->write(file, buffer, length_to_write); // FIXME: handle EINTR
+
+		if (length_written < 0) {
+			// a pipe that would block gets the write queued below
+			if (file->type == FILE_TYPE_PIPE && errno_would_block()) {
+				length_written = 0;
+			} else {
+				error_code = api_get_error_code_from_errno();
+
+				if (errno_would_block()) {
+					log_debug("Writing %u byte(s) asynchronously to file object ("FILE_SIGNATURE_FORMAT") would block",
+					          length_to_write, file_expand_signature(file));
+				} else {
+					log_error("Could not write %u byte(s) to file object ("FILE_SIGNATURE_FORMAT") asynchronously: %s (%d)",
+					          length_to_write, file_expand_signature(file),
+					          get_errno_name(errno), errno);
+				}
+
+				// FIXME: this callback should be delivered after the response of this function
+				file_send_async_write_callback(file, error_code, 0);
+
+				return PACKET_E_UNKNOWN_ERROR;
+			}
+		}
+	}
+
+	if (file->type != FILE_TYPE_PIPE || length_written == length_to_write) {
+		// FIXME: this callback should be delivered after the response of this function
+		file_send_async_write_callback(file, API_E_SUCCESS, length_written);
+
+		return PACKET_E_SUCCESS;
+	}
+
+	// queue the rest of the write. it gets written as soon as the pipe is
+	// writable again and its callback is sent once it is completely written
+	if (file->async_write_queue.count >= FILE_MAX_ASYNC_WRITE_QUEUE_LENGTH) {
+		log_debug("Writing %u byte(s) asynchronously to file object ("FILE_SIGNATURE_FORMAT") would block, queue is full",
+		          length_to_write, file_expand_signature(file));
+
+		// FIXME: this callback should be delivered after the response of this function
+		file_send_async_write_callback(file, API_E_WOULD_BLOCK, 0);
+
+		return PACKET_E_UNKNOWN_ERROR;
+	}
+
+	async_write = queue_push(&file->async_write_queue);
+
+	if (async_write == NULL) {
+		error_code = api_get_error_code_from_errno();
+
+		log_error("Could not queue asynchronous write for file object ("FILE_SIGNATURE_FORMAT"): %s (%d)",
+		          file_expand_signature(file), get_errno_name(errno), errno);
+
+		// FIXME: this callback should be delivered after the response of this function
+		file_send_async_write_callback(file, error_code, length_written);
+
+		return PACKET_E_UNKNOWN_ERROR;
+	}
+
+	memcpy(async_write->buffer, buffer, length_to_write);
+
+	async_write->length = length_to_write;
+	async_write->length_written = length_written;
+
+	// adding the write handle to the event loop can only fail if this is the
+	// only queued write, because otherwise it was added already
+	if (file_update_writable_event(file) < 0) {
+		log_error("Could not add write handle of file object ("FILE_SIGNATURE_FORMAT") to event loop: %s (%d)",
+		          file_expand_signature(file), get_errno_name(errno), errno);
 
-	if (async_read_eventfd < 0) {
-		error_code = api_get_error_code_from_errno();
+		queue_pop(&file->async_write_queue, NULL);
 
-		log_error("Could not create asynchronous read eventfd: %s (%d)",
-		          get_errno_name(errno), errno);
+		// FIXME: this callback should be delivered after the response of this function
+		file_send_async_write_callback(file, API_E_INTERNAL_ERROR, length_written);
 
-		goto cleanup;
+		return PACKET_E_UNKNOWN_ERROR;
 	}
 
-	phase = 4;
+	log_debug("Queued %d of %u byte(s) written asynchronously to file object ("FILE_SIGNATURE_FORMAT")",
+	          length_to_write - length_written, length_to_write, file_expand_signature(file));
 
-	// create file object
-	file->type = file_get_type_from_stat_mode(st.st_mode);
-	file->name = name;
-	file->flags = flags;
-	file->events = 0;
-	file->fd = fd;
-	file->async_read_eventfd = async_read_eventfd;
-	file->async_read_in_progress = false;
-	file->length_to_read_async = 0;
-	file->read = file_handle_read;
-	file->write = file_handle_write;
-	file->seek = file_handle_seek;
+	return PACKET_E_SUCCESS;
+}
 
-	error_code = object_create(&file->base, OBJECT_TYPE_FILE, session,
-	                           object_create_flags, file_destroy, file_signature);
+/*
+ * positional reads and writes use pread and pwrite. they neither use nor
+ * change the current file position, so a client can pipeline requests for
+ * different regions of a file without set_file_position requests in between
+ */
 
-	if (error_code != API_E_SUCCESS) {
-		goto cleanup;
+static APIE file_check_positional_access(File *file, uint64_t offset,
+                                         const char *access) {
+	if (offset > INT64_MAX) {
+		log_warn("Offset of %"PRIu64" byte(s) exceeds maximum length of file",
+		         offset);
+
+		return API_E_OUT_OF_RANGE;
 	}
 
-	phase = 5;
+	if (file->type == FILE_TYPE_PIPE || file->compression != NULL) {
+		log_warn("Cannot %s file object ("FILE_SIGNATURE_FORMAT") at an offset",
+		         access, file_expand_signature(file));
 
-	if (id != NULL) {
-		*id = file->base.id;
+		return API_E_INVALID_SEEK;
 	}
 
-	if (object != NULL) {
-		*object = file;
+	// same as file_handle_read and file_handle_write
+	if ((file->flags & FILE_FLAG_NON_BLOCKING) == 0) {
+		log_warn("Cannot %s file object ("FILE_SIGNATURE_FORMAT") opened without FILE_FLAG_NON_BLOCKING",
+		         access, file_expand_signature(file));
+
+		return API_E_NOT_SUPPORTED;
 	}
 
-	if ((flags & FILE_FLAG_TEMPORARY) != 0) {
-		log_debug("Created temporary file object ("FILE_SIGNATURE_FORMAT", permissions: 0o%04o, uid: %u, gid: %u, handle: %d)",
-		          file_expand_signature(file), permissions, uid, gid, fd);
-	} else if ((flags & FILE_FLAG_CREATE) != 0) {
-		log_debug("Opened/Created file object ("FILE_SIGNATURE_FORMAT", permissions: 0o%04o, uid: %u, gid: %u, handle: %d)",
-		          file_expand_signature(file), permissions, uid, gid, fd);
-	} else {
-		log_debug("Opened file object ("FILE_SIGNATURE_FORMAT", uid: %u, gid: %u, handle: %d)",
-		          file_expand_signature(file), uid, gid, fd);
+	if (file->async_read_in_progress) {
+		log_warn("Cannot %s file object ("FILE_SIGNATURE_FORMAT") at an offset while reading %"PRIu64" byte(s) asynchronously",
+		         access, file_expand_signature(file), file->length_to_read_async);
+
+		return API_E_INVALID_OPERATION;
 	}
 
-cleanup:
-	switch (phase) { // no breaks, all cases fall through intentionally
-	case 4:
-		close(async_read_eventfd);
-		// fall through
+	// pread and pwrite bypass the write-behind buffer, flush it first
+	file_write_behind_flush_all(file);
 
-	case 3:
-		free(file);
-		// fall through
+	return API_E_SUCCESS;
+}
 
-	case 2:
-		close(fd);
-		// fall through
+// sets errno on error
+static int file_pwrite(File *file, uint64_t offset, uint8_t *buffer,
+                       uint8_t length_to_write) {
+	int rc;
 
-	case 1:
-		string_unlock_and_release(name);
-		// fall through
+	// pwrite ignores the offset if the file was opened with O_APPEND
+	if ((file->flags & FILE_FLAG_APPEND) != 0) {
+		errno = EINVAL;
 
-	default:
-		break;
+		return -1;
 	}
 
-	return phase == 5 ? API_E_SUCCESS : error_code;
+	do {
+		rc = pwrite(file->fd, buffer, length_to_write, offset);
+	} while (rc < 0 && errno == EINTR);
+
+	return rc;
 }
 
 // public API
-APIE pipe_create_(uint32_t flags, uint64_t length, Session *session,
-                  uint16_t object_create_flags, ObjectID *id, File **object) {
-	int phase = 0;
+APIE file_read_at(File *file, uint64_t offset, uint8_t *buffer,
+                  uint8_t length_to_read, uint8_t *length_read) {
+	int rc;
 	APIE error_code;
-	String *name;
-	IOHandle async_read_eventfd;
-	File *file;
-
-	// check parameters
-	if ((flags & ~PIPE_FLAG_ALL) != 0) {
-		error_code = API_E_INVALID_PARAMETER;
 
-		log_warn("Invalid pipe flags 0x%04X", flags);
-
-		goto cleanup;
-	}
-
-	if (length > INT32_MAX) {
-		log_warn("Length of %"PRIu64" bytes exceeds maximum pipe buffer length", length);
+	if (length_to_read > FILE_MAX_READ_AT_BUFFER_LENGTH) {
+		log_warn("Length of %u byte(s) exceeds maximum length of file read buffer",
+		         length_to_read);
 
 		return API_E_OUT_OF_RANGE;
 	}
 
-	// get '<unnamed>' stock string object
-	error_code = inventory_get_stock_string("<unnamed>", &name);
+	error_code = file_check_positional_access(file, offset, "read from");
 
 	if (error_code != API_E_SUCCESS) {
-		goto cleanup;
+		return error_code;
 	}
 
-	phase = 1;
-
-	// allocate file object
-	file = calloc(1, sizeof(File));
+	do {
+		rc = pread(file->fd, buffer, length_to_read, offset);
+	} while (rc < 0 && errno == EINTR);
 
-	if (file == NULL) {
-		error_code = API_E_NO_FREE_MEMORY;
+	if (rc < 0) {
+		error_code = api_get_error_code_from_errno();
 
-		log_error("Could not allocate file object: %s (%d)",
-		          get_errno_name(ENOMEM), ENOMEM);
+		log_error("Could not read %u byte(s) at offset %"PRIu64" from file object ("FILE_SIGNATURE_FORMAT"): %s (%d)",
+		          length_to_read, offset, file_expand_signature(file),
+		          get_errno_name(errno), errno);
 
-		goto cleanup;
+		return error_code;
 	}
 
-	phase = 2;
-
-	// create pipe
-	if (pipe_create(&file->pipe, flags) < 0) {
-		error_code = api_get_error_code_from_errno();
+	*length_read = rc;
 
-		log_error("Could not create pipe: %s (%d)",
-		          get_errno_name(errno), errno);
+	return API_E_SUCCESS;
+}
 
-		goto cleanup;
-	}
+// public API
+APIE file_write_at(File *file, uint64_t offset, uint8_t *buffer,
+                   uint8_t length_to_write, uint8_t *length_written) {
+	int rc;
+	APIE error_code;
 
-	phase = 3;
+	if (length_to_write > FILE_MAX_WRITE_AT_BUFFER_LENGTH) {
+		log_warn("Length of %u byte(s) exceeds maximum length of file write buffer",
+		         length_to_write);
 
-	if (length > 0 && fcntl(file->pipe.base.read_handle, F_SETPIPE_SZ, (int)length) < 0) {
-		error_code = api_get_error_code_from_errno();
+		return API_E_OUT_OF_RANGE;
+	}
 
-		log_error("Could not change pipe buffer size to %"PRIu64": %s (%d)",
-		          length, get_errno_name(errno), errno);
+	error_code = file_check_positional_access(file, offset, "write to");
 
-		goto cleanup;
+	if (error_code != API_E_SUCCESS) {
+		return error_code;
 	}
 
-	// create async read eventfd
-	async_read_eventfd = eventfd(1, EFD_NONBLOCK);
+	rc = file_pwrite(file, offset, buffer, length_to_write);
 
-	if (async_read_eventfd < 0) {
+	if (rc < 0) {
 		error_code = api_get_error_code_from_errno();
 
-		log_error("Could not create asynchronous read eventfd: %s (%d)",
+		log_error("Could not write %u byte(s) at offset %"PRIu64" to file object ("FILE_SIGNATURE_FORMAT"): %s (%d)",
+		          length_to_write, offset, file_expand_signature(file),
 		          get_errno_name(errno), errno);
 
-		goto cleanup;
+		return error_code;
 	}
 
-	phase = 4;
-
-	// create file object
-	file->type = FILE_TYPE_PIPE;
-	file->name = name;
-	file->flags = flags;
-	file->events = 0;
-	file->fd = -1;
-	file->async_read_eventfd = async_read_eventfd;
-	file->async_read_in_progress = false;
-	file->length_to_read_async = 0;
-	file->read = pipe_handle_read;
-	file->write = pipe_handle_write;
-	file->seek = pipe_handle_seek;
-
-	error_code = object_create(&file->base, OBJECT_TYPE_FILE, session,
-	                           object_create_flags, file_destroy, file_signature);
+	*length_written = rc;
 
-	if (error_code != API_E_SUCCESS) {
-		goto cleanup;
-	}
+	return API_E_SUCCESS;
+}
 
-	phase = 5;
+// public API
+PacketE file_write_at_unchecked(File *file, uint64_t offset, uint8_t *buffer,
+                                uint8_t length_to_write) {
+	if (length_to_write > FILE_MAX_WRITE_AT_UNCHECKED_BUFFER_LENGTH) {
+		log_warn("Length of %u byte(s) exceeds maximum length of file unchecked write buffer",
+		         length_to_write);
 
-	if (id != NULL) {
-		*id = file->base.id;
+		return PACKET_E_INVALID_PARAMETER;
 	}
 
-	if (object != NULL) {
-		*object = file;
+	if (file_check_positional_access(file, offset, "write unchecked to") != API_E_SUCCESS) {
+		return PACKET_E_UNKNOWN_ERROR;
 	}
 
-	log_debug("Created file object ("FILE_SIGNATURE_FORMAT")",
-	          file_expand_signature(file));
+	if (file_pwrite(file, offset, buffer, length_to_write) < 0) {
+		log_error("Could not write %u byte(s) at offset %"PRIu64" to file object ("FILE_SIGNATURE_FORMAT") unchecked: %s (%d)",
+		          length_to_write, offset, file_expand_signature(file),
+		          get_errno_name(errno), errno);
 
-cleanup:
-	switch (phase) { // no breaks, all cases fall through intentionally
-	case 4:
-		close(async_read_eventfd);
-		// fall through
+		return PACKET_E_UNKNOWN_ERROR;
+	}
 
-	case 3:
-		pipe_destroy(&file->pipe);
-		// fall through
+	return PACKET_E_SUCCESS;
+}
 
-	case 2:
-		free(file);
-		// fall through
+// public API
+APIE file_get_checksum(File *file, uint8_t algorithm, uint64_t offset, uint64_t length) {
+	APIE error_code;
+	FileJob *job;
+	FileChecksumJob *checksum_job;
 
-	case 1:
-		string_unlock_and_release(name);
-		// fall through
+	if (file->type == FILE_TYPE_PIPE) {
+		log_warn("Cannot compute checksum of file object ("FILE_SIGNATURE_FORMAT")",
+		         file_expand_signature(file));
 
-	default:
-		break;
+		return API_E_NOT_SUPPORTED;
 	}
 
-	return phase == 5 ? API_E_SUCCESS : error_code;
-}
+	if (!checksum_is_valid_algorithm(algorithm)) {
+		log_warn("Invalid checksum algorithm %u", algorithm);
 
-// public API
-APIE file_get_info(File *file, Session *session, uint8_t *type,
-                   ObjectID *name_id, uint32_t *flags,
-                   uint16_t *permissions, uint32_t *uid, uint32_t *gid,
-                   uint64_t *length, uint64_t *access_timestamp,
-                   uint64_t *modification_timestamp,
-                   uint64_t *status_change_timestamp) {
-	APIE error_code;
-	struct stat st;
-	int rc;
-	FileType current_type;
+		return API_E_INVALID_PARAMETER;
+	}
 
-	*type = file->type;
+	if (offset > INT64_MAX) {
+		log_warn("Offset of %"PRIu64" byte(s) exceeds maximum length of file",
+		         offset);
 
-	if (file->type == FILE_TYPE_PIPE) {
-		*name_id = OBJECT_ID_ZERO;
-	} else {
-		error_code = object_add_external_reference(&file->name->base, session);
+		return API_E_OUT_OF_RANGE;
+	}
 
-		if (error_code != API_E_SUCCESS) {
-			return error_code;
-		}
+	// reading the whole file here could block the event loop too long. read
+	// it chunk by chunk in a background job instead
+	error_code = file_start_job(file, FILE_JOB_TYPE_CHECKSUM, sizeof(FileChecksumJob),
+	                            file_handle_checksum, &job);
 
-		*name_id = file->name->base.id;
+	if (error_code != API_E_SUCCESS) {
+		return error_code;
 	}
 
-	*flags = file->flags;
+	checksum_job = (FileChecksumJob *)job;
 
-	if (file->type == FILE_TYPE_PIPE) {
-		rc = fcntl(file->pipe.base.read_handle, F_GETPIPE_SZ);
+	checksum_init(&checksum_job->checksum, algorithm);
 
-		if (rc < 0) {
-			error_code = api_get_error_code_from_errno();
+	checksum_job->offset = offset;
+	checksum_job->length_left = length;
 
-			log_error("Could not get pipe buffer length for file object ("FILE_SIGNATURE_FORMAT"): %s (%d)",
-			          file_expand_signature(file), get_errno_name(errno), errno);
+	// pread bypasses the write-behind buffer, flush it first
+	file_write_behind_flush_all(file);
 
-			return error_code;
-		}
+	log_debug("Started computing %s checksum of %"PRIu64" byte(s) at offset %"PRIu64" of file object ("FILE_SIGNATURE_FORMAT")",
+	          checksum_get_algorithm_name(algorithm), length, offset,
+	          file_expand_signature(file));
 
-		*permissions = 0;
-		*uid = 0;
-		*gid = 0;
-		*length = rc;
-		*access_timestamp = 0;
-		*modification_timestamp = 0;
-		*status_change_timestamp = 0;
-	} else {
-		rc = fstat(file->fd, &st);
+	return API_E_SUCCESS;
+}
 
-		if (rc < 0) {
-			error_code = api_get_error_code_from_errno();
+/*
+ * the signatures of an existing file and a delta against it allow to update
+ * a file by only transferring the changed parts, similar to rsync. the client
+ * requests the signatures of the old file on the RED Brick, searches the new
+ * file for blocks with matching rolling and SHA-256 checksums and writes a
+ * delta file that consists of the following commands:
+ *
+ *   copy:    uint8_t command = 1, uint32_t block_index, uint32_t block_count
+ *   literal: uint8_t command = 2, uint32_t length, uint8_t data[length]
+ *
+ * all integers are little-endian. copy commands refer to blocks of the basis
+ * file. the new file is written to a file object opened with FILE_FLAG_REPLACE
+ * or FILE_FLAG_TEMPORARY. an already open basis file stays readable even if
+ * FILE_FLAG_REPLACE unlinked its name, so the new file can replace the old one
+ */
+
+// public API
+APIE file_get_signatures(File *file, uint32_t block_length) {
+	APIE error_code;
+	FileJob *job;
+	FileSignatureJob *signature_job;
 
-			log_error("Could not get information for file object ("FILE_SIGNATURE_FORMAT"): %s (%d)",
-			          file_expand_signature(file), get_errno_name(errno), errno);
+	if (file->type != FILE_TYPE_REGULAR) {
+		log_warn("Cannot compute signatures of file object ("FILE_SIGNATURE_FORMAT")",
+		         file_expand_signature(file));
 
-			return error_code;
-		}
+		return API_E_NOT_SUPPORTED;
+	}
 
-		current_type = file_get_type_from_stat_mode(st.st_mode);
+	if (block_length < FILE_MIN_SIGNATURE_BLOCK_LENGTH ||
+	    block_length > FILE_MAX_SIGNATURE_BLOCK_LENGTH) {
+		log_warn("Block length of %u byte(s) is out of range", block_length);
 
-		if (current_type != file->type) {
-			log_error("Current type (%s) of file object ("FILE_SIGNATURE_FORMAT") differs from cached type",
-			          file_get_type_name(current_type), file_expand_signature(file));
+		return API_E_OUT_OF_RANGE;
+	}
 
-			return API_E_INTERNAL_ERROR;
-		}
+	// reading the whole file here could block the event loop too long. read
+	// it block by block in a background job instead
+	error_code = file_start_job(file, FILE_JOB_TYPE_SIGNATURES, sizeof(FileSignatureJob),
+	                            file_handle_signatures, &job);
 
-		*permissions = file_get_permissions_from_stat_mode(st.st_mode);
-		*uid = st.st_uid;
-		*gid = st.st_gid;
-		*length = st.st_size;
-		*access_timestamp = st.st_atime;
-		*modification_timestamp = st.st_mtime;
-		*status_change_timestamp = st.st_ctime;
+	if (error_code != API_E_SUCCESS) {
+		return error_code;
 	}
 
+	signature_job = (FileSignatureJob *)job;
+
+	signature_job->block_length = block_length;
+	signature_job->block_index = 0;
+
+	// pread bypasses the write-behind buffer, flush it first
+	file_write_behind_flush_all(file);
+
+	log_debug("Started computing signatures of %u byte blocks of file object ("FILE_SIGNATURE_FORMAT")",
+	          block_length, file_expand_signature(file));
+
 	return API_E_SUCCESS;
 }
 
 // public API
-APIE file_read_(File *file, uint8_t *buffer, uint8_t length_to_read,
-                uint8_t *length_read) {
-	int rc;
+APIE file_apply_delta(File *file, ObjectID basis_file_id, ObjectID delta_file_id,
+                      uint32_t block_length) {
+	int phase = 0;
 	APIE error_code;
+	File *basis;
+	File *delta;
+	struct stat target_st;
+	struct stat basis_st;
+	FileJob *job;
+	FileDeltaJob *delta_job;
 
-	if (length_to_read > FILE_MAX_READ_BUFFER_LENGTH) {
-		log_warn("Length of %u byte(s) exceeds maximum length of file read buffer",
-		         length_to_read);
+	// check parameters
+	if (file->type != FILE_TYPE_REGULAR ||
+	    (file->flags & (FILE_FLAG_WRITE_ONLY | FILE_FLAG_READ_WRITE)) == 0 ||
+	    (file->flags & (FILE_FLAG_WRITE_BEHIND | FILE_FLAG_COMPRESSED)) != 0) {
+		error_code = API_E_INVALID_OPERATION;
 
-		return API_E_OUT_OF_RANGE;
+		log_warn("Cannot apply delta to file object ("FILE_SIGNATURE_FORMAT"), it has to be a regular file opened for writing without FILE_FLAG_WRITE_BEHIND or FILE_FLAG_COMPRESSED",
+		         file_expand_signature(file));
+
+		goto cleanup;
 	}
 
-	if (file->async_read_in_progress) {
-		log_warn("Cannot read %u byte(s) synchronously while reading %"PRIu64" byte(s) from file object ("FILE_SIGNATURE_FORMAT") asynchronously",
-		         length_to_read, file->length_to_read_async, file_expand_signature(file));
+	if ((file->flags & (FILE_FLAG_REPLACE | FILE_FLAG_TEMPORARY)) == 0) {
+		error_code = API_E_INVALID_OPERATION;
 
-		return API_E_INVALID_OPERATION;
+		log_warn("Cannot apply delta to file object ("FILE_SIGNATURE_FORMAT") opened without FILE_FLAG_REPLACE or FILE_FLAG_TEMPORARY",
+		         file_expand_signature(file));
+
+		goto cleanup;
 	}
 
-	rc = file->read(file, buffer, length_to_read); // FIXME: handle EINTR
+	if (block_length < FILE_MIN_SIGNATURE_BLOCK_LENGTH ||
+	    block_length > FILE_MAX_SIGNATURE_BLOCK_LENGTH) {
+		error_code = API_E_OUT_OF_RANGE;
 
-	if (rc < 0) {
-		if (errno_would_block()) {
-			// don't report an error, just return an empty buffer if there is
-			// nothing to read at this time
-			rc = 0;
-		} else {
-			error_code = api_get_error_code_from_errno();
+		log_warn("Block length of %u byte(s) is out of range", block_length);
 
-			log_error("Could not read %u byte(s) from file object ("FILE_SIGNATURE_FORMAT"): %s (%d)",
-			          length_to_read, file_expand_signature(file),
-			          get_errno_name(errno), errno);
+		goto cleanup;
+	}
 
-			return error_code;
-		}
+	// get basis and delta file objects
+	error_code = file_get_acquired(basis_file_id, "file_apply_delta:basis", &basis);
+
+	if (error_code != API_E_SUCCESS) {
+		goto cleanup;
 	}
 
-	*length_read = rc;
+	phase = 1;
 
-	return API_E_SUCCESS;
-}
+	error_code = file_get_acquired(delta_file_id, "file_apply_delta:delta", &delta);
 
-// public API
-PacketE file_read_async(File *file, uint64_t length_to_read) {
-	if (length_to_read > INT64_MAX) {
-		log_warn("Length of %"PRIu64" byte(s) exceeds maximum length of file",
-		         length_to_read);
+	if (error_code != API_E_SUCCESS) {
+		goto cleanup;
+	}
 
-		// FIXME: this callback should be delivered after the response of this function
-		file_send_async_read_callback(file, API_E_OUT_OF_RANGE, NULL, 0);
+	phase = 2;
 
-		return PACKET_E_INVALID_PARAMETER;
+	if (basis->type != FILE_TYPE_REGULAR || delta->type != FILE_TYPE_REGULAR) {
+		error_code = API_E_INVALID_OPERATION;
+
+		log_warn("Cannot apply delta with non-regular basis or delta file object");
+
+		goto cleanup;
 	}
 
-	if (file->async_read_in_progress) {
-		log_warn("Still reading %"PRIu64" byte(s) from file object ("FILE_SIGNATURE_FORMAT") asynchronously",
-		         file->length_to_read_async, file_expand_signature(file));
+	if (fstat(file->fd, &target_st) < 0 || fstat(basis->fd, &basis_st) < 0) {
+		error_code = api_get_error_code_from_errno();
 
-		// FIXME: this callback should be delivered after the response of this function
-		file_send_async_read_callback(file, API_E_INVALID_OPERATION, NULL, 0);
+		log_error("Could not get information for file object ("FILE_SIGNATURE_FORMAT") or its basis: %s (%d)",
+		          file_expand_signature(file), get_errno_name(errno), errno);
 
-		return PACKET_E_UNKNOWN_ERROR;
+		goto cleanup;
 	}
 
-	file->async_read_in_progress = true;
-	file->length_to_read_async = length_to_read;
+	// overwriting the basis while reading it would corrupt the new file
+	if (target_st.st_dev == basis_st.st_dev && target_st.st_ino == basis_st.st_ino) {
+		error_code = API_E_INVALID_PARAMETER;
 
-	// reading the whole file and generating the callbacks here could block the
-	// event loop too long. instead poll a readable eventfd for readability.
-	// when done reading asynchronously then remove the eventfd from the event
-	// loop again
-	if (event_add_source(file->async_read_eventfd, EVENT_SOURCE_TYPE_GENERIC,
-	                     "file-async-read", EVENT_READ, file_handle_async_read, file) < 0) {
-		// FIXME: this callback should be delivered after the response of this function
-		file_send_async_read_callback(file, API_E_INTERNAL_ERROR, NULL, 0);
+		log_warn("Cannot apply delta to file object ("FILE_SIGNATURE_FORMAT") using itself as basis",
+		         file_expand_signature(file));
 
-		return PACKET_E_UNKNOWN_ERROR;
+		goto cleanup;
 	}
 
-	log_debug("Started reading of %"PRIu64" byte(s) from file object ("FILE_SIGNATURE_FORMAT") asynchronously",
-	          length_to_read, file_expand_signature(file));
+	// pread bypasses the write-behind buffer, flush it first
+	file_write_behind_flush_all(basis);
 
-	return PACKET_E_SUCCESS;
-}
+	file_write_behind_flush_all(delta);
 
-// public API
-APIE file_abort_async_read(File *file) {
-	if (file->async_read_in_progress) {
-		event_remove_source(file->async_read_eventfd, EVENT_SOURCE_TYPE_GENERIC);
+	// writing the whole file here could block the event loop too long. write
+	// it chunk by chunk in a background job instead
+	error_code = file_start_job(file, FILE_JOB_TYPE_DELTA, sizeof(FileDeltaJob),
+	                            file_handle_delta, &job);
 
-		file->async_read_in_progress = false;
-		file->length_to_read_async = 0;
+	if (error_code != API_E_SUCCESS) {
+		goto cleanup;
+	}
 
-		// FIXME: this callback should be delivered after the response of this function
-		file_send_async_read_callback(file, API_E_OPERATION_ABORTED, NULL, 0);
+	delta_job = (FileDeltaJob *)job;
+
+	delta_job->basis = basis; // released by file_stop_job
+	delta_job->delta = delta; // released by file_stop_job
+	delta_job->block_length = block_length;
+	delta_job->offset = 0;
+	delta_job->command = FILE_DELTA_COMMAND_NONE;
+	delta_job->basis_offset = 0;
+	delta_job->length_left = 0;
+	delta_job->length = 0;
+
+	log_debug("Started applying delta from file object ("FILE_SIGNATURE_FORMAT") to file object ("FILE_SIGNATURE_FORMAT")",
+	          file_expand_signature(delta), file_expand_signature(file));
+
+	phase = 3;
+
+cleanup:
+	switch (phase) { // no breaks, all cases fall through intentionally
+	case 2:
+		file_release(delta);
+		// fall through
+
+	case 1:
+		file_release(basis);
+		// fall through
+
+	default:
+		break;
 	}
 
-	return API_E_SUCCESS;
+	return phase == 3 ? API_E_SUCCESS : error_code;
 }
 
 // public API
-APIE file_write_(File *file, uint8_t *buffer, uint8_t length_to_write,
-                 uint8_t *length_written) {
-	int rc;
+APIE file_read_string(File *file, uint32_t length_to_read, Session *session,
+                      ObjectID *string_id) {
+	String *string;
 	APIE error_code;
+	uint32_t length;
+	int rc;
 
-	if (length_to_write > FILE_MAX_WRITE_BUFFER_LENGTH) {
-		log_warn("Length of %u byte(s) exceeds maximum length of file write buffer",
-		         length_to_write);
+	if (length_to_read > FILE_MAX_READ_STRING_LENGTH) {
+		log_warn("Length of %u byte(s) exceeds maximum length of %u byte(s) for reading into string object",
+		         length_to_read, FILE_MAX_READ_STRING_LENGTH);
 
 		return API_E_OUT_OF_RANGE;
 	}
 
 	if (file->async_read_in_progress) {
-		log_warn("Cannot write %u byte(s) while reading %"PRIu64" byte(s) from file object ("FILE_SIGNATURE_FORMAT") asynchronously",
-		         length_to_write, file->length_to_read_async, file_expand_signature(file));
+		log_warn("Cannot read %u byte(s) into string object while reading %"PRIu64" byte(s) from file object ("FILE_SIGNATURE_FORMAT") asynchronously",
+		         length_to_read, file->length_to_read_async, file_expand_signature(file));
 
 		return API_E_INVALID_OPERATION;
 	}
 
-	rc = file->write(file, buffer, length_to_write); // FIXME: handle EINTR
-
-	if (rc < 0) {
-		error_code = api_get_error_code_from_errno();
-
-		if (errno_would_block()) {
-			log_debug("Writing %u byte(s) to file object ("FILE_SIGNATURE_FORMAT") would block",
-			          length_to_write, file_expand_signature(file));
-		} else {
-			log_error("Could not write %u byte(s) to file object ("FILE_SIGNATURE_FORMAT"): %s (%d)",
-			          length_to_write, file_expand_signature(file),
-			          get_errno_name(errno), errno);
-		}
+	error_code = string_wrap("", session, OBJECT_CREATE_FLAG_EXTERNAL, NULL, &string);
 
+	if (error_code != API_E_SUCCESS) {
 		return error_code;
 	}
 
-	*length_written = rc;
+	// read directly into the string buffer until the requested length is
+	// reached, the end of the file is reached or reading would block. only
+	// a regular file is read in multiple chunks, because a short read from
+	// it means end-of-file. pipes and sockets are read only once, otherwise
+	// a blocking pipe would stall the event loop until enough data arrives
+	while (string->length < length_to_read) {
+		length = length_to_read - string->length;
 
-	return API_E_SUCCESS;
-}
+		if (length > FILE_READ_STRING_CHUNK_LENGTH) {
+			length = FILE_READ_STRING_CHUNK_LENGTH;
+		}
 
-// public API
-PacketE file_write_unchecked(File *file, uint8_t *buffer, uint8_t length_to_write) {
-	if (length_to_write > FILE_MAX_WRITE_UNCHECKED_BUFFER_LENGTH) {
-		log_warn("Length of %u byte(s) exceeds maximum length of file unchecked write buffer",
-		         length_to_write);
+		error_code = string_reserve(string, string->length + length);
 
-		return PACKET_E_INVALID_PARAMETER;
-	}
+		if (error_code != API_E_SUCCESS) {
+			goto error;
+		}
 
-	if (file->async_read_in_progress) {
-		log_warn("Cannot write %u byte(s) unchecked while reading %"PRIu64" byte(s) from file object ("FILE_SIGNATURE_FORMAT") asynchronously",
-		         length_to_write, file->length_to_read_async, file_expand_signature(file));
+		rc = file->read(file, string->buffer + string->length, length);
 
-		return PACKET_E_UNKNOWN_ERROR;
-	}
+		if (rc < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
 
-	if (file->write(file, buffer, length_to_write) < 0) { // FIXME: handle EINTR
-		if (errno_would_block()) {
-			log_debug("Writing %u byte(s) unchecked to file object ("FILE_SIGNATURE_FORMAT") would block",
-			          length_to_write, file_expand_signature(file));
-		} else {
-			log_error("Could not write %u byte(s) to file object ("FILE_SIGNATURE_FORMAT") unchecked: %s (%d)",
-			          length_to_write, file_expand_signature(file),
+			if (errno_would_block()) {
+				break;
+			}
+
+			error_code = api_get_error_code_from_errno();
+
+			log_error("Could not read %u byte(s) from file object ("FILE_SIGNATURE_FORMAT") into string object: %s (%d)",
+			          length, file_expand_signature(file),
 			          get_errno_name(errno), errno);
+
+			goto error;
 		}
 
-		return PACKET_E_UNKNOWN_ERROR;
+		string->length += rc;
+
+		if ((uint32_t)rc < length || file->type != FILE_TYPE_REGULAR) {
+			break;
+		}
 	}
 
-	return PACKET_E_SUCCESS;
+	string->buffer[string->length] = '\0';
+
+	log_debug("Read %u byte(s) from file object ("FILE_SIGNATURE_FORMAT") into string object (id: %u)",
+	          string->length, file_expand_signature(file), string->base.id);
+
+	*string_id = string->base.id;
+
+	return API_E_SUCCESS;
+
+error:
+	object_remove_external_reference(&string->base, session);
+
+	return error_code;
 }
 
 // public API
-PacketE file_write_async(File *file, uint8_t *buffer, uint8_t length_to_write) {
-	int length_written;
+APIE file_write_string(File *file, ObjectID string_id, uint32_t *length_written) {
+	String *string;
+	uint32_t offset = 0;
 	APIE error_code;
+	int rc;
 
-	if (length_to_write > FILE_MAX_WRITE_ASYNC_BUFFER_LENGTH) {
-		log_warn("Length of %u byte(s) exceeds maximum length of file async write buffer",
-		         length_to_write);
-
-		// FIXME: this callback should be delivered after the response of this function
-		file_send_async_write_callback(file, API_E_OUT_OF_RANGE, 0);
+	error_code = string_get(string_id, "file_write_string", &string);
 
-		return PACKET_E_INVALID_PARAMETER;
+	if (error_code != API_E_SUCCESS) {
+		return error_code;
 	}
 
 	if (file->async_read_in_progress) {
-		log_warn("Cannot write %u byte(s) asynchronously while reading %"PRIu64" byte(s) from file object ("FILE_SIGNATURE_FORMAT") asynchronously",
-		         length_to_write, file->length_to_read_async, file_expand_signature(file));
+		log_warn("Cannot write string object (id: %u) while reading %"PRIu64" byte(s) from file object ("FILE_SIGNATURE_FORMAT") asynchronously",
+		         string->base.id, file->length_to_read_async, file_expand_signature(file));
 
-		// FIXME: this callback should be delivered after the response of this function
-		file_send_async_write_callback(file, API_E_INVALID_OPERATION, 0);
+		return API_E_INVALID_OPERATION;
+	}
 
-		return PACKET_E_UNKNOWN_ERROR;
+	if (file->type == FILE_TYPE_PIPE && file->async_write_queue.count > 0) {
+		log_debug("Cannot write string object (id: %u) to file object ("FILE_SIGNATURE_FORMAT") while asynchronous writes are queued",
+		          string->base.id, file_expand_signature(file));
+
+		return API_E_WOULD_BLOCK;
 	}
 
-	length_written = file->write(file, buffer, length_to_write); // FIXME: handle EINTR
+	// write until the whole string is written or writing would block. a
+	// partial write is reported as success with the number of bytes written
+	while (offset < string->length) {
+		rc = file->write(file, string->buffer + offset, string->length - offset);
 
-	if (length_written < 0) {
-		error_code = api_get_error_code_from_errno();
+		if (rc < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
 
-		if (errno_would_block()) {
-			log_debug("Writing %u byte(s) asynchronously to file object ("FILE_SIGNATURE_FORMAT") would block",
-			          length_to_write, file_expand_signature(file));
-		} else {
-			log_error("Could not write %u byte(s) to file object ("FILE_SIGNATURE_FORMAT") asynchronously: %s (%d)",
-			          length_to_write, file_expand_signature(file),
-			          get_errno_name(errno), errno);
-		}
+			if (errno_would_block() && offset > 0) {
+				break;
+			}
 
-		// FIXME: this callback should be delivered after the response of this function
-		file_send_async_write_callback(file, error_code, 0);
+			error_code = api_get_error_code_from_errno();
 
-		return PACKET_E_UNKNOWN_ERROR;
+			if (errno_would_block()) {
+				log_debug("Writing string object (id: %u) to file object ("FILE_SIGNATURE_FORMAT") would block",
+				          string->base.id, file_expand_signature(file));
+			} else {
+				log_error("Could not write %u byte(s) of string object (id: %u) to file object ("FILE_SIGNATURE_FORMAT"): %s (%d)",
+				          string->length - offset, string->base.id, file_expand_signature(file),
+				          get_errno_name(errno), errno);
+			}
+
+			return error_code;
+		}
+
+		offset += rc;
 	}
 
-	// FIXME: this callback should be delivered after the response of this function
-	file_send_async_write_callback(file, API_E_SUCCESS, length_written);
+	log_debug("Wrote %u byte(s) of string object (id: %u) to file object ("FILE_SIGNATURE_FORMAT")",
+	          offset, string->base.id, file_expand_signature(file));
 
-	return PACKET_E_SUCCESS;
+	*length_written = offset;
+
+	return API_E_SUCCESS;
 }
 
 // public API
@@ -1443,17 +3899,20 @@ APIE file_set_events(File *file, uint16_t events) {
 		file->events &= ~FILE_EVENT_READABLE;
 	}
 
+	// the write handle might be in the event loop for queued asynchronous
+	// writes already
 	if ((events & FILE_EVENT_WRITABLE) != 0 && (file->events & FILE_EVENT_WRITABLE) == 0) {
-		if (event_add_source(file->pipe.base.write_handle, EVENT_SOURCE_TYPE_GENERIC,
-		                     "pipe-write", EVENT_WRITE, file_handle_writable_event, file) < 0) {
+		file->events |= FILE_EVENT_WRITABLE;
+
+		if (file_update_writable_event(file) < 0) {
+			file->events &= ~FILE_EVENT_WRITABLE;
+
 			return API_E_INTERNAL_ERROR;
 		}
-
-		file->events |= FILE_EVENT_WRITABLE;
 	} else if ((events & FILE_EVENT_WRITABLE) == 0 && (file->events & FILE_EVENT_WRITABLE) != 0) {
-		event_remove_source(file->pipe.base.write_handle, EVENT_SOURCE_TYPE_GENERIC);
-
 		file->events &= ~FILE_EVENT_WRITABLE;
+
+		file_update_writable_event(file); // removing cannot fail
 	}
 
 	return API_E_SUCCESS;
@@ -28,7 +28,9 @@
 #include <daemonlib/io.h>
 #include <daemonlib/packet.h>
 #include <daemonlib/pipe.h>
+#include <daemonlib/queue.h>
 
+#include "archive.h"
 #include "object.h"
 #include "string.h"
 
@@ -42,7 +44,9 @@ typedef enum { // bitmask
 	FILE_FLAG_NON_BLOCKING = 0x0040,
 	FILE_FLAG_TRUNCATE     = 0x0080,
 	FILE_FLAG_TEMPORARY    = 0x0100, // can only be used in combination with FILE_FLAG_CREATE | FILE_FLAG_EXCLUSIVE
-	FILE_FLAG_REPLACE      = 0x0200  // can only be used in combination with FILE_FLAG_CREATE
+	FILE_FLAG_REPLACE      = 0x0200, // can only be used in combination with FILE_FLAG_CREATE
+	FILE_FLAG_WRITE_BEHIND = 0x0400, // can only be used for regular files opened for writing
+	FILE_FLAG_COMPRESSED   = 0x0800  // can only be used for regular files opened either read-only or write-only
 } FileFlag;
 
 #define FILE_FLAG_ALL (FILE_FLAG_READ_ONLY | \
@@ -54,7 +58,9 @@ typedef enum { // bitmask
                        FILE_FLAG_NON_BLOCKING | \
                        FILE_FLAG_TRUNCATE | \
                        FILE_FLAG_TEMPORARY | \
-                       FILE_FLAG_REPLACE)
+                       FILE_FLAG_REPLACE | \
+                       FILE_FLAG_WRITE_BEHIND | \
+                       FILE_FLAG_COMPRESSED)
 
 #define PIPE_FLAG_ALL (PIPE_FLAG_NON_BLOCKING_READ | \
                        PIPE_FLAG_NON_BLOCKING_WRITE)
@@ -118,8 +124,19 @@ typedef enum {
 #define FILE_MAX_WRITE_BUFFER_LENGTH 61
 #define FILE_MAX_WRITE_UNCHECKED_BUFFER_LENGTH 61
 #define FILE_MAX_WRITE_ASYNC_BUFFER_LENGTH 61
+#define FILE_MAX_READ_AT_BUFFER_LENGTH 62
+#define FILE_MAX_WRITE_AT_BUFFER_LENGTH 53
+#define FILE_MAX_WRITE_AT_UNCHECKED_BUFFER_LENGTH 53
+#define FILE_MAX_ASYNC_WRITE_QUEUE_LENGTH 256 // async writes
+#define FILE_MAX_READ_STRING_LENGTH 1048576
+#define FILE_MIN_SIGNATURE_BLOCK_LENGTH 64
+#define FILE_MAX_SIGNATURE_BLOCK_LENGTH 65536
 
 typedef struct _File File;
+typedef struct _FileFollow FileFollow;
+typedef struct _FileWriteBehind FileWriteBehind;
+typedef struct _FileCompression FileCompression;
+typedef struct _FileJob FileJob;
 
 typedef int (*FileReadFunction)(File *file, void *buffer, int length);
 typedef int (*FileWriteFunction)(File *file, void *buffer, int length);
@@ -134,11 +151,24 @@ struct _File {
 	                // refers to FileFlag otherwise
 	uint16_t events;
 	IOHandle fd; // only opened if type != FILE_TYPE_PIPE
+	uint32_t uid; // identity used to open the file, only valid if type != FILE_TYPE_PIPE
+	uint32_t gid;
 	Pipe pipe; // only created if type == FILE_TYPE_PIPE
 	IOHandle async_read_eventfd;
 	Pipe async_read_pipe; // only created if type == FILE_TYPE_REGULAR
 	bool async_read_in_progress;
 	uint64_t length_to_read_async;
+	bool async_read_credit_mode; // limit callbacks by client granted credit
+	uint32_t async_read_credit; // callbacks left to send in credit mode
+	bool async_read_paused; // eventfd removed from event loop, out of credit
+	FileFollow *follow; // only allocated while following, keeps reading data appended after end-of-file
+	FileWriteBehind *write_behind; // only allocated if FILE_FLAG_WRITE_BEHIND is used
+	FileCompression *compression; // only allocated if FILE_FLAG_COMPRESSED is used
+	ArchiveExtractor *archive_extractor; // only created for pipes returned by file_extract_archive
+	ArchiveCreator *archive_creator; // only created for pipes returned by file_create_archive
+	Queue async_write_queue; // only created if type == FILE_TYPE_PIPE
+	bool writable_event_added; // write handle is in the event loop
+	FileJob *job; // only allocated while a checksum, copy, signature or delta job is in progress
 	FileWriteFunction read;
 	FileWriteFunction write;
 	FileSeekFunction seek;
@@ -150,9 +180,18 @@ APIE file_open(ObjectID name_id, uint32_t flags, uint16_t permissions,
                uint32_t uid, uint32_t gid, Session *session,
                uint16_t object_create_flags, ObjectID *id, File **object);
 
+APIE file_copy(ObjectID source_name_id, ObjectID target_name_id, uint32_t flags,
+               uint16_t permissions, uint32_t uid, uint32_t gid,
+               Session *session, ObjectID *id);
+
 APIE pipe_create_(uint32_t flags, uint64_t length, Session *session,
                   uint16_t object_create_flags, ObjectID *id, File **object);
 
+APIE file_create_archive(ObjectID root_directory_name_id, uint32_t flags,
+                         Session *session, ObjectID *id);
+APIE file_extract_archive(ObjectID root_directory_name_id, uint32_t uid,
+                          uint32_t gid, Session *session, ObjectID *id);
+
 APIE file_get_info(File *file, Session *session, uint8_t *type,
                    ObjectID *name_id, uint32_t *flags,
                    uint16_t *permissions, uint32_t *uid, uint32_t *gid,
@@ -163,6 +202,9 @@ APIE file_get_info(File *file, Session *session, uint8_t *type,
 APIE file_read_(File *file, uint8_t *buffer, uint8_t length_to_read,
                 uint8_t *length_read);
 PacketE file_read_async(File *file, uint64_t length_to_read);
+PacketE file_read_async_with_credit(File *file, uint64_t length_to_read, uint16_t credit);
+PacketE file_follow_async(File *file, uint16_t credit, uint32_t idle_timeout);
+APIE file_grant_async_read_credit(File *file, uint16_t credit);
 APIE file_abort_async_read(File *file);
 
 APIE file_write_(File *file, uint8_t *buffer, uint8_t length_to_write,
@@ -170,6 +212,22 @@ APIE file_write_(File *file, uint8_t *buffer, uint8_t length_to_write,
 PacketE file_write_unchecked(File *file, uint8_t *buffer, uint8_t length_to_write);
 PacketE file_write_async(File *file, uint8_t *buffer, uint8_t length_to_write);
 
+APIE file_read_at(File *file, uint64_t offset, uint8_t *buffer,
+                  uint8_t length_to_read, uint8_t *length_read);
+APIE file_write_at(File *file, uint64_t offset, uint8_t *buffer,
+                   uint8_t length_to_write, uint8_t *length_written);
+PacketE file_write_at_unchecked(File *file, uint64_t offset, uint8_t *buffer,
+                                uint8_t length_to_write);
+
+APIE file_get_checksum(File *file, uint8_t algorithm, uint64_t offset, uint64_t length);
+APIE file_get_signatures(File *file, uint32_t block_length);
+APIE file_apply_delta(File *file, ObjectID basis_file_id, ObjectID delta_file_id,
+                      uint32_t block_length);
+
+APIE file_read_string(File *file, uint32_t length_to_read, Session *session,
+                      ObjectID *string_id);
+APIE file_write_string(File *file, ObjectID string_id, uint32_t *length_written);
+
 APIE file_set_position(File *file, int64_t offset, FileOrigin origin,
                        uint64_t *position);
 APIE file_get_position(File *file, uint64_t *position);
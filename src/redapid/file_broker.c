@@ -0,0 +1,542 @@
+/*
+ * redapid
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * file_broker.c: Helper processes to open files as other users
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * opening a file as a different user requires a process that runs with the
+ * identity of that user. instead of forking a child process for each open
+ * call, a helper process is forked per user and group ID pair on demand. it
+ * changes its identity once and then serves open requests over a socket pair
+ * until it is idle for FILE_BROKER_IDLE_TIMEOUT. the opened file descriptors
+ * are passed back to redapid as SCM_RIGHTS control messages.
+ *
+ * a request consists of a FileBrokerRequest followed by the NULL-terminated
+ * file name. the response is a single byte containing the error code, with
+ * the file descriptor attached on success. the socket pair uses SOCK_SEQPACKET
+ * to preserve message boundaries. after the identity change the helper sends
+ * a response without a file descriptor to report the outcome of the change.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <daemonlib/log.h>
+#include <daemonlib/utils.h>
+
+#include "file_broker.h"
+
+#include "file.h"
+#include "process.h"
+#include "wheel_timer.h"
+
+static LogSource _log_source = LOG_SOURCE_INITIALIZER;
+
+#define FILE_BROKER_MAX_COUNT 4
+#define FILE_BROKER_IDLE_TIMEOUT 30000000 // microseconds
+
+typedef struct {
+	uint32_t flags;
+	int32_t oflags;
+	uint32_t mode;
+} FileBrokerRequest;
+
+typedef struct {
+	bool running;
+	uint32_t uid;
+	uint32_t gid;
+	pid_t pid;
+	int socket; // parent end of the socket pair
+	uint32_t last_used;
+	WheelTimer idle_timer;
+} FileBroker;
+
+// brokers are not relocatable, because their wheel timers are linked into the
+// timer wheel and are passed to the timer function by address
+static FileBroker _brokers[FILE_BROKER_MAX_COUNT];
+static uint32_t _use_counter;
+
+static int sendfd(int socket_handle, int fd, uint8_t data) {
+	struct iovec iovec;
+	struct msghdr msghdr;
+	struct cmsghdr *cmsghdr;
+	uint8_t control[CMSG_SPACE(sizeof(int))];
+
+	iovec.iov_base = &data;
+	iovec.iov_len = sizeof(data);
+
+	memset(&msghdr, 0, sizeof(msghdr));
+
+	msghdr.msg_iov = &iovec;
+	msghdr.msg_iovlen = 1;
+
+	if (fd < 0) {
+		msghdr.msg_control = NULL;
+		msghdr.msg_controllen = 0;
+	} else {
+		msghdr.msg_control = (caddr_t)control;
+		msghdr.msg_controllen = CMSG_LEN(sizeof(int));
+
+		cmsghdr = CMSG_FIRSTHDR(&msghdr);
+		cmsghdr->cmsg_len = CMSG_LEN(sizeof(int));
+		cmsghdr->cmsg_level = SOL_SOCKET;
+		cmsghdr->cmsg_type = SCM_RIGHTS;
+
+		memcpy(CMSG_DATA(cmsghdr), &fd, sizeof(int));
+	}
+
+	if (sendmsg(socket_handle, &msghdr, MSG_NOSIGNAL) != (int)iovec.iov_len) {
+		return -1;
+	}
+
+	return 0;
+}
+
+static int recvfd(int socket_handle, int *fd, uint8_t *data) {
+	struct iovec iovec;
+	struct msghdr msghdr;
+	struct cmsghdr *cmsghdr;
+	uint8_t control[CMSG_SPACE(sizeof(int))];
+	ssize_t rc;
+
+	iovec.iov_base = data;
+	iovec.iov_len = sizeof(*data);
+
+	memset(&msghdr, 0, sizeof (msghdr));
+
+	msghdr.msg_name = 0;
+	msghdr.msg_namelen = 0;
+	msghdr.msg_iov = &iovec;
+	msghdr.msg_iovlen = 1;
+	msghdr.msg_control = (caddr_t)control;
+	msghdr.msg_controllen = sizeof(control);
+
+	rc = recvmsg(socket_handle, &msghdr, 0);
+
+	if (rc == 0) {
+		errno = ECONNRESET; // other end got closed
+
+		return -1;
+	}
+
+	if (rc < 0) {
+		return -1;
+	}
+
+	cmsghdr = CMSG_FIRSTHDR(&msghdr);
+
+	if (cmsghdr != NULL) {
+		memcpy(fd, CMSG_DATA(cmsghdr), sizeof(int));
+	} else {
+		*fd = -1;
+	}
+
+	return 0;
+}
+
+// runs in the helper process, never returns
+static void file_broker_serve(int socket_handle) {
+	static uint8_t buffer[sizeof(FileBrokerRequest) + PATH_MAX];
+	FileBrokerRequest *request = (FileBrokerRequest *)buffer;
+	const char *name = (const char *)buffer + sizeof(FileBrokerRequest);
+	ssize_t length;
+	APIE error_code;
+	int fd;
+	int rc;
+
+	for (;;) {
+		// MSG_TRUNC makes recv report the real length of a too long request
+		length = recv(socket_handle, buffer, sizeof(buffer), MSG_TRUNC);
+
+		if (length < 0 && errno_interrupted()) {
+			continue;
+		}
+
+		if (length <= 0) {
+			_exit(length < 0 ? PROCESS_E_INTERNAL_ERROR : 0); // zero means redapid closed its end
+		}
+
+		fd = -1;
+
+		if ((size_t)length > sizeof(buffer)) {
+			error_code = API_E_NAME_TOO_LONG;
+		} else if ((size_t)length <= sizeof(FileBrokerRequest) || buffer[length - 1] != '\0') {
+			error_code = API_E_INVALID_PARAMETER;
+		} else {
+			fd = open(name, request->oflags, (mode_t)request->mode);
+			error_code = fd < 0 ? api_get_error_code_from_errno() : API_E_SUCCESS;
+		}
+
+		do {
+			rc = sendfd(socket_handle, fd, error_code);
+		} while (rc < 0 && errno_interrupted());
+
+		if (fd >= 0) {
+			close(fd); // redapid got its own duplicate of the file descriptor
+		}
+
+		if (rc < 0) {
+			_exit(PROCESS_E_INTERNAL_ERROR);
+		}
+	}
+}
+
+static void file_broker_stop(FileBroker *broker) {
+	int rc;
+
+	log_debug("Stopping file broker (uid: %u, gid: %u, pid: %u)",
+	          broker->uid, broker->gid, broker->pid);
+
+	wheel_timer_destroy(&broker->idle_timer);
+
+	// closing the socket makes the helper process exit
+	close(broker->socket);
+
+	do {
+		rc = waitpid(broker->pid, NULL, 0);
+	} while (rc < 0 && errno_interrupted());
+
+	if (rc < 0) {
+		log_error("Could not wait for file broker (uid: %u, gid: %u, pid: %u) to exit: %s (%d)",
+		          broker->uid, broker->gid, broker->pid, get_errno_name(errno), errno);
+	}
+
+	broker->running = false;
+}
+
+static void file_broker_handle_idle(void *opaque) {
+	FileBroker *broker = opaque;
+
+	log_debug("File broker (uid: %u, gid: %u, pid: %u) is idle",
+	          broker->uid, broker->gid, broker->pid);
+
+	file_broker_stop(broker);
+}
+
+static APIE file_broker_start(FileBroker *broker, uint32_t uid, uint32_t gid) {
+	APIE error_code;
+	int pair[2];
+	pid_t pid;
+	long sc_open_max;
+	long i;
+	int fd;
+	uint8_t status;
+	int rc;
+
+	// create socket pair to send requests to the helper process and to
+	// receive FDs from it
+	if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, pair) < 0) {
+		error_code = api_get_error_code_from_errno();
+
+		log_error("Could not create socket pair for file broker (uid: %u, gid: %u): %s (%d)",
+		          uid, gid, get_errno_name(errno), errno);
+
+		return error_code;
+	}
+
+	error_code = process_fork(&pid);
+
+	if (error_code != API_E_SUCCESS) {
+		close(pair[0]);
+		close(pair[1]);
+
+		return error_code;
+	}
+
+	if (pid == 0) { // child
+		// close socket pair parent end in child
+		close(pair[0]);
+
+		// get open FD limit
+		sc_open_max = sysconf(_SC_OPEN_MAX);
+
+		if (sc_open_max < 0) {
+			error_code = api_get_error_code_from_errno();
+
+			log_error("Could not get SC_OPEN_MAX value: %s (%d)",
+			          get_errno_name(errno), errno);
+		} else {
+			// change user and groups
+			error_code = process_set_identity(uid, gid);
+		}
+
+		// report outcome of the identity change to parent in all cases
+		do {
+			rc = sendfd(pair[1], -1, error_code);
+		} while (rc < 0 && errno_interrupted());
+
+		if (rc < 0 || error_code != API_E_SUCCESS) {
+			_exit(PROCESS_E_INTERNAL_ERROR);
+		}
+
+		// the helper process is long-lived. it has to close all inherited
+		// file descriptors, otherwise it would keep pipes and sockets of
+		// redapid open. the log file is one of them, disable the log output
+		// beforehand
+		log_set_output(NULL, NULL);
+
+		for (i = STDERR_FILENO + 1; i < sc_open_max; ++i) {
+			if (i != pair[1]) {
+				close(i);
+			}
+		}
+
+		file_broker_serve(pair[1]);
+	}
+
+	// close socket pair child end in parent
+	close(pair[1]);
+
+	// receive outcome of identity change from child
+	do {
+		rc = recvfd(pair[0], &fd, &status);
+	} while (rc < 0 && errno_interrupted());
+
+	if (rc < 0 || status != API_E_SUCCESS) {
+		if (rc < 0) {
+			error_code = api_get_error_code_from_errno();
+
+			log_error("Could not receive status from file broker (uid: %u, gid: %u, pid: %u): %s (%d)",
+			          uid, gid, pid, get_errno_name(errno), errno);
+		} else {
+			error_code = status;
+
+			log_error("File broker (uid: %u, gid: %u, pid: %u) could not change its identity: %s (%d)",
+			          uid, gid, pid, api_get_error_code_name(error_code), error_code);
+		}
+
+		close(pair[0]);
+
+		while (waitpid(pid, NULL, 0) < 0 && errno_interrupted());
+
+		return error_code;
+	}
+
+	broker->running = true;
+	broker->uid = uid;
+	broker->gid = gid;
+	broker->pid = pid;
+	broker->socket = pair[0];
+
+	wheel_timer_create(&broker->idle_timer, file_broker_handle_idle, broker);
+
+	log_debug("Started file broker (uid: %u, gid: %u, pid: %u)", uid, gid, pid);
+
+	return API_E_SUCCESS;
+}
+
+static APIE file_broker_get(uint32_t uid, uint32_t gid, FileBroker **broker_) {
+	FileBroker *broker = NULL;
+	APIE error_code;
+	int i;
+
+	for (i = 0; i < FILE_BROKER_MAX_COUNT; ++i) {
+		if (_brokers[i].running && _brokers[i].uid == uid && _brokers[i].gid == gid) {
+			*broker_ = &_brokers[i];
+
+			return API_E_SUCCESS;
+		}
+	}
+
+	// use a free slot, or stop the least recently used broker if all slots
+	// are in use
+	for (i = 0; i < FILE_BROKER_MAX_COUNT; ++i) {
+		if (!_brokers[i].running) {
+			broker = &_brokers[i];
+
+			break;
+		}
+
+		if (broker == NULL || _use_counter - _brokers[i].last_used > _use_counter - broker->last_used) {
+			broker = &_brokers[i];
+		}
+	}
+
+	if (broker->running) {
+		file_broker_stop(broker);
+	}
+
+	error_code = file_broker_start(broker, uid, gid);
+
+	if (error_code != API_E_SUCCESS) {
+		return error_code;
+	}
+
+	*broker_ = broker;
+
+	return API_E_SUCCESS;
+}
+
+// returns -1 if the helper process could not be communicated with. otherwise
+// the error code of the open call is stored in error_code
+static int file_broker_request(FileBroker *broker, const char *name, uint32_t flags,
+                               int oflags, mode_t mode, APIE *error_code, int *fd) {
+	FileBrokerRequest request;
+	struct iovec iovec[2];
+	struct msghdr msghdr;
+	uint8_t status;
+	ssize_t rc;
+
+	request.flags = flags;
+	request.oflags = oflags;
+	request.mode = mode;
+
+	iovec[0].iov_base = &request;
+	iovec[0].iov_len = sizeof(request);
+	iovec[1].iov_base = (void *)name;
+	iovec[1].iov_len = strlen(name) + 1;
+
+	memset(&msghdr, 0, sizeof(msghdr));
+
+	msghdr.msg_iov = iovec;
+	msghdr.msg_iovlen = 2;
+
+	do {
+		rc = sendmsg(broker->socket, &msghdr, MSG_NOSIGNAL);
+	} while (rc < 0 && errno_interrupted());
+
+	if (rc < 0) {
+		return -1;
+	}
+
+	do {
+		rc = recvfd(broker->socket, fd, &status);
+	} while (rc < 0 && errno_interrupted());
+
+	if (rc < 0) {
+		return -1;
+	}
+
+	*error_code = status;
+
+	return 0;
+}
+
+int file_broker_init(void) {
+	int i;
+
+	log_debug("Initializing file broker subsystem");
+
+	for (i = 0; i < FILE_BROKER_MAX_COUNT; ++i) {
+		_brokers[i].running = false;
+	}
+
+	_use_counter = 0;
+
+	return 0;
+}
+
+void file_broker_exit(void) {
+	int i;
+
+	log_debug("Shutting down file broker subsystem");
+
+	for (i = 0; i < FILE_BROKER_MAX_COUNT; ++i) {
+		if (_brokers[i].running) {
+			file_broker_stop(&_brokers[i]);
+		}
+	}
+}
+
+// NOTE: assumes that name is absolute (starts with '/')
+APIE file_broker_open(const char *name, uint32_t flags, int oflags, mode_t mode,
+                      uint32_t uid, uint32_t gid, IOHandle *fd_) {
+	FileBroker *broker;
+	APIE error_code;
+	int fd = -1;
+	int attempt;
+
+	if (strlen(name) >= PATH_MAX) {
+		log_warn("Cannot open file with name length of %d byte(s) as %u:%u, exceeds maximum length",
+		         (int)strlen(name), uid, gid);
+
+		return API_E_NAME_TOO_LONG;
+	}
+
+	for (attempt = 0; ; ++attempt) {
+		error_code = file_broker_get(uid, gid, &broker);
+
+		if (error_code != API_E_SUCCESS) {
+			return error_code;
+		}
+
+		broker->last_used = ++_use_counter;
+
+		if (file_broker_request(broker, name, flags, oflags, mode, &error_code, &fd) >= 0) {
+			break;
+		}
+
+		// the helper process might have been killed. replace it once, but
+		// don't get stuck in a loop if it keeps failing
+		error_code = api_get_error_code_from_errno();
+
+		log_warn("Could not communicate with file broker (uid: %u, gid: %u, pid: %u) for file '%s': %s (%d)",
+		         uid, gid, broker->pid, name, get_errno_name(errno), errno);
+
+		file_broker_stop(broker);
+
+		if (attempt > 0) {
+			return error_code;
+		}
+	}
+
+	// restart the idle timeout. failing to do so only delays the reaping of
+	// the helper process until the next open call or shutdown
+	if (wheel_timer_configure(&broker->idle_timer, FILE_BROKER_IDLE_TIMEOUT, 0) < 0) {
+		log_warn("Could not configure idle timer of file broker (uid: %u, gid: %u, pid: %u): %s (%d)",
+		         uid, gid, broker->pid, get_errno_name(errno), errno);
+	}
+
+	if (error_code != API_E_SUCCESS) {
+		if (fd >= 0) {
+			close(fd);
+		}
+
+		if (error_code == API_E_DOES_NOT_EXIST) {
+			log_debug("Could not open non-existing file '%s'", name);
+		} else if ((flags & (FILE_FLAG_CREATE | FILE_FLAG_EXCLUSIVE)) ==
+		           (FILE_FLAG_CREATE | FILE_FLAG_EXCLUSIVE) && error_code == API_E_ALREADY_EXISTS) {
+			log_debug("Could not exclusively create already existing file '%s'", name);
+		} else {
+			log_error("Could not open file '%s' with flags 0x%04X as %u:%u: %s (%d)",
+			          name, flags, uid, gid, api_get_error_code_name(error_code), error_code);
+		}
+
+		return error_code;
+	}
+
+	// check if FD is invalid after helper process succeeded. this should not
+	// be possible. the check is here just to be on the safe side
+	if (fd < 0) {
+		log_error("File broker opening file '%s' as %u:%u succeeded, but returned an invalid file descriptor",
+		          name, uid, gid);
+
+		return API_E_INTERNAL_ERROR;
+	}
+
+	*fd_ = fd;
+
+	return API_E_SUCCESS;
+}
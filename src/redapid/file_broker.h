@@ -0,0 +1,38 @@
+/*
+ * redapid
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * file_broker.h: Helper processes to open files as other users
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef REDAPID_FILE_BROKER_H
+#define REDAPID_FILE_BROKER_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <daemonlib/io.h>
+
+#include "api_error.h"
+
+int file_broker_init(void);
+void file_broker_exit(void);
+
+APIE file_broker_open(const char *name, uint32_t flags, int oflags, mode_t mode,
+                      uint32_t uid, uint32_t gid, IOHandle *fd);
+
+#endif // REDAPID_FILE_BROKER_H
@@ -38,6 +38,7 @@
 #include <dirent.h>
 #include <errno.h>
 #include <pwd.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -48,113 +49,191 @@
 #include "inventory.h"
 
 #include "api.h"
+#include "directory.h"
+#include "file.h"
+#include "list.h"
+#include "pool.h"
 #include "process.h"
 #include "program.h"
 
 static LogSource _log_source = LOG_SOURCE_INITIALIZER;
 
+/*
+ * every object ID has a slot in the object slot table. an used slot refers to
+ * its object and stores the type of the object and the index of the object in
+ * the object array for its type. this allows to find an object by its ID and
+ * to remove it from its object array in constant time, independent of the
+ * number of objects in the system. only the program and process object arrays
+ * keep their order on removal, because get_programs and get_processes report
+ * the objects in this order. the generation of a slot is increased each time
+ * the slot is released. it tells how often an object ID got reused.
+ */
+
+typedef struct {
+	Object *object; // NULL if slot is unused
+	uint16_t index; // index in the object array for the object type
+	uint16_t generation;
+	uint8_t type;
+} ObjectSlot;
+
+/*
+ * session and object IDs are allocated from an ID bitmap. a set bit in the
+ * used words marks an ID as in use. a set bit in the full words marks the
+ * corresponding used word as full. this allows to skip 1024 used IDs at once
+ * while searching for the next free ID, which keeps the search time bounded
+ * and small, no matter how many IDs are in use.
+ *
+ * IDs are allocated round-robin. the search for the next free ID starts after
+ * the last allocated ID. this avoids reusing an ID right after it got freed,
+ * so an outdated ID held by a client is unlikely to refer to a new object.
+ */
+
+#define ID_BITMAP_USED_WORDS ((UINT16_MAX + 1) / 32)
+#define ID_BITMAP_FULL_WORDS (ID_BITMAP_USED_WORDS / 32)
+
+typedef struct {
+	uint32_t used[ID_BITMAP_USED_WORDS];
+	uint32_t full[ID_BITMAP_FULL_WORDS];
+	uint32_t count; // number of IDs in use
+	uint16_t next; // ID to start the search for the next free ID at
+} IDBitmap;
+
 static char _programs_directory[1024]; // <home>/programs
-static SessionID _next_session_id = 1; // don't use session ID zero
+static IDBitmap _session_ids;
 static Array _sessions;
-static ObjectID _next_object_id = 1; // don't use object ID zero
+static IDBitmap _object_ids;
 static Array _objects[OBJECT_TYPE_PROGRAM - OBJECT_TYPE_STRING + 1];
+static ObjectSlot _object_slots[OBJECT_ID_MAX + 1];
+static Pool _object_pools[OBJECT_TYPE_PROGRAM - OBJECT_TYPE_STRING + 1];
+static Pool _external_reference_pool;
 static Array _stock_strings;
 
-static void inventory_destroy_session(void *item) {
-	Session *session = *(Session **)item;
+static void inventory_mark_id(IDBitmap *bitmap, uint16_t id) {
+	int word = id / 32;
 
-	session_destroy(session);
-}
+	bitmap->used[word] |= 1u << (id % 32);
 
-static void inventory_destroy_object(void *item) {
-	Object *object = *(Object **)item;
+	if (bitmap->used[word] == UINT32_MAX) {
+		bitmap->full[word / 32] |= 1u << (word % 32);
+	}
 
-	object_destroy(object);
+	++bitmap->count;
 }
 
-static void inventory_unlock_and_release_string(void *item) {
-	String *string = *(String **)item;
+static void inventory_init_id_bitmap(IDBitmap *bitmap) {
+	memset(bitmap, 0, sizeof(*bitmap));
 
-	string_unlock_and_release(string);
+	// ID zero is reserved, mark it as used to never hand it out
+	inventory_mark_id(bitmap, 0);
+
+	bitmap->next = 1;
 }
 
-static APIE inventory_get_next_session_id(SessionID *id) {
-	int i;
-	SessionID candidate;
-	bool collision;
+// returns the index of the first non-full used word at or after the given
+// word index, wrapping around at the end. requires that there is at least one
+// non-full used word
+static int inventory_find_non_full_word(IDBitmap *bitmap, int word) {
+	int i = word / 32;
+	uint32_t mask = UINT32_MAX << (word % 32);
 	int k;
-	Session *session;
+	uint32_t candidates;
 
-	// FIXME: this is an O(n^2) algorithm
-	for (i = 0; i < SESSION_ID_MAX; ++i) {
-		if (_next_session_id == SESSION_ID_ZERO) {
-			_next_session_id = 1; // don't use object ID zero
+	// one extra iteration to cover the bits of the start word that were
+	// masked off in the first iteration
+	for (k = 0; k <= ID_BITMAP_FULL_WORDS; ++k) {
+		candidates = ~bitmap->full[i] & mask;
+
+		if (candidates != 0) {
+			return i * 32 + __builtin_ctz(candidates);
 		}
 
-		candidate = _next_session_id++;
-		collision = false;
+		i = (i + 1) % ID_BITMAP_FULL_WORDS;
+		mask = UINT32_MAX;
+	}
 
-		for (k = 0; k < _sessions.count; ++k) {
-			session = *(Session **)array_get(&_sessions, k);
+	return -1; // unreachable if there is a non-full used word
+}
 
-			if (candidate == session->id) {
-				collision = true;
+static bool inventory_acquire_id(IDBitmap *bitmap, uint16_t *id) {
+	int word = bitmap->next / 32;
+	uint32_t candidates;
 
-				break;
-			}
-		}
+	if (bitmap->count > UINT16_MAX) {
+		return false; // all IDs are in use
+	}
 
-		if (!collision) {
-			*id = candidate;
+	// try the remaining IDs in the word of the start ID first
+	candidates = ~bitmap->used[word] & (UINT32_MAX << (bitmap->next % 32));
 
-			return API_E_SUCCESS;
-		}
+	if (candidates == 0) {
+		word = inventory_find_non_full_word(bitmap, (word + 1) % ID_BITMAP_USED_WORDS);
+		candidates = ~bitmap->used[word];
+	}
+
+	*id = word * 32 + __builtin_ctz(candidates);
+
+	inventory_mark_id(bitmap, *id);
+
+	bitmap->next = *id + 1; // wraps around to zero, but zero is always in use
+
+	return true;
+}
+
+static void inventory_release_id(IDBitmap *bitmap, uint16_t id) {
+	int word = id / 32;
+
+	if (id == 0 || (bitmap->used[word] & (1u << (id % 32))) == 0) {
+		return;
 	}
 
-	return API_E_NO_FREE_SESSION_ID;
+	bitmap->used[word] &= ~(1u << (id % 32));
+	bitmap->full[word / 32] &= ~(1u << (word % 32));
+
+	--bitmap->count;
 }
 
-static APIE inventory_get_next_object_id(ObjectID *id) {
-	int i;
-	ObjectID candidate;
-	bool collision;
-	int type;
-	int k;
-	Object *object;
+static void inventory_destroy_session(void *item) {
+	Session *session = *(Session **)item;
 
-	// FIXME: this is an O(n^2) algorithm
-	for (i = 0; i < OBJECT_ID_MAX; ++i) {
-		if (_next_object_id == OBJECT_ID_ZERO) {
-			_next_object_id = 1; // don't use object ID zero
-		}
+	session_destroy(session);
+}
 
-		candidate = _next_object_id++;
-		collision = false;
+static void inventory_release_object_slot(Object *object) {
+	ObjectSlot *slot = &_object_slots[object->id];
 
-		for (type = OBJECT_TYPE_STRING; type <= OBJECT_TYPE_PROGRAM; ++type) {
-			for (k = 0; k < _objects[type].count; ++k) {
-				object = *(Object **)array_get(&_objects[type], k);
+	if (slot->object != object) {
+		return;
+	}
 
-				if (candidate == object->id) {
-					collision = true;
+	slot->object = NULL;
+	slot->index = 0;
 
-					break;
-				}
-			}
+	++slot->generation;
 
-			if (collision) {
-				break;
-			}
-		}
+	inventory_release_id(&_object_ids, object->id);
+}
 
-		if (!collision) {
-			*id = candidate;
+static void inventory_destroy_object(void *item) {
+	Object *object = *(Object **)item;
 
-			return API_E_SUCCESS;
-		}
+	inventory_release_object_slot(object);
+	object_destroy(object);
+}
+
+static void inventory_unlock_and_release_string(void *item) {
+	String *string = *(String **)item;
+
+	string_unlock_and_release(string);
+}
+
+static void inventory_destroy_pools(void) {
+	int type;
+
+	for (type = OBJECT_TYPE_STRING; type <= OBJECT_TYPE_PROGRAM; ++type) {
+		pool_destroy(&_object_pools[type]);
 	}
 
-	return API_E_NO_FREE_OBJECT_ID;
+	pool_destroy(&_external_reference_pool);
 }
 
 int inventory_init(void) {
@@ -182,6 +261,19 @@ int inventory_init(void) {
 		goto cleanup;
 	}
 
+	inventory_init_id_bitmap(&_session_ids);
+	inventory_init_id_bitmap(&_object_ids);
+
+	// create pools. string, list and file objects and external references are
+	// created and destroyed frequently, use larger slabs for them
+	pool_create(&_object_pools[OBJECT_TYPE_STRING], sizeof(String), 64);
+	pool_create(&_object_pools[OBJECT_TYPE_LIST], sizeof(List), 32);
+	pool_create(&_object_pools[OBJECT_TYPE_FILE], sizeof(File), 16);
+	pool_create(&_object_pools[OBJECT_TYPE_DIRECTORY], sizeof(Directory), 4);
+	pool_create(&_object_pools[OBJECT_TYPE_PROCESS], sizeof(Process), 4);
+	pool_create(&_object_pools[OBJECT_TYPE_PROGRAM], sizeof(Program), 4);
+	pool_create(&_external_reference_pool, sizeof(ExternalReference), 64);
+
 	// create session array
 	if (array_create(&_sessions, 32, sizeof(Session *), true) < 0) {
 		log_error("Could not create session array: %s (%d)",
@@ -231,6 +323,10 @@ cleanup:
 		break;
 	}
 
+	if (phase != 3) {
+		inventory_destroy_pools();
+	}
+
 	return phase == 3 ? 0 : -1;
 }
 
@@ -264,6 +360,9 @@ void inventory_exit(void) {
 	array_destroy(&_objects[OBJECT_TYPE_FILE], inventory_destroy_object);
 	array_destroy(&_objects[OBJECT_TYPE_LIST], inventory_destroy_object);
 	array_destroy(&_objects[OBJECT_TYPE_STRING], inventory_destroy_object);
+
+	inventory_log_pool_stats();
+	inventory_destroy_pools();
 }
 
 const char *inventory_get_programs_directory(void) {
@@ -419,12 +518,10 @@ APIE inventory_add_session(Session *session) {
 	Session **session_ptr;
 	APIE error_code;
 
-	error_code = inventory_get_next_session_id(&session->id);
-
-	if (error_code != API_E_SUCCESS) {
+	if (!inventory_acquire_id(&_session_ids, &session->id)) {
 		log_warn("Cannot add new session, all session IDs are in use");
 
-		return error_code;
+		return API_E_NO_FREE_SESSION_ID;
 	}
 
 	session_ptr = array_append(&_sessions);
@@ -435,6 +532,10 @@ APIE inventory_add_session(Session *session) {
 		log_error("Could not append to session array: %s (%d)",
 		          get_errno_name(errno), errno);
 
+		inventory_release_id(&_session_ids, session->id);
+
+		session->id = SESSION_ID_ZERO;
+
 		return error_code;
 	}
 
@@ -458,6 +559,8 @@ void inventory_remove_session(Session *session) {
 
 		log_object_debug("Removing session (id: %u)", session->id);
 
+		inventory_release_id(&_session_ids, session->id);
+
 		array_remove(&_sessions, i, inventory_destroy_session);
 
 		return;
@@ -488,14 +591,13 @@ APIE inventory_get_session(SessionID id, const char *caller, Session **session)
 APIE inventory_add_object(Object *object) {
 	Object **object_ptr;
 	APIE error_code;
+	ObjectSlot *slot;
 
-	error_code = inventory_get_next_object_id(&object->id);
-
-	if (error_code != API_E_SUCCESS) {
+	if (!inventory_acquire_id(&_object_ids, &object->id)) {
 		log_warn("Cannot add new %s object, all object IDs are in use",
 		         object_get_type_name(object->type));
 
-		return error_code;
+		return API_E_NO_FREE_OBJECT_ID;
 	}
 
 	object_ptr = array_append(&_objects[object->type]);
@@ -507,65 +609,82 @@ APIE inventory_add_object(Object *object) {
 		          object_get_type_name(object->type),
 		          get_errno_name(errno), errno);
 
+		inventory_release_id(&_object_ids, object->id);
+
+		object->id = OBJECT_ID_ZERO;
+
 		return error_code;
 	}
 
 	*object_ptr = object;
 
-	log_object_debug("Added %s object (id: %u)",
-	                 object_get_type_name(object->type), object->id);
+	slot = &_object_slots[object->id];
+	slot->object = object;
+	slot->index = _objects[object->type].count - 1;
+	slot->type = object->type;
+
+	log_object_debug("Added %s object (id: %u, generation: %u)",
+	                 object_get_type_name(object->type), object->id,
+	                 slot->generation);
 
 	return API_E_SUCCESS;
 }
 
 void inventory_remove_object(Object *object) {
+	ObjectSlot *slot = &_object_slots[object->id];
+	Array *objects = &_objects[object->type];
+	int index;
+	Object *last;
 	int i;
-	Object *candidate;
-
-	for (i = 0; i < _objects[object->type].count; ++i) {
-		candidate = *(Object **)array_get(&_objects[object->type], i);
-
-		if (candidate != object) {
-			continue;
-		}
-
-		log_object_debug("Removing %s object (id: %u)",
-		                 object_get_type_name(object->type), object->id);
 
-		array_remove(&_objects[object->type], i, inventory_destroy_object);
+	if (object->id == OBJECT_ID_ZERO || slot->object != object) {
+		log_error("Could not find %s object (id: %u) to remove it",
+		          object_get_type_name(object->type), object->id);
 
 		return;
 	}
 
-	log_error("Could not find %s object (id: %u) to remove it",
-	          object_get_type_name(object->type), object->id);
-}
+	log_object_debug("Removing %s object (id: %u)",
+	                 object_get_type_name(object->type), object->id);
 
-APIE inventory_get_object(ObjectType type, ObjectID id, const char *caller, Object **object) {
-	ObjectType start_type;
-	ObjectType end_type;
-	ObjectType t;
-	int i;
-	Object *candidate;
+	index = slot->index;
 
-	if (type == OBJECT_TYPE_ANY) {
-		start_type = OBJECT_TYPE_STRING;
-		end_type = OBJECT_TYPE_PROGRAM;
+	if (object->type == OBJECT_TYPE_PROGRAM || object->type == OBJECT_TYPE_PROCESS) {
+		// keep the order of the object array, clients see it. there are only
+		// few programs and processes, so the linear index update is cheap
+		array_remove(objects, index, NULL);
+
+		for (i = index; i < objects->count; ++i) {
+			_object_slots[(*(Object **)array_get(objects, i))->id].index = i;
+		}
 	} else {
-		start_type = type;
-		end_type = type;
+		// move the last object of the array into the place of the removed
+		// object. this keeps the removal constant time, but changes the order
+		// of the object array. this is okay, because nothing depends on it
+		last = *(Object **)array_get(objects, objects->count - 1);
+
+		if (last != object) {
+			*(Object **)array_get(objects, index) = last;
+			_object_slots[last->id].index = index;
+		}
+
+		array_remove(objects, objects->count - 1, NULL);
 	}
 
-	for (t = start_type; t <= end_type; ++t) {
-		for (i = 0; i < _objects[t].count; ++i) {
-			candidate = *(Object **)array_get(&_objects[t], i);
+	inventory_release_object_slot(object);
+
+	// destroy the object after it was removed from the object array. the
+	// destroy function might remove other objects from the inventory
+	object_destroy(object);
+}
 
-			if (candidate->id == id) {
-				*object = candidate;
+APIE inventory_get_object(ObjectType type, ObjectID id, const char *caller, Object **object) {
+	ObjectSlot *slot = &_object_slots[id];
 
-				return API_E_SUCCESS;
-			}
-		}
+	if (slot->object != NULL && (type == OBJECT_TYPE_ANY || type == slot->type)) {
+		*object = slot->object;
+
+		return API_E_SUCCESS;
 	}
 
 	if (type == OBJECT_TYPE_ANY) {
@@ -589,6 +708,43 @@ void inventory_for_each_object(ObjectType type, InventoryForEachObjectFunction f
 	}
 }
 
+// returns a zeroed object, or NULL and sets errno to ENOMEM on error
+void *inventory_allocate_object(ObjectType type) {
+	return pool_allocate(&_object_pools[type]);
+}
+
+void inventory_free_object(ObjectType type, void *object) {
+	pool_free(&_object_pools[type], object);
+}
+
+// returns a zeroed external reference, or NULL and sets errno to ENOMEM on error
+ExternalReference *inventory_allocate_external_reference(void) {
+	return pool_allocate(&_external_reference_pool);
+}
+
+void inventory_free_external_reference(ExternalReference *external_reference) {
+	pool_free(&_external_reference_pool, external_reference);
+}
+
+static void inventory_log_pool_stats_helper(const char *name, Pool *pool) {
+	log_info("Pool for %s (allocated: %d, free: %d, high-water: %d, slabs: %d, slab-size: %d)",
+	         name, pool->allocated, pool->free, pool->high_water, pool->slab_count,
+	         pool->item_size * pool->items_per_slab);
+}
+
+void inventory_log_pool_stats(void) {
+	int type;
+	char name[64];
+
+	for (type = OBJECT_TYPE_STRING; type <= OBJECT_TYPE_PROGRAM; ++type) {
+		snprintf(name, sizeof(name), "%s objects", object_get_type_name(type));
+
+		inventory_log_pool_stats_helper(name, &_object_pools[type]);
+	}
+
+	inventory_log_pool_stats_helper("external references", &_external_reference_pool);
+}
+
 // public API
 APIE inventory_get_processes(Session *session, ObjectID *processes_id) {
 	List *processes;
@@ -49,6 +49,14 @@ APIE inventory_get_object(ObjectType type, ObjectID id, const char *caller,
 void inventory_for_each_object(ObjectType type, InventoryForEachObjectFunction function,
                                void *opaque);
 
+void *inventory_allocate_object(ObjectType type);
+void inventory_free_object(ObjectType type, void *object);
+
+ExternalReference *inventory_allocate_external_reference(void);
+void inventory_free_external_reference(ExternalReference *external_reference);
+
+void inventory_log_pool_stats(void);
+
 APIE inventory_get_processes(Session *session, ObjectID *processes_id);
 APIE inventory_get_programs(Session *session, ObjectID *programs_id);
 
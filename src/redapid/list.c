@@ -45,7 +45,7 @@ static void list_destroy(Object *object) {
 
 	array_destroy(&list->items, list_unlock_and_release_item);
 
-	free(list);
+	inventory_free_object(OBJECT_TYPE_LIST, list);
 }
 
 static void list_signature(Object *object, char *signature) {
@@ -63,7 +63,7 @@ APIE list_allocate(uint16_t reserve, Session *session,
 	List *list;
 
 	// allocate list object
-	list = calloc(1, sizeof(List));
+	list = inventory_allocate_object(OBJECT_TYPE_LIST);
 
 	if (list == NULL) {
 		error_code = API_E_NO_FREE_MEMORY;
@@ -112,7 +112,7 @@ cleanup:
 		// fall through
 
 	case 1:
-		free(list);
+		inventory_free_object(OBJECT_TYPE_LIST, list);
 		// fall through
 
 	default:
@@ -156,6 +156,59 @@ APIE list_get_item(List *list, uint16_t index, Session *session,
 	return API_E_SUCCESS;
 }
 
+// public API
+APIE list_get_items(List *list, uint16_t index, uint8_t item_count,
+                    Session *session, uint16_t *item_ids, uint8_t *types,
+                    uint8_t *item_count_read) {
+	Object *item;
+	APIE error_code;
+	int i;
+
+	*item_count_read = 0;
+
+	if (item_count > LIST_MAX_GET_ITEMS) {
+		log_warn("Item count of %u exceeds maximum of %d",
+		         item_count, LIST_MAX_GET_ITEMS);
+
+		return API_E_OUT_OF_RANGE;
+	}
+
+	if (index > list->items.count) {
+		log_warn("Index of %u exceeds list object (id: %u) length of %u",
+		         index, list->base.id, list->items.count);
+
+		return API_E_OUT_OF_RANGE;
+	}
+
+	if (item_count > list->items.count - index) {
+		item_count = list->items.count - index;
+	}
+
+	for (i = 0; i < item_count; ++i) {
+		item = *(Object **)array_get(&list->items, index + i);
+		error_code = object_add_external_reference(item, session);
+
+		if (error_code != API_E_SUCCESS) {
+			// undo the external references added so far, to report the
+			// failure as a whole
+			while (--i >= 0) {
+				item = *(Object **)array_get(&list->items, index + i);
+
+				object_remove_external_reference(item, session);
+			}
+
+			return error_code;
+		}
+
+		item_ids[i] = item->id;
+		types[i] = item->type;
+	}
+
+	*item_count_read = item_count;
+
+	return API_E_SUCCESS;
+}
+
 // public API
 APIE list_append_to(List *list, ObjectID item_id) {
 	APIE error_code;
@@ -209,6 +262,35 @@ APIE list_append_to(List *list, ObjectID item_id) {
 	return API_E_SUCCESS;
 }
 
+// public API
+APIE list_append_multiple_to(List *list, uint16_t *item_ids, uint8_t item_count,
+                             uint8_t *appended_count) {
+	APIE error_code;
+	int i;
+
+	*appended_count = 0;
+
+	if (item_count > LIST_MAX_APPEND_ITEMS) {
+		log_warn("Item count of %u exceeds maximum of %d",
+		         item_count, LIST_MAX_APPEND_ITEMS);
+
+		return API_E_OUT_OF_RANGE;
+	}
+
+	// stop at the first error to keep the order of the appended items
+	for (i = 0; i < item_count; ++i) {
+		error_code = list_append_to(list, item_ids[i]);
+
+		if (error_code != API_E_SUCCESS) {
+			return error_code;
+		}
+
+		++*appended_count;
+	}
+
+	return API_E_SUCCESS;
+}
+
 // public API
 APIE list_remove_from(List *list, uint16_t index) {
 	if (list->base.lock_count > 0) {
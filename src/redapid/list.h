@@ -26,6 +26,9 @@
 
 #include "object.h"
 
+#define LIST_MAX_GET_ITEMS 20
+#define LIST_MAX_APPEND_ITEMS 30
+
 typedef struct {
 	Object base;
 
@@ -38,8 +41,13 @@ APIE list_allocate(uint16_t reserve, Session *session,
 APIE list_get_length(List *list, uint16_t *length);
 APIE list_get_item(List *list, uint16_t index, Session *session,
                    ObjectID *item_id, uint8_t *type);
+APIE list_get_items(List *list, uint16_t index, uint8_t item_count,
+                    Session *session, uint16_t *item_ids, uint8_t *types,
+                    uint8_t *item_count_read);
 
 APIE list_append_to(List *list, ObjectID item_id);
+APIE list_append_multiple_to(List *list, uint16_t *item_ids, uint8_t item_count,
+                             uint8_t *appended_count);
 APIE list_remove_from(List *list, uint16_t index);
 
 APIE list_ensure_item_type(List *list, ObjectType type);
@@ -41,10 +41,12 @@
 
 #include "api.h"
 #include "cron.h"
+#include "file_broker.h"
 #include "inventory.h"
 #include "network.h"
 #include "process_monitor.h"
 #include "version.h"
+#include "wheel_timer.h"
 
 static LogSource _log_source = LOG_SOURCE_INITIALIZER;
 
@@ -228,6 +230,10 @@ static void handle_sighup(void) {
 	log_info("Reopened log file '%s'", _log_filename);
 }
 
+static void handle_sigusr1(void) {
+	inventory_log_pool_stats();
+}
+
 int main(int argc, char **argv) {
 	int exit_code = EXIT_FAILURE;
 	int i;
@@ -326,10 +332,14 @@ int main(int argc, char **argv) {
 		goto error_event;
 	}
 
-	if (signal_init(handle_sighup, NULL) < 0) {
+	if (signal_init(handle_sighup, handle_sigusr1) < 0) {
 		goto error_signal;
 	}
 
+	if (wheel_timer_init() < 0) {
+		goto error_wheel_timer;
+	}
+
 	if (process_monitor_init() < 0) {
 		goto error_process_monitor;
 	}
@@ -338,6 +348,10 @@ int main(int argc, char **argv) {
 		goto error_cron;
 	}
 
+	if (file_broker_init() < 0) {
+		goto error_file_broker;
+	}
+
 	if (inventory_init() < 0) {
 		goto error_inventory;
 	}
@@ -376,12 +390,18 @@ error_api:
 	inventory_exit();
 
 error_inventory:
+	file_broker_exit();
+
+error_file_broker:
 	cron_exit();
 
 error_cron:
 	process_monitor_exit();
 
 error_process_monitor:
+	wheel_timer_exit();
+
+error_wheel_timer:
 	signal_exit();
 
 error_signal:
@@ -148,12 +148,12 @@ void object_destroy(Object *object) {
 		session = external_reference->session;
 
 		node_remove(&external_reference->object_node);
-		node_remove(&external_reference->session_node);
+		session_remove_external_reference(session, external_reference);
 
 		object->external_reference_count -= external_reference->count;
 		session->external_reference_count -= external_reference->count;
 
-		free(external_reference);
+		inventory_free_external_reference(external_reference);
 	}
 
 	if (object->lock_count > 0) {
@@ -196,6 +196,46 @@ PacketE object_release_unchecked(Object *object, Session *session) {
 	return object_release(object, session) == API_E_SUCCESS ? PACKET_E_SUCCESS : PACKET_E_UNKNOWN_ERROR;
 }
 
+// public API
+APIE object_release_multiple(uint16_t *object_ids, uint8_t object_count,
+                             Session *session, uint8_t *released_count) {
+	APIE first_error_code = API_E_SUCCESS;
+	APIE error_code;
+	Object *object;
+	int i;
+
+	*released_count = 0;
+
+	if (object_count > OBJECT_MAX_RELEASE_MULTIPLE_IDS) {
+		log_warn("Object count of %u exceeds maximum of %d",
+		         object_count, OBJECT_MAX_RELEASE_MULTIPLE_IDS);
+
+		return API_E_OUT_OF_RANGE;
+	}
+
+	// try to release all given objects, even if releasing one of them fails
+	for (i = 0; i < object_count; ++i) {
+		error_code = inventory_get_object(OBJECT_TYPE_ANY, object_ids[i],
+		                                  "object_release_multiple", &object);
+
+		if (error_code == API_E_SUCCESS) {
+			error_code = object_release(object, session);
+		}
+
+		if (error_code != API_E_SUCCESS) {
+			if (first_error_code == API_E_SUCCESS) {
+				first_error_code = error_code;
+			}
+
+			continue;
+		}
+
+		++*released_count;
+	}
+
+	return first_error_code;
+}
+
 void object_add_internal_reference(Object *object) {
 	log_object_debug("Adding an internal %s object (id: %u) reference (count: %d +1)",
 	                 object_get_type_name(object->type), object->id,
@@ -225,35 +265,30 @@ void object_remove_internal_reference(Object *object) {
 }
 
 APIE object_add_external_reference(Object *object, Session *session) {
-	Node *external_reference_object_node = object->external_reference_sentinel.next;
 	ExternalReference *external_reference;
 	APIE error_code;
 
 	// check if there is already an external reference
-	while (external_reference_object_node != &object->external_reference_sentinel) {
-		external_reference = containerof(external_reference_object_node, ExternalReference, object_node);
-
-		if (external_reference->session == session) {
-			if (object->id != OBJECT_ID_ZERO) {
-				// only log a message if this is not the initial call from
-				// object_create were the object is not fully initialized yet
-				log_object_debug("Adding an external %s object (id: %u) reference (count: %d +1) to session (id: %u)",
-				                 object_get_type_name(object->type), object->id,
-				                 object->external_reference_count, session->id);
-			}
+	external_reference = session_find_external_reference(session, object);
 
-			++external_reference->count;
-			++object->external_reference_count;
-			++session->external_reference_count;
-
-			return API_E_SUCCESS;
+	if (external_reference != NULL) {
+		if (object->id != OBJECT_ID_ZERO) {
+			// only log a message if this is not the initial call from
+			// object_create were the object is not fully initialized yet
+			log_object_debug("Adding an external %s object (id: %u) reference (count: %d +1) to session (id: %u)",
+			                 object_get_type_name(object->type), object->id,
+			                 object->external_reference_count, session->id);
 		}
 
-		external_reference_object_node = external_reference_object_node->next;
+		++external_reference->count;
+		++object->external_reference_count;
+		++session->external_reference_count;
+
+		return API_E_SUCCESS;
 	}
 
 	// create new external reference
-	external_reference = calloc(1, sizeof(ExternalReference));
+	external_reference = inventory_allocate_external_reference();
 
 	if (external_reference == NULL) {
 		error_code = API_E_NO_FREE_MEMORY;
@@ -272,13 +307,12 @@ APIE object_add_external_reference(Object *object, Session *session) {
 		                 object->external_reference_count, session->id);
 	}
 
-	node_insert_before(&object->external_reference_sentinel, &external_reference->object_node);
-	node_insert_before(&session->external_reference_sentinel, &external_reference->session_node);
-
 	external_reference->object = object;
-	external_reference->session = session;
 	external_reference->count = 1;
 
+	node_insert_before(&object->external_reference_sentinel, &external_reference->object_node);
+	session_add_external_reference(session, external_reference);
+
 	++object->external_reference_count;
 	++session->external_reference_count;
 
@@ -286,7 +320,6 @@ APIE object_add_external_reference(Object *object, Session *session) {
 }
 
 void object_remove_external_reference(Object *object, Session *session) {
-	Node *external_reference_object_node;
 	ExternalReference *external_reference;
 
 	if (object->external_reference_count == 0) {
@@ -296,40 +329,34 @@ void object_remove_external_reference(Object *object, Session *session) {
 		return;
 	}
 
-	external_reference_object_node = object->external_reference_sentinel.next;
+	external_reference = session_find_external_reference(session, object);
 
-	while (external_reference_object_node != &object->external_reference_sentinel) {
-		external_reference = containerof(external_reference_object_node, ExternalReference, object_node);
-
-		if (external_reference->session == session) {
-			log_object_debug("Removing an internal %s object (id: %u) reference (count: %d -1) from session (id: %u)",
-			                 object_get_type_name(object->type), object->id,
-			                 object->external_reference_count, session->id);
-
-			--external_reference->count;
-			--object->external_reference_count;
-			--session->external_reference_count;
+	if (external_reference == NULL) {
+		log_error("Could not find external %s object (id: %u) reference in session (id: %u)",
+		          object_get_type_name(object->type), object->id, session->id);
 
-			if (external_reference->count == 0) {
-				node_remove(&external_reference->object_node);
-				node_remove(&external_reference->session_node);
+		return;
+	}
 
-				free(external_reference);
-			}
+	log_object_debug("Removing an internal %s object (id: %u) reference (count: %d -1) from session (id: %u)",
+	                 object_get_type_name(object->type), object->id,
+	                 object->external_reference_count, session->id);
 
-			// destroy object if last reference was removed
-			if (object->internal_reference_count == 0 && object->external_reference_count == 0) {
-				inventory_remove_object(object); // calls object_destroy
-			}
+	--external_reference->count;
+	--object->external_reference_count;
+	--session->external_reference_count;
 
-			return;
-		}
+	if (external_reference->count == 0) {
+		node_remove(&external_reference->object_node);
+		session_remove_external_reference(session, external_reference);
 
-		external_reference_object_node = external_reference_object_node->next;
+		inventory_free_external_reference(external_reference);
 	}
 
-	log_error("Could not find external %s object (id: %u) reference in session (id: %u)",
-	          object_get_type_name(object->type), object->id, session->id);
+	// destroy object if last reference was removed
+	if (object->internal_reference_count == 0 && object->external_reference_count == 0) {
+		inventory_remove_object(object); // calls object_destroy
+	}
 }
 
 void object_lock(Object *object) {
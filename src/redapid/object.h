@@ -37,6 +37,7 @@ typedef uint16_t ObjectID;
 #define OBJECT_ID_MAX UINT16_MAX
 #define OBJECT_ID_ZERO 0
 #define OBJECT_MAX_SIGNATURE_LENGTH 1024
+#define OBJECT_MAX_RELEASE_MULTIPLE_IDS 30
 
 typedef enum {
 	OBJECT_TYPE_ANY = -1,
@@ -82,6 +83,8 @@ void object_log_signature(Object *object);
 
 APIE object_release(Object *object, Session *session);
 PacketE object_release_unchecked(Object *object, Session *session);
+APIE object_release_multiple(uint16_t *object_ids, uint8_t object_count,
+                             Session *session, uint8_t *released_count);
 
 void object_add_internal_reference(Object *object);
 void object_remove_internal_reference(Object *object);
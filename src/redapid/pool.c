@@ -0,0 +1,146 @@
+/*
+ * redapid
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * pool.c: Fixed-size item pool
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * a pool hands out fixed-size items that are carved from larger slabs. freed
+ * items are put on a free list and are reused by the next allocation. slabs
+ * are only returned to the heap when the pool is destroyed. once the pool has
+ * grown to the working set size no further heap allocations are necessary.
+ * this avoids fragmenting the small heap of the RED Brick by the constant
+ * creation and destruction of small objects.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <daemonlib/log.h>
+
+#include "pool.h"
+
+static LogSource _log_source = LOG_SOURCE_INITIALIZER;
+
+// items and slabs are aligned to 8 bytes. this is enough for all types that
+// are stored in pools, because none of them requires a stricter alignment
+#define POOL_ALIGNMENT 8
+#define POOL_ALIGN(size) (((size) + POOL_ALIGNMENT - 1) & ~(POOL_ALIGNMENT - 1))
+#define POOL_SLAB_HEADER_SIZE POOL_ALIGN((int)sizeof(void *))
+
+static int pool_grow(Pool *pool) {
+	char *slab = malloc(POOL_SLAB_HEADER_SIZE + pool->item_size * pool->items_per_slab);
+	char *item;
+	int i;
+
+	if (slab == NULL) {
+		errno = ENOMEM;
+
+		return -1;
+	}
+
+	*(void **)slab = pool->slabs;
+	pool->slabs = slab;
+
+	++pool->slab_count;
+
+	// put items on the free list in reverse order, so they get handed out in
+	// memory order
+	for (i = pool->items_per_slab - 1; i >= 0; --i) {
+		item = slab + POOL_SLAB_HEADER_SIZE + pool->item_size * i;
+
+		*(void **)item = pool->free_items;
+		pool->free_items = item;
+	}
+
+	pool->free += pool->items_per_slab;
+
+	return 0;
+}
+
+void pool_create(Pool *pool, int item_size, int items_per_slab) {
+	if (item_size < (int)sizeof(void *)) {
+		item_size = sizeof(void *); // a free item has to fit the free list link
+	}
+
+	pool->item_size = POOL_ALIGN(item_size);
+	pool->items_per_slab = items_per_slab;
+	pool->free_items = NULL;
+	pool->slabs = NULL;
+	pool->slab_count = 0;
+	pool->allocated = 0;
+	pool->free = 0;
+	pool->high_water = 0;
+}
+
+void pool_destroy(Pool *pool) {
+	void *slab;
+
+	if (pool->allocated > 0) {
+		log_warn("Destroying pool while there are still %d item(s) in use",
+		         pool->allocated);
+	}
+
+	while (pool->slabs != NULL) {
+		slab = pool->slabs;
+		pool->slabs = *(void **)slab;
+
+		free(slab);
+	}
+
+	pool->free_items = NULL;
+	pool->slab_count = 0;
+	pool->allocated = 0;
+	pool->free = 0;
+}
+
+// returns a zeroed item, or NULL and sets errno to ENOMEM on error
+void *pool_allocate(Pool *pool) {
+	void *item;
+
+	if (pool->free_items == NULL && pool_grow(pool) < 0) {
+		return NULL;
+	}
+
+	item = pool->free_items;
+	pool->free_items = *(void **)item;
+
+	--pool->free;
+	++pool->allocated;
+
+	if (pool->allocated > pool->high_water) {
+		pool->high_water = pool->allocated;
+	}
+
+	memset(item, 0, pool->item_size);
+
+	return item;
+}
+
+void pool_free(Pool *pool, void *item) {
+	if (item == NULL) {
+		return;
+	}
+
+	*(void **)item = pool->free_items;
+	pool->free_items = item;
+
+	--pool->allocated;
+	++pool->free;
+}
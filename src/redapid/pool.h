@@ -0,0 +1,42 @@
+/*
+ * redapid
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * pool.h: Fixed-size item pool
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef REDAPID_POOL_H
+#define REDAPID_POOL_H
+
+typedef struct {
+	int item_size;
+	int items_per_slab;
+	void *free_items; // singly linked list of free items
+	void *slabs; // singly linked list of slabs
+	int slab_count;
+	int allocated; // number of items currently in use
+	int free; // number of items currently on the free list
+	int high_water; // maximum number of items in use at the same time
+} Pool;
+
+void pool_create(Pool *pool, int item_size, int items_per_slab);
+void pool_destroy(Pool *pool);
+
+void *pool_allocate(Pool *pool);
+void pool_free(Pool *pool, void *item);
+
+#endif // REDAPID_POOL_H
@@ -119,7 +119,7 @@ static void process_destroy(Object *object) {
 	list_unlock_and_release(process->arguments);
 	string_unlock_and_release(process->executable);
 
-	free(process);
+	inventory_free_object(OBJECT_TYPE_PROCESS, process);
 }
 
 static void process_signature(Object *object, char *signature) {
@@ -748,7 +748,7 @@ APIE process_spawn(ObjectID executable_id, ObjectID arguments_id,
 	}
 
 	// create process object
-	process = calloc(1, sizeof(Process));
+	process = inventory_allocate_object(OBJECT_TYPE_PROCESS);
 
 	if (process == NULL) {
 		error_code = API_E_NO_FREE_MEMORY;
@@ -842,7 +842,7 @@ cleanup:
 		// fall through
 
 	case 12:
-		free(process);
+		inventory_free_object(OBJECT_TYPE_PROCESS, process);
 		// fall through
 
 	case 11:
@@ -28,17 +28,18 @@
 #include <daemonlib/array.h>
 #include <daemonlib/event.h>
 #include <daemonlib/log.h>
-#include <daemonlib/timer.h>
 
 #include "process_monitor.h"
 
+#include "wheel_timer.h"
+
 static LogSource _log_source = LOG_SOURCE_INITIALIZER;
 
 #define SERACH_INTERVAL 2 // seconds
 
 typedef struct {
 	char *cmdline_prefix;
-	Timer timer;
+	WheelTimer timer;
 	uint32_t remaining_timeout; // seconds
 	bool waiting; // == false, matching process was found or timeout occurred
 	Array observers;
@@ -56,7 +57,7 @@ static void process_monitor_destroy_observation(void *item) {
 	}
 
 	if (observation->waiting) {
-		timer_destroy(&observation->timer);
+		wheel_timer_destroy(&observation->timer);
 	}
 
 	array_destroy(&observation->observers, NULL);
@@ -186,7 +187,7 @@ static void process_monitor_update_observation(void *opaque) {
 	ProcessObserver *observer;
 
 	if (!observation->waiting) {
-		timer_destroy(&observation->timer);
+		wheel_timer_destroy(&observation->timer);
 
 		observation->remaining_timeout = 0;
 
@@ -210,7 +211,7 @@ static void process_monitor_update_observation(void *opaque) {
 
 	// if observation finished then inform observers
 	if (!observation->waiting) {
-		timer_destroy(&observation->timer);
+		wheel_timer_destroy(&observation->timer);
 
 		observation->remaining_timeout = 0;
 
@@ -227,7 +228,9 @@ static void process_monitor_update_observation(void *opaque) {
 int process_monitor_init(void) {
 	log_debug("Initializing process monitor subsystem");
 
-	if (array_create(&_observations, 32, sizeof(ProcessObservation), true) < 0) {
+	// observations are not relocatable, because their wheel timers are linked
+	// into the timer wheel and are passed to the timer function by address
+	if (array_create(&_observations, 32, sizeof(ProcessObservation), false) < 0) {
 		log_error("Could not create observation array: %s (%d)",
 		          get_errno_name(errno), errno);
 
@@ -251,7 +254,6 @@ int process_monitor_add_observer(const char *cmdline_prefix,
 	ProcessObservation *observation;
 	ProcessObserver **observer_ptr;
 	int rc;
-	bool timer_created = false;
 
 	// check if there already is an observation for this cmdline prefix
 	for (i = 0; i < _observations.count; ++i) {
@@ -341,21 +343,15 @@ int process_monitor_add_observer(const char *cmdline_prefix,
 		observation->waiting = true;
 
 		// create timer
-		if (timer_create_(&observation->timer,
-		                  process_monitor_update_observation, observation) < 0) {
-			log_error("Could not create observation timer: %s (%d)",
-			          get_errno_name(errno), errno);
+		wheel_timer_create(&observation->timer,
+		                   process_monitor_update_observation, observation);
 
-			goto cleanup;
-		}
-
-		timer_created = true;
 		phase = 4;
 
 		// start timer
-		if (timer_configure(&observation->timer,
-		                    (uint64_t)SERACH_INTERVAL * 1000000,
-		                    (uint64_t)SERACH_INTERVAL * 1000000) < 0) {
+		if (wheel_timer_configure(&observation->timer,
+		                          (uint64_t)SERACH_INTERVAL * 1000000,
+		                          (uint64_t)SERACH_INTERVAL * 1000000) < 0) {
 			log_error("Could not start observation timer: %s (%d)",
 			          get_errno_name(errno), errno);
 
@@ -379,10 +375,7 @@ int process_monitor_add_observer(const char *cmdline_prefix,
 cleanup:
 	switch (phase) { // no breaks, all cases fall through intentionally
 	case 4:
-		if (timer_created) {
-			timer_destroy(&observation->timer);
-		}
-
+		wheel_timer_destroy(&observation->timer);
 		// fall through
 
 	case 3:
@@ -143,7 +143,7 @@ static void program_destroy(Object *object) {
 	string_unlock_and_release(program->identifier);
 	string_unlock_and_release(program->none_message);
 
-	free(program);
+	inventory_free_object(OBJECT_TYPE_PROGRAM, program);
 }
 
 static void program_signature(Object *object, char *signature) {
@@ -223,7 +223,7 @@ APIE program_load(const char *identifier, const char *root_directory,
 	phase = 4;
 
 	// allocate program object
-	program = calloc(1, sizeof(Program));
+	program = inventory_allocate_object(OBJECT_TYPE_PROGRAM);
 
 	if (program == NULL) {
 		error_code = API_E_NO_FREE_MEMORY;
@@ -289,7 +289,7 @@ cleanup:
 		// fall through
 
 	case 5:
-		free(program);
+		inventory_free_object(OBJECT_TYPE_PROGRAM, program);
 		// fall through
 
 	case 4:
@@ -393,7 +393,7 @@ APIE program_define(ObjectID identifier_id, Session *session, ObjectID *id) {
 	phase = 4;
 
 	// allocate program object
-	program = calloc(1, sizeof(Program));
+	program = inventory_allocate_object(OBJECT_TYPE_PROGRAM);
 
 	if (program == NULL) {
 		error_code = API_E_NO_FREE_MEMORY;
@@ -469,7 +469,7 @@ cleanup:
 		// fall through
 
 	case 5:
-		free(program);
+		inventory_free_object(OBJECT_TYPE_PROGRAM, program);
 		// fall through
 
 	case 4:
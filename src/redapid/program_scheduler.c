@@ -146,7 +146,7 @@ static void program_scheduler_handle_process_state_change(void *opaque) {
 		// redapid and brickv is low then sending to many program-process-spawned
 		// callbacks might force brickv into doing nothing else but updating
 		// the last-spawned-program-process information
-		if (timer_configure(&program_scheduler->timer, 1000000, 0) < 0) {
+		if (wheel_timer_configure(&program_scheduler->timer, 1000000, 0) < 0) {
 			program_scheduler_handle_error(program_scheduler, false,
 			                               "Could not start timer: %s (%d)",
 			                               get_errno_name(errno), errno);
@@ -229,8 +229,8 @@ static void program_scheduler_start(ProgramScheduler *program_scheduler) {
 		break;
 
 	case PROGRAM_START_MODE_INTERVAL:
-		if (timer_configure(&program_scheduler->timer, 0,
-		                    (uint64_t)program->config.start_interval * 1000000) < 0) {
+		if (wheel_timer_configure(&program_scheduler->timer, 0,
+		                          (uint64_t)program->config.start_interval * 1000000) < 0) {
 			program_scheduler_handle_error(program_scheduler, false,
 			                               "Could not start timer: %s (%d)",
 			                               get_errno_name(errno), errno);
@@ -286,7 +286,7 @@ static void program_scheduler_stop(ProgramScheduler *program_scheduler,
 	program_scheduler_abort_observer(program_scheduler);
 
 	if (program_scheduler->timer_active) {
-		if (timer_configure(&program_scheduler->timer, 0, 0) < 0) {
+		if (wheel_timer_configure(&program_scheduler->timer, 0, 0) < 0) {
 			recursive = true;
 
 			program_scheduler_handle_error(program_scheduler, false,
@@ -1038,17 +1038,8 @@ APIE program_scheduler_create(ProgramScheduler *program_scheduler,
 		}
 	}
 
-	// FIXME: only create timer for interval mode, otherwise this wastes a
-	//        file descriptor per non-interval scheduler
-	if (timer_create_(&program_scheduler->timer, program_scheduler_handle_timer,
-	                  program_scheduler) < 0) {
-		error_code = api_get_error_code_from_errno();
-
-		log_error("Could not create timer: %s (%d)",
-		          get_errno_name(errno), errno);
-
-		goto cleanup;
-	}
+	wheel_timer_create(&program_scheduler->timer, program_scheduler_handle_timer,
+	                   program_scheduler);
 
 	phase = 4;
 
@@ -1084,7 +1075,7 @@ void program_scheduler_destroy(ProgramScheduler *program_scheduler) {
 		string_unlock_and_release(program_scheduler->message);
 	}
 
-	timer_destroy(&program_scheduler->timer);
+	wheel_timer_destroy(&program_scheduler->timer);
 
 	string_unlock_and_release(program_scheduler->dev_null_file_name);
 	free(program_scheduler->log_directory);
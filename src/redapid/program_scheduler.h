@@ -22,11 +22,10 @@
 #ifndef REDAPID_PROGRAM_SCHEDULER_H
 #define REDAPID_PROGRAM_SCHEDULER_H
 
-#include <daemonlib/timer.h>
-
 #include "process.h"
 #include "process_monitor.h"
 #include "program_config.h"
+#include "wheel_timer.h"
 
 typedef void (*ProgramSchedulerProcessSpawnedFunction)(void *opaque);
 typedef void (*ProgramSchedulerStateChangedFunction)(void *opaque);
@@ -61,7 +60,7 @@ typedef struct {
 	String *dev_null_file_name; // /dev/null
 	ProcessObserver observer;
 	ProcessObserverState observer_state;
-	Timer timer;
+	WheelTimer timer;
 	bool shutdown;
 	bool waiting_for_brickd;
 	bool timer_active;
@@ -21,6 +21,7 @@
 
 #include <errno.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <daemonlib/log.h>
 #include <daemonlib/utils.h>
@@ -31,27 +32,111 @@
 
 static LogSource _log_source = LOG_SOURCE_INITIALIZER;
 
-static void session_remove_external_references(Session *session) {
+/*
+ * each session indexes its external references by object in a hash table.
+ * this allows to find, add and remove the external reference of an object
+ * to a session in constant time, independent of the number of sessions that
+ * reference the object and the number of objects referenced by the session.
+ * the session keeps a list of its external references as well, to be able to
+ * iterate them in order of creation.
+ */
+
+static uint32_t session_hash_object(void *object) {
+	uint32_t hash = (uint32_t)(uintptr_t)object;
+
+	hash ^= hash >> 16;
+	hash *= 0x45D9F3B;
+	hash ^= hash >> 16;
+
+	return hash;
+}
+
+static void session_grow_external_reference_buckets(Session *session) {
+	int bucket_count = session->external_reference_bucket_count * 2;
+	ExternalReference **buckets;
 	ExternalReference *external_reference;
-	Object *object;
+	ExternalReference *next;
+	uint32_t i;
+	int k;
+
+	buckets = calloc(bucket_count, sizeof(ExternalReference *));
 
-	while (session->external_reference_sentinel.next != &session->external_reference_sentinel) {
-		external_reference = containerof(session->external_reference_sentinel.next, ExternalReference, session_node);
+	if (buckets == NULL) {
+		// not fatal, the hash table still works with longer bucket chains
+		log_warn("Could not grow external reference hash table of session (id: %u) to %d bucket(s): %s (%d)",
+		         session->id, bucket_count, get_errno_name(ENOMEM), ENOMEM);
+
+		return;
+	}
+
+	for (k = 0; k < session->external_reference_bucket_count; ++k) {
+		for (external_reference = session->external_reference_buckets[k];
+		     external_reference != NULL; external_reference = next) {
+			next = external_reference->bucket_next;
+			i = session_hash_object(external_reference->object) & (bucket_count - 1);
+
+			external_reference->bucket_next = buckets[i];
+			buckets[i] = external_reference;
+		}
+	}
+
+	free(session->external_reference_buckets);
+
+	session->external_reference_buckets = buckets;
+	session->external_reference_bucket_count = bucket_count;
+}
+
+// removes all external references of the session to objects of the given
+// type, or to all objects if type is OBJECT_TYPE_ANY. returns the number of
+// objects whose external references were removed
+static int session_remove_external_references(Session *session, ObjectType type) {
+	Node *external_reference_session_node = session->external_reference_sentinel.next;
+	ExternalReference *external_reference;
+	Object *object;
+	int count = 0;
+
+	// release all matching external references in one pass. if all external
+	// references are released then the session list and the hash table are
+	// reset as a whole afterwards instead of unlinking each external reference
+	// from them individually
+	while (external_reference_session_node != &session->external_reference_sentinel) {
+		external_reference = containerof(external_reference_session_node, ExternalReference, session_node);
+		external_reference_session_node = external_reference_session_node->next;
 		object = external_reference->object;
 
+		if (type != OBJECT_TYPE_ANY && object->type != type) {
+			continue;
+		}
+
 		node_remove(&external_reference->object_node);
-		node_remove(&external_reference->session_node);
+
+		if (type != OBJECT_TYPE_ANY) {
+			session_remove_external_reference(session, external_reference);
+		}
 
 		object->external_reference_count -= external_reference->count;
 		session->external_reference_count -= external_reference->count;
 
+		inventory_free_external_reference(external_reference);
+
+		++count;
+
 		// destroy object if last reference was removed
 		if (object->internal_reference_count == 0 && object->external_reference_count == 0) {
 			inventory_remove_object(object); // calls object_destroy
 		}
+	}
+
+	if (type == OBJECT_TYPE_ANY) {
+		node_reset(&session->external_reference_sentinel);
 
-		free(external_reference);
+		memset(session->external_reference_buckets, 0,
+		       session->external_reference_bucket_count * sizeof(ExternalReference *));
+
+		session->external_reference_entry_count = 0;
 	}
+
+	return count;
 }
 
 static void session_expire_helper(Session *session) {
@@ -62,7 +147,7 @@ static void session_expire_helper(Session *session) {
 	// by the user or by the expire time. so the external references are released
 	// internationally here and session_destroy will not complain about leaked
 	// external references later when the expired session gets destroyed
-	session_remove_external_references(session);
+	session_remove_external_references(session, OBJECT_TYPE_ANY);
 
 	inventory_remove_session(session); // calls session_destroy
 }
@@ -106,22 +191,30 @@ APIE session_create(uint32_t lifetime, SessionID *id) {
 	// initialize session
 	session->id = SESSION_ID_ZERO;
 	session->external_reference_count = 0;
+	session->external_reference_bucket_count = SESSION_MIN_EXTERNAL_REFERENCE_BUCKETS;
+	session->external_reference_entry_count = 0;
 
 	node_reset(&session->external_reference_sentinel);
 
-	// create expire timer
-	if (timer_create_(&session->timer, session_handle_expire, session) < 0) {
-		error_code = api_get_error_code_from_errno();
+	// allocate external reference hash table
+	session->external_reference_buckets = calloc(session->external_reference_bucket_count,
+	                                             sizeof(ExternalReference *));
 
-		log_error("Could not create session timer: %s (%d)",
-		          get_errno_name(errno), errno);
+	if (session->external_reference_buckets == NULL) {
+		error_code = API_E_NO_FREE_MEMORY;
+
+		log_error("Could not allocate external reference hash table: %s (%d)",
+		          get_errno_name(ENOMEM), ENOMEM);
 
 		goto cleanup;
 	}
 
 	phase = 2;
 
-	if (timer_configure(&session->timer, (uint64_t)lifetime * 1000000, 0) < 0) {
+	// create expire timer
+	wheel_timer_create(&session->timer, session_handle_expire, session);
+
+	if (wheel_timer_configure(&session->timer, (uint64_t)lifetime * 1000000, 0) < 0) {
 		error_code = api_get_error_code_from_errno();
 
 		log_error("Could not start session timer: %s (%d)",
@@ -146,7 +239,8 @@ APIE session_create(uint32_t lifetime, SessionID *id) {
 cleanup:
 	switch (phase) { // no breaks, all cases fall through intentionally
 	case 2:
-		timer_destroy(&session->timer);
+		wheel_timer_destroy(&session->timer);
+		free(session->external_reference_buckets);
 		// fall through
 
 	case 1:
@@ -179,12 +273,64 @@ void session_destroy(Session *session) {
 		}
 	}
 
-	timer_destroy(&session->timer);
-	session_remove_external_references(session);
+	wheel_timer_destroy(&session->timer);
+	session_remove_external_references(session, OBJECT_TYPE_ANY);
 
+	free(session->external_reference_buckets);
 	free(session);
 }
 
+ExternalReference *session_find_external_reference(Session *session, void *object) {
+	uint32_t i = session_hash_object(object) & (session->external_reference_bucket_count - 1);
+	ExternalReference *external_reference = session->external_reference_buckets[i];
+
+	while (external_reference != NULL && external_reference->object != object) {
+		external_reference = external_reference->bucket_next;
+	}
+
+	return external_reference;
+}
+
+// the external reference has to be linked to its object by the caller
+void session_add_external_reference(Session *session, ExternalReference *external_reference) {
+	uint32_t i;
+
+	// keep the average bucket chain length below two
+	if (session->external_reference_entry_count >= session->external_reference_bucket_count * 2) {
+		session_grow_external_reference_buckets(session);
+	}
+
+	i = session_hash_object(external_reference->object) & (session->external_reference_bucket_count - 1);
+
+	external_reference->session = session;
+	external_reference->bucket_next = session->external_reference_buckets[i];
+	session->external_reference_buckets[i] = external_reference;
+
+	node_insert_before(&session->external_reference_sentinel, &external_reference->session_node);
+
+	++session->external_reference_entry_count;
+}
+
+// the external reference has to be unlinked from its object by the caller
+void session_remove_external_reference(Session *session, ExternalReference *external_reference) {
+	uint32_t i = session_hash_object(external_reference->object) & (session->external_reference_bucket_count - 1);
+	ExternalReference **external_reference_ptr = &session->external_reference_buckets[i];
+
+	while (*external_reference_ptr != NULL) {
+		if (*external_reference_ptr == external_reference) {
+			*external_reference_ptr = external_reference->bucket_next;
+
+			break;
+		}
+
+		external_reference_ptr = &(*external_reference_ptr)->bucket_next;
+	}
+
+	node_remove(&external_reference->session_node);
+
+	--session->external_reference_entry_count;
+}
+
 // public API
 APIE session_expire(Session *session) {
 	log_debug("Expiring session (id: %u) before its lifetime would have ended",
@@ -200,6 +346,22 @@ PacketE session_expire_unchecked(Session *session) {
 	return session_expire(session) == API_E_SUCCESS ? PACKET_E_SUCCESS : PACKET_E_UNKNOWN_ERROR;
 }
 
+// public API
+APIE session_expire_objects(Session *session, uint8_t type, uint16_t *object_count) {
+	if (!object_is_valid_type(type)) {
+		log_warn("Invalid object type %u", type);
+
+		return API_E_INVALID_PARAMETER;
+	}
+
+	log_debug("Expiring external references of session (id: %u) to %s objects",
+	          session->id, object_get_type_name(type));
+
+	*object_count = session_remove_external_references(session, type);
+
+	return API_E_SUCCESS;
+}
+
 // public API
 APIE session_keep_alive(Session *session, uint32_t lifetime) {
 	APIE error_code;
@@ -211,7 +373,9 @@ APIE session_keep_alive(Session *session, uint32_t lifetime) {
 		return API_E_OUT_OF_RANGE;
 	}
 
-	if (timer_configure(&session->timer, (uint64_t)lifetime * 1000000, 0) < 0) {
+	// moves the session timer in the timer wheel, the timerfd backing the
+	// timer wheel is typically left untouched
+	if (wheel_timer_configure(&session->timer, (uint64_t)lifetime * 1000000, 0) < 0) {
 		error_code = api_get_error_code_from_errno();
 
 		log_error("Could not configure session timer: %s (%d)",
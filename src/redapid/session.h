@@ -27,10 +27,10 @@
 
 #include <daemonlib/node.h>
 #include <daemonlib/packet.h>
-#include <daemonlib/timer.h>
 #include <daemonlib/utils.h>
 
 #include "api_error.h"
+#include "wheel_timer.h"
 
 typedef uint16_t SessionID;
 
@@ -39,28 +39,40 @@ typedef uint16_t SessionID;
 
 #define SESSION_MAX_LIFETIME 3600 // limit maximum session lifetime to 1 hour
 
+#define SESSION_MIN_EXTERNAL_REFERENCE_BUCKETS 16 // has to be a power of two
+
 typedef struct _Session Session;
+typedef struct _ExternalReference ExternalReference;
 
-typedef struct {
+struct _ExternalReference {
 	Node object_node;
 	Node session_node;
+	ExternalReference *bucket_next; // next entry in the same session bucket
 	void *object;
 	Session *session;
 	int count;
-} ExternalReference;
+};
 
 struct _Session {
 	SessionID id;
-	Timer timer;
+	WheelTimer timer;
 	Node external_reference_sentinel;
-	int external_reference_count;
+	int external_reference_count; // sum of all external reference counts
+	ExternalReference **external_reference_buckets; // indexed by object
+	int external_reference_bucket_count; // always a power of two
+	int external_reference_entry_count; // number of external reference entries
 };
 
 APIE session_create(uint32_t lifetime, SessionID *id);
 void session_destroy(Session *session);
 
+ExternalReference *session_find_external_reference(Session *session, void *object);
+void session_add_external_reference(Session *session, ExternalReference *external_reference);
+void session_remove_external_reference(Session *session, ExternalReference *external_reference);
+
 APIE session_expire(Session *session);
 PacketE session_expire_unchecked(Session *session);
+APIE session_expire_objects(Session *session, uint8_t type, uint16_t *object_count);
 APIE session_keep_alive(Session *session, uint32_t lifetime);
 
 #endif // REDAPID_SESSION_H
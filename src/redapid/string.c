@@ -33,16 +33,27 @@
 
 #include "string.h"
 
+#include "api.h"
+#include "background_job.h"
 #include "inventory.h"
+#include "list.h"
 
 static LogSource _log_source = LOG_SOURCE_INITIALIZER;
 
+struct _StringAsyncRead {
+	String *string;
+	uint32_t offset;
+	BackgroundJob job;
+};
+
 static void string_destroy(Object *object) {
 	String *string = (String *)object;
 
-	free(string->buffer);
+	if (string->buffer != string->inline_buffer) {
+		free(string->buffer);
+	}
 
-	free(string);
+	inventory_free_object(OBJECT_TYPE_STRING, string);
 }
 
 static void string_signature(Object *object, char *signature) {
@@ -52,7 +63,8 @@ static void string_signature(Object *object, char *signature) {
 	         string->length, string->allocated);
 }
 
-static APIE string_reserve(String *string, uint32_t reserve) {
+// makes room for reserve bytes plus NULL-terminator, does not change length
+APIE string_reserve(String *string, uint32_t reserve) {
 	uint32_t allocated;
 	char *buffer;
 
@@ -69,7 +81,16 @@ static APIE string_reserve(String *string, uint32_t reserve) {
 	}
 
 	allocated = GROW_ALLOCATION(reserve);
-	buffer = realloc(string->buffer, allocated);
+
+	if (string->buffer == string->inline_buffer) {
+		buffer = malloc(allocated);
+
+		if (buffer != NULL) {
+			memcpy(buffer, string->buffer, string->length + 1);
+		}
+	} else {
+		buffer = realloc(string->buffer, allocated);
+	}
 
 	if (buffer == NULL) {
 		log_error("Could not reallocate string object (id: %u) buffer to %u bytes: %s (%d)",
@@ -84,6 +105,63 @@ static APIE string_reserve(String *string, uint32_t reserve) {
 	return API_E_SUCCESS;
 }
 
+static void string_send_async_read_callback(String *string, APIE error_code,
+                                            char *buffer, uint8_t length_read) {
+	// only send a async-string-read callback if there is at least one
+	// external reference to the string object. otherwise there is no one that
+	// could be interested in this callback anyway
+	if (string->base.external_reference_count > 0) {
+		api_send_async_string_read_callback(string->base.id, error_code, buffer, length_read);
+	}
+}
+
+static void string_finish_async_read(String *string) {
+	background_job_stop(&string->async_read->job);
+
+	free(string->async_read);
+
+	string->async_read = NULL;
+
+	log_debug("Finished asynchronous reading from string object (id: %u)",
+	          string->base.id);
+
+	string_unlock_and_release(string); // might destroy the string
+}
+
+// sends one chunk per step, to avoid blocking the event loop while streaming
+// long strings. a chunk shorter than STRING_MAX_READ_ASYNC_BUFFER_LENGTH ends
+// the stream
+static void string_handle_async_read(void *opaque) {
+	StringAsyncRead *async_read = opaque;
+	String *string = async_read->string;
+	uint32_t length;
+
+	if (string->base.external_reference_count == 0) {
+		log_debug("Aborting asynchronous reading from string object (id: %u) without external references",
+		          string->base.id);
+
+		string_finish_async_read(string);
+
+		return;
+	}
+
+	length = string->length - async_read->offset;
+
+	if (length > STRING_MAX_READ_ASYNC_BUFFER_LENGTH) {
+		length = STRING_MAX_READ_ASYNC_BUFFER_LENGTH;
+	}
+
+	string_send_async_read_callback(string, API_E_SUCCESS,
+	                                string->buffer + async_read->offset,
+	                                length);
+
+	async_read->offset += length;
+
+	if (length < STRING_MAX_READ_ASYNC_BUFFER_LENGTH) {
+		string_finish_async_read(string);
+	}
+}
+
 static APIE string_create(uint32_t reserve, char *buffer, Session *session,
                           uint32_t object_create_flags, String **string) {
 	int phase = 0;
@@ -101,37 +179,21 @@ static APIE string_create(uint32_t reserve, char *buffer, Session *session,
 
 		++reserve; // one extra byte for the NULL-terminator
 
-		// allocate buffer
 		length = 0;
-		allocated = GROW_ALLOCATION(reserve);
-		buffer = malloc(allocated);
-
-		if (buffer == NULL) {
-			error_code = API_E_NO_FREE_MEMORY;
-
-			log_error("Could not allocate buffer for %u bytes: %s (%d)",
-			          allocated, get_errno_name(ENOMEM), ENOMEM);
-
-			goto cleanup;
-		}
 	} else {
 		length = strlen(buffer);
 
 		if (length > INT32_MAX) {
-			error_code = API_E_OUT_OF_RANGE;
-
 			log_warn("Length of %u bytes exceeds maximum length of string object", length);
 
-			goto cleanup;
+			return API_E_OUT_OF_RANGE;
 		}
 
 		allocated = length + 1;
 	}
 
-	phase = 1;
-
 	// allocate string object
-	*string = calloc(1, sizeof(String));
+	*string = inventory_allocate_object(OBJECT_TYPE_STRING);
 
 	if (*string == NULL) {
 		error_code = API_E_NO_FREE_MEMORY;
@@ -142,12 +204,35 @@ static APIE string_create(uint32_t reserve, char *buffer, Session *session,
 		goto cleanup;
 	}
 
+	phase = 1;
+
+	// allocate buffer, short strings use the inline buffer
+	if (!external) {
+		if (reserve <= STRING_INLINE_BUFFER_LENGTH) {
+			allocated = STRING_INLINE_BUFFER_LENGTH;
+			buffer = (*string)->inline_buffer;
+		} else {
+			allocated = GROW_ALLOCATION(reserve);
+			buffer = malloc(allocated);
+
+			if (buffer == NULL) {
+				error_code = API_E_NO_FREE_MEMORY;
+
+				log_error("Could not allocate buffer for %u bytes: %s (%d)",
+				          allocated, get_errno_name(ENOMEM), ENOMEM);
+
+				goto cleanup;
+			}
+		}
+	}
+
 	phase = 2;
 
 	// create string object
 	(*string)->buffer = buffer;
 	(*string)->length = length;
 	(*string)->allocated = allocated;
+	(*string)->async_read = NULL;
 
 	error_code = object_create(&(*string)->base, OBJECT_TYPE_STRING,
 	                           session, object_create_flags, string_destroy,
@@ -162,16 +247,16 @@ static APIE string_create(uint32_t reserve, char *buffer, Session *session,
 cleanup:
 	switch (phase) { // no breaks, all cases fall through intentionally
 	case 2:
-		free(*string);
-		// fall through
-
-	case 1:
-		if (!external) {
+		if (!external && buffer != (*string)->inline_buffer) {
 			free(buffer);
 		}
 
 		// fall through
 
+	case 1:
+		inventory_free_object(OBJECT_TYPE_STRING, *string);
+		// fall through
+
 	default:
 		break;
 	}
@@ -402,6 +487,151 @@ APIE string_get_chunk(String *string, uint32_t offset, char *buffer) {
 	return API_E_SUCCESS;
 }
 
+// public API
+APIE string_split(String *string, char separator, Session *session,
+                  ObjectID *list_id) {
+	uint32_t count = 0;
+	uint32_t i;
+	List *list;
+	APIE error_code;
+	char *begin;
+	char *end;
+	char *buffer_end = string->buffer + string->length;
+	uint32_t length;
+	String *item;
+
+	// an empty string is split into an empty list, otherwise a string with
+	// N separators is split into N + 1 items, some of them might be empty
+	if (string->length > 0) {
+		count = 1;
+
+		for (i = 0; i < string->length; ++i) {
+			if (string->buffer[i] == separator) {
+				++count;
+			}
+		}
+	}
+
+	if (count > UINT16_MAX) {
+		log_warn("Cannot split string object (id: %u) into %u items, exceeds maximum length of list object",
+		         string->base.id, count);
+
+		return API_E_OUT_OF_RANGE;
+	}
+
+	error_code = list_allocate(count, session, OBJECT_CREATE_FLAG_EXTERNAL,
+	                           NULL, &list);
+
+	if (error_code != API_E_SUCCESS) {
+		return error_code;
+	}
+
+	for (begin = string->buffer, i = 0; i < count; begin = end + 1, ++i) {
+		end = memchr(begin, separator, buffer_end - begin);
+
+		if (end == NULL) {
+			end = buffer_end;
+		}
+
+		length = end - begin;
+		error_code = string_create(length, NULL, NULL, OBJECT_CREATE_FLAG_INTERNAL, &item);
+
+		if (error_code != API_E_SUCCESS) {
+			goto error;
+		}
+
+		memcpy(item->buffer, begin, length);
+
+		item->length = length;
+		item->buffer[item->length] = '\0';
+
+		error_code = list_append_to(list, item->base.id);
+
+		// the list holds its own reference to the item now, if appending
+		// failed then this destroys the item
+		object_remove_internal_reference(&item->base);
+
+		if (error_code != API_E_SUCCESS) {
+			goto error;
+		}
+	}
+
+	log_debug("Split string object (id: %u) into %u item(s)",
+	          string->base.id, count);
+
+	*list_id = list->base.id;
+
+	return API_E_SUCCESS;
+
+error:
+	object_remove_external_reference(&list->base, session);
+
+	return error_code;
+}
+
+// public API
+PacketE string_read_async(String *string, uint32_t offset) {
+	StringAsyncRead *async_read;
+
+	if (offset > string->length) {
+		log_warn("Offset of %u byte(s) exceeds string object (id: %u) length of %u byte(s)",
+		         offset, string->base.id, string->length);
+
+		// FIXME: this callback should be delivered after the response of this function
+		string_send_async_read_callback(string, API_E_OUT_OF_RANGE, NULL, 0);
+
+		return PACKET_E_INVALID_PARAMETER;
+	}
+
+	if (string->async_read != NULL) {
+		log_warn("Still reading from string object (id: %u) asynchronously",
+		         string->base.id);
+
+		// FIXME: this callback should be delivered after the response of this function
+		string_send_async_read_callback(string, API_E_INVALID_OPERATION, NULL, 0);
+
+		return PACKET_E_UNKNOWN_ERROR;
+	}
+
+	async_read = calloc(1, sizeof(StringAsyncRead));
+
+	if (async_read == NULL) {
+		log_error("Could not allocate asynchronous read state for string object (id: %u): %s (%d)",
+		          string->base.id, get_errno_name(ENOMEM), ENOMEM);
+
+		// FIXME: this callback should be delivered after the response of this function
+		string_send_async_read_callback(string, API_E_NO_FREE_MEMORY, NULL, 0);
+
+		return PACKET_E_UNKNOWN_ERROR;
+	}
+
+	async_read->string = string;
+	async_read->offset = offset;
+
+	// sending all chunks here could block the event loop too long. send them
+	// chunk by chunk in a background job instead
+	background_job_create(&async_read->job, string_handle_async_read, async_read);
+
+	if (background_job_start(&async_read->job) < 0) {
+		free(async_read);
+
+		// FIXME: this callback should be delivered after the response of this function
+		string_send_async_read_callback(string, API_E_INTERNAL_ERROR, NULL, 0);
+
+		return PACKET_E_UNKNOWN_ERROR;
+	}
+
+	string->async_read = async_read;
+
+	// keep the string alive and unchanged while reading it asynchronously
+	string_acquire_and_lock(string);
+
+	log_debug("Started reading of %u byte(s) from string object (id: %u) asynchronously",
+	          string->length - offset, string->base.id);
+
+	return PACKET_E_SUCCESS;
+}
+
 APIE string_get(ObjectID id, const char *caller, String **string) {
 	return inventory_get_object(OBJECT_TYPE_STRING, id, caller, (Object **)string);
 }
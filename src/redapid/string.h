@@ -22,18 +22,28 @@
 #ifndef REDAPID_STRING_H
 #define REDAPID_STRING_H
 
+#include <stdbool.h>
+
+#include <daemonlib/packet.h>
+
 #include "object.h"
 
 #define STRING_MAX_ALLOCATE_BUFFER_LENGTH 58
 #define STRING_MAX_SET_CHUNK_BUFFER_LENGTH 58
 #define STRING_MAX_GET_CHUNK_BUFFER_LENGTH 63
+#define STRING_MAX_READ_ASYNC_BUFFER_LENGTH 60
+#define STRING_INLINE_BUFFER_LENGTH 32 // includes NULL-terminator
+
+typedef struct _StringAsyncRead StringAsyncRead;
 
 typedef struct {
 	Object base;
 
-	char *buffer; // is always NULL-terminated
+	char *buffer; // is always NULL-terminated, might point to inline_buffer
 	uint32_t length; // <= INT32_MAX, excludes NULL-terminator
 	uint32_t allocated; // <= INT32_MAX + 1, includes NULL-terminator
+	char inline_buffer[STRING_INLINE_BUFFER_LENGTH]; // avoids a separate buffer allocation for short strings
+	StringAsyncRead *async_read; // only allocated while reading asynchronously
 } String;
 
 APIE string_wrap(const char *buffer, Session *session,
@@ -42,11 +52,16 @@ APIE string_asprintf(Session *session, uint32_t object_create_flags,
                      ObjectID *id, String **object, const char *format, ...) ATTRIBUTE_FMT_PRINTF(5, 6);
 APIE string_allocate(uint32_t reserve, char *buffer, Session *session, ObjectID *id);
 
+APIE string_reserve(String *string, uint32_t reserve);
 APIE string_truncate(String *string, uint32_t length);
 APIE string_get_length(String *string, uint32_t *length);
 
 APIE string_set_chunk(String *string, uint32_t offset, char *buffer);
 APIE string_get_chunk(String *string, uint32_t offset, char *buffer);
+PacketE string_read_async(String *string, uint32_t offset);
+
+APIE string_split(String *string, char separator, Session *session,
+                  ObjectID *list_id);
 
 APIE string_get(ObjectID id, const char *caller, String **string);
 APIE string_get_acquired_and_locked(ObjectID id, const char *caller, String **string);
@@ -0,0 +1,373 @@
+/*
+ * redapid
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * wheel_timer.c: Timer wheel based timers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * all wheel timers are driven by a single hierarchical timer wheel that uses
+ * a single daemonlib timer (one timerfd) for all of them. this avoids the
+ * creation of a file descriptor and an event source per timer. configuring a
+ * wheel timer just moves it between slots of the timer wheel in memory. the
+ * daemonlib timer is only reconfigured if the next tick that has to be
+ * processed moved forward.
+ *
+ * the timer wheel has 4 levels with 64 slots each. a slot in level 0 covers
+ * one tick, a slot in level 1 covers 64 ticks, a slot in level 2 covers 4096
+ * ticks and so on. a timer is put into the lowest level that can hold its
+ * expiration tick. if the timer wheel reaches a slot in level 1 or above then
+ * the timers in this slot are cascaded down into the lower levels. timers
+ * that expire beyond the range of the timer wheel are put into the last slot
+ * of the highest level and get cascaded again until they are in range.
+ */
+
+#include <errno.h>
+#include <time.h>
+
+#include <daemonlib/log.h>
+#include <daemonlib/timer.h>
+#include <daemonlib/utils.h>
+
+#include "wheel_timer.h"
+
+static LogSource _log_source = LOG_SOURCE_INITIALIZER;
+
+#define WHEEL_TIMER_TICK_LENGTH 10000 // microseconds
+#define WHEEL_TIMER_LEVEL_BITS 6
+#define WHEEL_TIMER_LEVEL_SLOTS (1 << WHEEL_TIMER_LEVEL_BITS)
+#define WHEEL_TIMER_LEVEL_MASK (WHEEL_TIMER_LEVEL_SLOTS - 1)
+#define WHEEL_TIMER_LEVELS 4
+#define WHEEL_TIMER_MAX_DELTA (((uint64_t)1 << (WHEEL_TIMER_LEVEL_BITS * WHEEL_TIMER_LEVELS)) - 1) // ticks
+
+static Timer _timer;
+static Node _slots[WHEEL_TIMER_LEVELS][WHEEL_TIMER_LEVEL_SLOTS];
+static uint64_t _occupied[WHEEL_TIMER_LEVELS]; // bit set = slot is not empty
+static uint64_t _tick; // next tick to be processed
+static uint64_t _armed_tick = UINT64_MAX; // tick the daemonlib timer is armed for
+static int _active_count;
+
+static uint64_t wheel_timer_get_current_tick(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ((uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000) / WHEEL_TIMER_TICK_LENGTH;
+}
+
+// returns the tick at which the timer wheel reaches the slot the timer got
+// inserted into
+static uint64_t wheel_timer_insert(WheelTimer *timer) {
+	uint64_t expires = timer->expires;
+	uint64_t delta;
+	int level;
+
+	if (expires < _tick) {
+		expires = _tick;
+		timer->expires = expires;
+	}
+
+	delta = expires - _tick;
+
+	if (delta > WHEEL_TIMER_MAX_DELTA) {
+		expires = _tick + WHEEL_TIMER_MAX_DELTA; // will be cascaded again
+		delta = WHEEL_TIMER_MAX_DELTA;
+	}
+
+	for (level = 0; level < WHEEL_TIMER_LEVELS - 1; ++level) {
+		if (delta < ((uint64_t)1 << (WHEEL_TIMER_LEVEL_BITS * (level + 1)))) {
+			break;
+		}
+	}
+
+	timer->level = level;
+	timer->slot = (expires >> (WHEEL_TIMER_LEVEL_BITS * level)) & WHEEL_TIMER_LEVEL_MASK;
+
+	node_insert_before(&_slots[level][timer->slot], &timer->node);
+
+	_occupied[level] |= (uint64_t)1 << timer->slot;
+
+	return expires & ~(((uint64_t)1 << (WHEEL_TIMER_LEVEL_BITS * level)) - 1);
+}
+
+static void wheel_timer_remove(WheelTimer *timer) {
+	node_remove(&timer->node);
+
+	if (_slots[timer->level][timer->slot].next == &_slots[timer->level][timer->slot]) {
+		_occupied[timer->level] &= ~((uint64_t)1 << timer->slot);
+	}
+}
+
+// returns the next tick at which a slot has to be processed or cascaded, or
+// UINT64_MAX if the timer wheel is empty
+static uint64_t wheel_timer_get_next_tick(void) {
+	uint64_t next_tick = UINT64_MAX;
+	uint64_t span;
+	uint64_t tick;
+	int level;
+	int k;
+
+	for (level = 0; level < WHEEL_TIMER_LEVELS; ++level) {
+		if (_occupied[level] == 0) {
+			continue;
+		}
+
+		span = (uint64_t)1 << (WHEEL_TIMER_LEVEL_BITS * level);
+		tick = (_tick + span - 1) & ~(span - 1);
+
+		for (k = 0; k < WHEEL_TIMER_LEVEL_SLOTS && tick < next_tick; ++k, tick += span) {
+			if ((_occupied[level] & ((uint64_t)1 << ((tick / span) & WHEEL_TIMER_LEVEL_MASK))) != 0) {
+				next_tick = tick;
+
+				break;
+			}
+		}
+	}
+
+	return next_tick;
+}
+
+static int wheel_timer_arm(void) {
+	uint64_t next_tick = wheel_timer_get_next_tick();
+	uint64_t current_tick;
+	uint64_t delay;
+
+	if (next_tick == _armed_tick) {
+		return 0;
+	}
+
+	if (next_tick == UINT64_MAX) {
+		delay = 0; // disarm
+	} else {
+		current_tick = wheel_timer_get_current_tick();
+
+		if (next_tick > current_tick) {
+			delay = (next_tick - current_tick) * WHEEL_TIMER_TICK_LENGTH;
+		} else {
+			delay = 1; // as soon as possible, zero would disarm
+		}
+	}
+
+	if (timer_configure(&_timer, delay, 0) < 0) {
+		log_error("Could not configure timer wheel timer: %s (%d)",
+		          get_errno_name(errno), errno);
+
+		_armed_tick = UINT64_MAX;
+
+		return -1;
+	}
+
+	_armed_tick = next_tick;
+
+	return 0;
+}
+
+static void wheel_timer_cascade(int level, uint64_t tick) {
+	int slot = (tick >> (WHEEL_TIMER_LEVEL_BITS * level)) & WHEEL_TIMER_LEVEL_MASK;
+	Node *sentinel = &_slots[level][slot];
+	WheelTimer *timer;
+
+	while (sentinel->next != sentinel) {
+		timer = containerof(sentinel->next, WheelTimer, node);
+
+		wheel_timer_remove(timer);
+		wheel_timer_insert(timer);
+	}
+}
+
+static void wheel_timer_process_tick(uint64_t tick) {
+	Node pending;
+	Node *sentinel;
+	WheelTimer *timer;
+	int level;
+	int slot = tick & WHEEL_TIMER_LEVEL_MASK;
+
+	_tick = tick;
+
+	// cascade higher level slots down, if the lower level wrapped around
+	for (level = 1; level < WHEEL_TIMER_LEVELS; ++level) {
+		if ((tick & (((uint64_t)1 << (WHEEL_TIMER_LEVEL_BITS * level)) - 1)) != 0) {
+			break;
+		}
+
+		wheel_timer_cascade(level, tick);
+	}
+
+	// move expired timers to a pending list. timers (re)configured by the
+	// expired timer functions are inserted relative to the following tick
+	sentinel = &_slots[0][slot];
+
+	node_reset(&pending);
+
+	if (sentinel->next != sentinel) {
+		pending.next = sentinel->next;
+		pending.prev = sentinel->prev;
+		pending.next->prev = &pending;
+		pending.prev->next = &pending;
+
+		node_reset(sentinel);
+	}
+
+	_occupied[0] &= ~((uint64_t)1 << slot);
+	_tick = tick + 1;
+
+	// a timer function might stop other pending timers, always take the
+	// first one from the pending list
+	while (pending.next != &pending) {
+		timer = containerof(pending.next, WheelTimer, node);
+
+		node_remove(&timer->node);
+
+		if (timer->interval > 0) {
+			timer->expires = tick + timer->interval;
+
+			wheel_timer_insert(timer);
+		} else {
+			timer->active = false;
+			--_active_count;
+		}
+
+		timer->function(timer->opaque);
+	}
+}
+
+static void wheel_timer_handle_timer(void *opaque) {
+	uint64_t current_tick = wheel_timer_get_current_tick();
+	uint64_t next_tick;
+
+	(void)opaque;
+
+	_armed_tick = UINT64_MAX; // the daemonlib timer is a one-shot timer
+
+	for (;;) {
+		// skip ticks without work
+		next_tick = wheel_timer_get_next_tick();
+
+		if (next_tick > current_tick) {
+			if (_active_count == 0) {
+				_tick = current_tick + 1;
+			}
+
+			break;
+		}
+
+		wheel_timer_process_tick(next_tick);
+	}
+
+	wheel_timer_arm();
+}
+
+int wheel_timer_init(void) {
+	int level;
+	int slot;
+
+	log_debug("Initializing wheel timer subsystem");
+
+	for (level = 0; level < WHEEL_TIMER_LEVELS; ++level) {
+		for (slot = 0; slot < WHEEL_TIMER_LEVEL_SLOTS; ++slot) {
+			node_reset(&_slots[level][slot]);
+		}
+
+		_occupied[level] = 0;
+	}
+
+	_tick = wheel_timer_get_current_tick();
+	_armed_tick = UINT64_MAX;
+	_active_count = 0;
+
+	if (timer_create_(&_timer, wheel_timer_handle_timer, NULL) < 0) {
+		log_error("Could not create timer wheel timer: %s (%d)",
+		          get_errno_name(errno), errno);
+
+		return -1;
+	}
+
+	return 0;
+}
+
+void wheel_timer_exit(void) {
+	log_debug("Shutting down wheel timer subsystem");
+
+	if (_active_count > 0) {
+		log_warn("Shutting down wheel timer subsystem while %d timer(s) are still active",
+		         _active_count);
+	}
+
+	timer_destroy(&_timer);
+}
+
+void wheel_timer_create(WheelTimer *timer, WheelTimerFunction function, void *opaque) {
+	node_reset(&timer->node);
+
+	timer->active = false;
+	timer->level = 0;
+	timer->slot = 0;
+	timer->expires = 0;
+	timer->interval = 0;
+	timer->function = function;
+	timer->opaque = opaque;
+}
+
+void wheel_timer_destroy(WheelTimer *timer) {
+	if (timer->active) {
+		wheel_timer_remove(timer);
+
+		timer->active = false;
+		--_active_count;
+	}
+}
+
+// a zero delay and a zero interval stop the timer. a zero delay and a non-zero
+// interval start the timer with its first expiration as soon as possible
+int wheel_timer_configure(WheelTimer *timer, uint64_t delay, uint64_t interval) {
+	uint64_t current_tick;
+	uint64_t trigger_tick;
+
+	if (timer->active) {
+		wheel_timer_remove(timer);
+
+		timer->active = false;
+		--_active_count;
+	}
+
+	if (delay == 0 && interval == 0) {
+		return 0; // don't bother disarming the daemonlib timer, it'll just find nothing to do
+	}
+
+	current_tick = wheel_timer_get_current_tick();
+
+	if (_active_count == 0) {
+		_tick = current_tick; // nothing to process in between, skip ahead
+	}
+
+	timer->expires = current_tick + (delay + WHEEL_TIMER_TICK_LENGTH - 1) / WHEEL_TIMER_TICK_LENGTH;
+	timer->interval = (interval + WHEEL_TIMER_TICK_LENGTH - 1) / WHEEL_TIMER_TICK_LENGTH;
+
+	trigger_tick = wheel_timer_insert(timer);
+
+	timer->active = true;
+	++_active_count;
+
+	// only reconfigure the daemonlib timer if this timer has to be processed
+	// before the tick the daemonlib timer is currently armed for. this makes
+	// extending the delay of a timer a pure in-memory operation
+	if (trigger_tick < _armed_tick) {
+		return wheel_timer_arm();
+	}
+
+	return 0;
+}
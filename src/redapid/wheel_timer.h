@@ -0,0 +1,51 @@
+/*
+ * redapid
+ * Copyright (C) 2026 Matthias Bolte <matthias@tinkerforge.com>
+ *
+ * wheel_timer.h: Timer wheel based timers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef REDAPID_WHEEL_TIMER_H
+#define REDAPID_WHEEL_TIMER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <daemonlib/node.h>
+
+typedef void (*WheelTimerFunction)(void *opaque);
+
+typedef struct {
+	Node node; // in the slot list of the timer wheel, if active
+	bool active;
+	uint8_t level;
+	uint8_t slot;
+	uint64_t expires; // tick
+	uint64_t interval; // ticks, zero for a one-shot timer
+	WheelTimerFunction function;
+	void *opaque;
+} WheelTimer;
+
+int wheel_timer_init(void);
+void wheel_timer_exit(void);
+
+void wheel_timer_create(WheelTimer *timer, WheelTimerFunction function, void *opaque);
+void wheel_timer_destroy(WheelTimer *timer);
+
+int wheel_timer_configure(WheelTimer *timer, uint64_t delay, uint64_t interval); // microseconds
+
+#endif // REDAPID_WHEEL_TIMER_H
@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <time.h>
+#include <sys/time.h>
+
+#include "ip_connection.h"
+#include "brick_red.h"
+
+#define HOST "localhost"
+#define PORT 4223
+#define UID "3hG6BK" // Change to your UID
+
+#include "utils.c"
+
+#define LOOKUPS 1000
+
+// measures the time for a get_string_length call depending on the number of
+// live objects. get_string_length does nothing but an object lookup, so the
+// time per call should stay flat independent of the number of live objects
+int main() {
+	uint8_t ec;
+	int rc;
+	int counts[] = { 10, 100, 1000, 10000, 30000, 60000 };
+	int live = 0;
+	uint16_t first_sid = 0;
+	uint16_t sid;
+	uint32_t length;
+	int i;
+	int k;
+
+	// Create IP connection
+	IPConnection ipcon;
+	ipcon_create(&ipcon);
+
+	// Create device object
+	RED red;
+	red_create(&red, UID, &ipcon);
+
+	// Connect to brickd
+	rc = ipcon_connect(&ipcon, HOST, PORT);
+	if (rc < 0) {
+		printf("ipcon_connect -> rc %d\n", rc);
+		return -1;
+	}
+
+	uint16_t session_id;
+	if (create_session(&red, 3600, &session_id) < 0) {
+		return -1;
+	}
+
+	for (i = 0; i < (int)(sizeof(counts) / sizeof(counts[0])); ++i) {
+		while (live < counts[i]) {
+			rc = red_allocate_string(&red, 0, "", session_id, &ec, &sid);
+			if (rc < 0) {
+				printf("red_allocate_string -> rc %d\n", rc);
+				goto cleanup;
+			}
+			if (ec != 0) {
+				printf("red_allocate_string -> ec %u\n", ec);
+				goto cleanup;
+			}
+
+			if (live == 0) {
+				first_sid = sid;
+			}
+
+			++live;
+		}
+
+		// look up the oldest and the newest object alternately
+		uint64_t st = microseconds();
+
+		for (k = 0; k < LOOKUPS; ++k) {
+			rc = red_get_string_length(&red, k % 2 == 0 ? first_sid : sid, &ec, &length);
+			if (rc < 0) {
+				printf("red_get_string_length -> rc %d\n", rc);
+				goto cleanup;
+			}
+			if (ec != 0) {
+				printf("red_get_string_length -> ec %u\n", ec);
+				goto cleanup;
+			}
+		}
+
+		uint64_t et = microseconds();
+
+		printf("%d live objects: %d lookups in %f sec, %f usec per lookup\n",
+		       live, LOOKUPS, (et - st) / 1000000.0, (float)(et - st) / LOOKUPS);
+	}
+
+cleanup:
+	// expiring the session releases all allocated string objects
+	expire_session(&red, session_id);
+
+	red_destroy(&red);
+	ipcon_destroy(&ipcon);
+
+	return 0;
+}
@@ -0,0 +1,104 @@
+#include <stdio.h>
+#include <time.h>
+#include <sys/time.h>
+
+#include "ip_connection.h"
+#include "brick_red.h"
+
+#define HOST "localhost"
+#define PORT 4223
+#define UID "3hG6BK" // Change to your UID
+
+#include "utils.c"
+
+// redapid runs as root, opening as root is a plain open call. opening as the
+// default RED Brick user goes through a file broker helper process, older
+// redapid versions forked a child process per open call instead. to compare
+// both, run this once against each redapid version with a matching label:
+//
+//   ./a.out fork    # redapid before the file broker
+//   ./a.out broker  # redapid with the file broker
+#define OPEN_COUNT 500
+
+RED red;
+
+int run(const char *label, const char *name, uint16_t sid, uint32_t uid, uint32_t gid, uint16_t session_id) {
+	uint8_t ec;
+	uint16_t fid;
+	uint64_t st, et;
+	float dur;
+	int rc;
+	int i;
+
+	st = microseconds();
+
+	for (i = 0; i < OPEN_COUNT; ++i) {
+		rc = red_open_file(&red, sid, RED_FILE_FLAG_READ_ONLY, 0, uid, gid, session_id, &ec, &fid);
+		if (rc < 0) {
+			printf("red_open_file -> rc %d\n", rc);
+			return -1;
+		}
+		if (ec != 0) {
+			printf("red_open_file -> ec %u\n", ec);
+			return -1;
+		}
+
+		if (release_object(&red, fid, session_id, "file") < 0) {
+			return -1;
+		}
+	}
+
+	et = microseconds();
+	dur = (et - st) / 1000000.0;
+
+	printf("%s, %s: %d opens in %f sec, %f opens/s\n", label, name, OPEN_COUNT, dur, OPEN_COUNT / dur);
+
+	return 0;
+}
+
+int main(int argc, char **argv) {
+	int rc;
+
+	if (argc != 2) {
+		printf("usage: %s <fork|broker>\n", argv[0]);
+
+		return -1;
+	}
+
+	// Create IP connection
+	IPConnection ipcon;
+	ipcon_create(&ipcon);
+
+	// Create device object
+	red_create(&red, UID, &ipcon);
+
+	// Connect to brickd
+	rc = ipcon_connect(&ipcon, HOST, PORT);
+	if (rc < 0) {
+		printf("ipcon_connect -> rc %d\n", rc);
+		return -1;
+	}
+
+	uint16_t session_id;
+	if (create_session(&red, 60, &session_id) < 0) {
+		return -1;
+	}
+
+	uint16_t sid;
+	if (allocate_string(&red, "/etc/hostname", session_id, &sid)) {
+		goto expire;
+	}
+
+	run(argv[1], "open as 0:0", sid, 0, 0, session_id);
+	run(argv[1], "open as 1000:1000", sid, 1000, 1000, session_id);
+
+	release_object(&red, sid, session_id, "string");
+
+expire:
+	expire_session(&red, session_id);
+
+	red_destroy(&red);
+	ipcon_destroy(&ipcon);
+
+	return 0;
+}
@@ -0,0 +1,226 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#define IPCON_EXPOSE_INTERNALS
+
+#include "ip_connection.h"
+#include "brick_red.h"
+
+#define HOST "localhost"
+#define PORT 4223
+#define UID "3hG6BK" // Change to your UID
+
+#include "utils.c"
+
+// not part of the generated bindings yet
+#define FUNCTION_READ_FILE_ASYNC_WITH_CREDIT 76
+#define FUNCTION_GRANT_ASYNC_FILE_READ_CREDIT 77
+
+#define CREDIT_WINDOW 256
+
+#if defined _MSC_VER || defined __BORLANDC__
+	#pragma pack(push)
+	#pragma pack(1)
+	#define ATTRIBUTE_PACKED
+#elif defined __GNUC__
+	#define ATTRIBUTE_PACKED __attribute__((packed))
+#else
+	#error unknown compiler, do not know how to enable struct packing
+#endif
+
+typedef struct {
+	PacketHeader header;
+	uint16_t file_id;
+	uint64_t length_to_read;
+	uint16_t credit;
+} ATTRIBUTE_PACKED ReadFileAsyncWithCredit_;
+
+typedef struct {
+	PacketHeader header;
+	uint16_t file_id;
+	uint16_t credit;
+} ATTRIBUTE_PACKED GrantAsyncFileReadCredit_;
+
+#if defined _MSC_VER || defined __BORLANDC__
+	#pragma pack(pop)
+#endif
+#undef ATTRIBUTE_PACKED
+
+uint64_t length_to_read = 5 * 1024 * 1024;
+volatile uint64_t total_length_read = 0;
+volatile int done = 0;
+volatile int credit_mode = 0;
+int callbacks_since_grant = 0;
+RED red;
+uint16_t fid;
+
+int read_file_async_with_credit(RED *red, uint16_t file_id, uint64_t length_to_read, uint16_t credit) {
+	DevicePrivate *device_p = red->p;
+	ReadFileAsyncWithCredit_ request;
+	int ret;
+
+	ret = packet_header_create(&request.header, sizeof(request), FUNCTION_READ_FILE_ASYNC_WITH_CREDIT, device_p->ipcon_p, device_p);
+
+	if (ret < 0) {
+		return ret;
+	}
+
+	request.file_id = leconvert_uint16_to(file_id);
+	request.length_to_read = leconvert_uint64_to(length_to_read);
+	request.credit = leconvert_uint16_to(credit);
+
+	return device_send_request(device_p, (Packet *)&request, NULL);
+}
+
+int grant_async_file_read_credit(RED *red, uint16_t file_id, uint16_t credit) {
+	DevicePrivate *device_p = red->p;
+	GrantAsyncFileReadCredit_ request;
+	int ret;
+
+	ret = packet_header_create(&request.header, sizeof(request), FUNCTION_GRANT_ASYNC_FILE_READ_CREDIT, device_p->ipcon_p, device_p);
+
+	if (ret < 0) {
+		return ret;
+	}
+
+	request.file_id = leconvert_uint16_to(file_id);
+	request.credit = leconvert_uint16_to(credit);
+
+	return device_send_request(device_p, (Packet *)&request, NULL);
+}
+
+void async_file_read(uint16_t file_id, uint8_t error_code, uint8_t *buffer, uint8_t length_read, void *user_data) {
+	(void)file_id;
+	(void)buffer;
+	(void)user_data;
+
+	if (error_code != 0) {
+		printf("async_file_read -> ec %u\n", error_code);
+		done = 1;
+		return;
+	}
+
+	total_length_read += length_read;
+
+	if (length_read == 0 || total_length_read >= length_to_read) {
+		done = 1;
+		return;
+	}
+
+	// refill the credit window when half of it is used up
+	if (credit_mode && ++callbacks_since_grant >= CREDIT_WINDOW / 2) {
+		int rc = grant_async_file_read_credit(&red, fid, callbacks_since_grant);
+		if (rc < 0) {
+			printf("grant_async_file_read_credit -> rc %d\n", rc);
+		}
+
+		callbacks_since_grant = 0;
+	}
+}
+
+int run(const char *name, int with_credit) {
+	uint8_t ec;
+	uint64_t position;
+	uint64_t st, et;
+	float dur;
+	int rc;
+
+	rc = red_set_file_position(&red, fid, 0, RED_FILE_ORIGIN_BEGINNING, &ec, &position);
+	if (rc < 0 || ec != 0) {
+		printf("red_set_file_position -> rc %d, ec %u\n", rc, ec);
+		return -1;
+	}
+
+	total_length_read = 0;
+	done = 0;
+	credit_mode = with_credit;
+	callbacks_since_grant = 0;
+
+	st = microseconds();
+
+	if (with_credit) {
+		rc = read_file_async_with_credit(&red, fid, length_to_read, CREDIT_WINDOW);
+	} else {
+		rc = red_read_file_async(&red, fid, length_to_read);
+	}
+
+	if (rc < 0) {
+		printf("%s -> rc %d\n", name, rc);
+		return -1;
+	}
+
+	while (!done) {
+		usleep(1000);
+	}
+
+	et = microseconds();
+	dur = (et - st) / 1000000.0;
+
+	printf("%s: %lu bytes in %f sec, %f kB/s\n", name, (unsigned long)total_length_read, dur, total_length_read / dur / 1024);
+
+	return 0;
+}
+
+int main() {
+	uint8_t ec;
+	int rc;
+
+	// Create IP connection
+	IPConnection ipcon;
+	ipcon_create(&ipcon);
+
+	// Create device object
+	red_create(&red, UID, &ipcon);
+
+	red.p->response_expected[FUNCTION_READ_FILE_ASYNC_WITH_CREDIT] = DEVICE_RESPONSE_EXPECTED_FALSE;
+	red.p->response_expected[FUNCTION_GRANT_ASYNC_FILE_READ_CREDIT] = DEVICE_RESPONSE_EXPECTED_FALSE;
+
+	// Connect to brickd
+	rc = ipcon_connect(&ipcon, HOST, PORT);
+	if (rc < 0) {
+		printf("ipcon_connect -> rc %d\n", rc);
+		return -1;
+	}
+
+	uint16_t session_id;
+	if (create_session(&red, 60, &session_id) < 0) {
+		return -1;
+	}
+
+	uint16_t sid;
+	if (allocate_string(&red, "/tmp/foobar_fast", session_id, &sid)) {
+		goto expire;
+	}
+
+	rc = red_open_file(&red, sid, RED_FILE_FLAG_READ_ONLY | RED_FILE_FLAG_NON_BLOCKING, 0, 0, 0, session_id, &ec, &fid);
+	if (rc < 0) {
+		printf("red_open_file -> rc %d\n", rc);
+		goto cleanup;
+	}
+	if (ec != 0) {
+		printf("red_open_file -> ec %u\n", ec);
+		goto cleanup;
+	}
+	printf("red_open_file -> fid %u\n", fid);
+
+	red_register_callback(&red, RED_CALLBACK_ASYNC_FILE_READ, async_file_read, NULL);
+
+	run("red_read_file_async", 0);
+	run("read_file_async_with_credit", 1);
+
+	release_object(&red, fid, session_id, "file");
+
+cleanup:
+	release_object(&red, sid, session_id, "string");
+
+expire:
+	expire_session(&red, session_id);
+
+	red_destroy(&red);
+	ipcon_destroy(&ipcon);
+
+	return 0;
+}